@@ -0,0 +1,322 @@
+/**
+ AiffLoader.cpp
+ Virtual Keyboard
+ Implementation of AiffLoader.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 5/4/2018
+ */
+
+#include "AiffLoader.hpp"
+#include <chrono>
+#include <iomanip>
+#include <math.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define AIFF_USE_SSSE3
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define AIFF_USE_SSE2
+#endif
+
+//--------------------------------------------------------------------------
+/**
+ Loads an AIFF file into a chunk in the format SDL Mixer is
+ playing (which must be open). Only 16-bit samples at the
+ mixer's rate are made, from a file with as many channels as
+ the mixer or from a mono file (copied to both channels).
+ 
+ @param path The path of the file.
+ @return The chunk (freed with Mix_FreeChunk), or NULL if the
+ file could not be opened or was not one this loader converts
+ (so Mix_LoadWAV should try it).
+ */
+Mix_Chunk* AiffLoader::load(const std::string& path)
+{
+    int frequency = 0;
+    Uint16 mixFormat = 0;
+    int mixChannels = 0;
+    if(!Mix_QuerySpec(&frequency, &mixFormat, &mixChannels) || mixFormat != AUDIO_S16LSB || SDL_BYTEORDER != SDL_LIL_ENDIAN)
+        return NULL;
+    
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return NULL;
+    struct stat info;
+    void* mapped = MAP_FAILED;
+    if(fstat(fd, &info) == 0 && info.st_size > 0)
+        mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays until it is unmapped
+    if(mapped == MAP_FAILED)
+        return NULL;
+    
+    Mix_Chunk* chunk = NULL;
+    Format format;
+    const Uint8* samples;
+    if(parse((const Uint8*)mapped, (size_t)info.st_size, format, samples)
+       && (format.sampleSize == 16 || format.sampleSize == 24)
+       && (format.numChannels == (unsigned int)mixChannels || (format.numChannels == 1 && mixChannels == 2))
+       && fabs(format.sampleRate - frequency) < 0.5)
+    {
+        bool isMono = format.numChannels != (unsigned int)mixChannels;
+        unsigned int numSamples = format.numFrames * format.numChannels; // Read from the file
+        chunk = (Mix_Chunk*)SDL_malloc(sizeof(Mix_Chunk));
+        chunk->allocated = 1; // So Mix_FreeChunk frees the samples too
+        chunk->alen = format.numFrames * mixChannels * sizeof(Sint16);
+        chunk->abuf = (Uint8*)SDL_malloc(chunk->alen);
+        chunk->volume = MIX_MAX_VOLUME;
+        if(format.sampleSize == 16)
+            convert16(samples, (Sint16*)chunk->abuf, numSamples, isMono);
+        else
+            convert24(samples, (Sint16*)chunk->abuf, numSamples, isMono);
+    } // if
+    munmap(mapped, (size_t)info.st_size);
+    return chunk;
+} // AiffLoader::load(const std::string&)
+
+//--------------------------------------------------------------------------
+/**
+ Loads every file with Mix_LoadWAV and with this loader a few
+ times, and prints how long each took (the fastest time of
+ each) and whether the samples came out the same.
+ 
+ @param paths The paths of the files.
+ @param out The stream to print to.
+ */
+void AiffLoader::benchmark(const std::vector<std::string>& paths, std::ostream& out)
+{
+    float mixerMs = 0.0f;
+    float loaderMs = 0.0f;
+    unsigned int numConverted = 0;
+    unsigned int numSame = 0;
+    unsigned long long numBytes = 0;
+    for(unsigned int pass = 0; pass < NUM_BENCHMARK_PASSES; pass++)
+    {
+        std::vector<Mix_Chunk*> mixerChunks;
+        std::vector<Mix_Chunk*> loaderChunks;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(unsigned int i = 0; i < paths.size(); i++)
+            mixerChunks.push_back(Mix_LoadWAV(paths[i].c_str()));
+        std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+        for(unsigned int i = 0; i < paths.size(); i++)
+            loaderChunks.push_back(load(paths[i]));
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        
+        float passMixerMs = std::chrono::duration<float, std::milli>(middle - start).count();
+        float passLoaderMs = std::chrono::duration<float, std::milli>(end - middle).count();
+        mixerMs = (pass == 0 || passMixerMs < mixerMs) ? passMixerMs : mixerMs;
+        loaderMs = (pass == 0 || passLoaderMs < loaderMs) ? passLoaderMs : loaderMs;
+        
+        numConverted = 0;
+        numSame = 0;
+        numBytes = 0;
+        for(unsigned int i = 0; i < paths.size(); i++)
+        {
+            Mix_Chunk* expected = mixerChunks[i];
+            Mix_Chunk* chunk = loaderChunks[i];
+            if(chunk)
+            {
+                numConverted++;
+                numBytes += chunk->alen;
+                if(expected && expected->alen == chunk->alen && memcmp(expected->abuf, chunk->abuf, chunk->alen) == 0)
+                    numSame++;
+                Mix_FreeChunk(chunk);
+            } // if
+            if(expected)
+                Mix_FreeChunk(expected);
+        } // for
+    } // for
+    
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2)
+        << "AIFF loading (fastest of " << NUM_BENCHMARK_PASSES << "): " << paths.size() << " file(s), Mix_LoadWAV "
+        << mixerMs << " ms, AIFF loader " << loaderMs << " ms (" << (loaderMs > 0.0f ? mixerMs / loaderMs : 0.0f)
+        << "x); " << numConverted << " converted (" << numBytes / (1024.0 * 1024.0) << " MB), "
+        << numSame << " the same as Mix_LoadWAV" << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+} // AiffLoader::benchmark(const std::vector<std::string>&, std::ostream&)
+
+//--------------------------------------------------------------------------
+/**
+ Finds the format and the samples in a mapped AIFF or AIFF-C
+ file (an AIFF-C file must be uncompressed and big-endian).
+ 
+ @param file The bytes of the file.
+ @param fileSize How many bytes the file has.
+ @param format Set to the format of the samples.
+ @param samples Set to where the samples start in the file.
+ @return True if the file has both chunks and all of its samples.
+ */
+bool AiffLoader::parse(const Uint8* file, size_t fileSize, Format& format, const Uint8*& samples)
+{
+    if(fileSize < 12 || memcmp(file, "FORM", 4) != 0)
+        return false;
+    bool isCompressible = memcmp(file + 8, "AIFC", 4) == 0;
+    if(!isCompressible && memcmp(file + 8, "AIFF", 4) != 0)
+        return false;
+    
+    bool hasFormat = false;
+    samples = NULL;
+    size_t samplesSize = 0;
+    size_t pos = 12;
+    while(pos + 8 <= fileSize)
+    {
+        const Uint8* chunk = file + pos;
+        size_t chunkSize = readUint32(chunk + 4);
+        const Uint8* body = chunk + 8;
+        if(chunkSize > fileSize - pos - 8)
+            return false;
+        
+        if(memcmp(chunk, "COMM", 4) == 0 && chunkSize >= 18)
+        {
+            format.numChannels = (body[0] << 8) | body[1];
+            format.numFrames = readUint32(body + 2);
+            format.sampleSize = (body[6] << 8) | body[7];
+            format.sampleRate = readExtended(body + 8);
+            if(isCompressible && (chunkSize < 22 || (memcmp(body + 18, "NONE", 4) != 0 && memcmp(body + 18, "twos", 4) != 0)))
+                return false;
+            hasFormat = true;
+        } // if
+        else if(memcmp(chunk, "SSND", 4) == 0 && chunkSize >= 8)
+        {
+            size_t offset = readUint32(body);
+            if(offset > chunkSize - 8)
+                return false;
+            samples = body + 8 + offset;
+            samplesSize = chunkSize - 8 - offset;
+        } // else if
+        pos += 8 + chunkSize + (chunkSize & 1); // Chunks are padded to an even size
+    } // while
+    
+    return hasFormat && samples && format.numChannels > 0
+        && (unsigned long long)format.numFrames * format.numChannels * ((format.sampleSize + 7) / 8) <= samplesSize;
+} // AiffLoader::parse(const Uint8*, size_t, Format&, const Uint8*&)
+
+//--------------------------------------------------------------------------
+/**
+ Converts big-endian 16-bit samples to little-endian ones.
+ 
+ @param in The samples in the file.
+ @param out Where to put the converted samples (twice as many
+ if the file is mono).
+ @param numSamples How many samples to convert.
+ @param isMono True to copy each sample to both channels.
+ */
+void AiffLoader::convert16(const Uint8* in, Sint16* out, unsigned int numSamples, bool isMono)
+{
+    unsigned int i = 0;
+#if defined(AIFF_USE_SSSE3) || defined(AIFF_USE_SSE2)
+    // Eight samples at a time
+#ifdef AIFF_USE_SSSE3
+    const __m128i SWAP = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+#endif
+    for(; i + 8 <= numSamples; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(in + 2 * i));
+#ifdef AIFF_USE_SSSE3
+        v = _mm_shuffle_epi8(v, SWAP);
+#else
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+#endif
+        if(isMono)
+        {
+            _mm_storeu_si128((__m128i*)(out + 2 * i), _mm_unpacklo_epi16(v, v));
+            _mm_storeu_si128((__m128i*)(out + 2 * i + 8), _mm_unpackhi_epi16(v, v));
+        } // if
+        else
+            _mm_storeu_si128((__m128i*)(out + i), v);
+    } // for
+#endif
+    for(; i < numSamples; i++)
+    {
+        Sint16 sample = (Sint16)((in[2 * i] << 8) | in[2 * i + 1]);
+        if(isMono)
+        {
+            out[2 * i] = sample;
+            out[2 * i + 1] = sample;
+        } // if
+        else
+            out[i] = sample;
+    } // for
+} // AiffLoader::convert16(const Uint8*, Sint16*, unsigned int, bool)
+
+//--------------------------------------------------------------------------
+/**
+ Converts big-endian 24-bit samples to little-endian 16-bit
+ ones (keeping the top 16 bits, as SDL converts them).
+ 
+ @param in The samples in the file.
+ @param out Where to put the converted samples (twice as many
+ if the file is mono).
+ @param numSamples How many samples to convert.
+ @param isMono True to copy each sample to both channels.
+ */
+void AiffLoader::convert24(const Uint8* in, Sint16* out, unsigned int numSamples, bool isMono)
+{
+    unsigned int i = 0;
+#ifdef AIFF_USE_SSSE3
+    // Eight samples at a time, four from each 16 bytes loaded (the
+    // loads read 4 bytes past the eight samples, so stop 2 samples early)
+    const __m128i PICK = _mm_setr_epi8(1, 0, 4, 3, 7, 6, 10, 9, -1, -1, -1, -1, -1, -1, -1, -1);
+    for(; i + 10 <= numSamples; i += 8)
+    {
+        __m128i low = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + 3 * i)), PICK);
+        __m128i high = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + 3 * i + 12)), PICK);
+        __m128i v = _mm_unpacklo_epi64(low, high);
+        if(isMono)
+        {
+            _mm_storeu_si128((__m128i*)(out + 2 * i), _mm_unpacklo_epi16(v, v));
+            _mm_storeu_si128((__m128i*)(out + 2 * i + 8), _mm_unpackhi_epi16(v, v));
+        } // if
+        else
+            _mm_storeu_si128((__m128i*)(out + i), v);
+    } // for
+#endif
+    for(; i < numSamples; i++)
+    {
+        Sint16 sample = (Sint16)((in[3 * i] << 8) | in[3 * i + 1]);
+        if(isMono)
+        {
+            out[2 * i] = sample;
+            out[2 * i + 1] = sample;
+        } // if
+        else
+            out[i] = sample;
+    } // for
+} // AiffLoader::convert24(const Uint8*, Sint16*, unsigned int, bool)
+
+//--------------------------------------------------------------------------
+/**
+ Reads a big-endian 32-bit number.
+ 
+ @param bytes Where the number is.
+ @return The number.
+ */
+Uint32 AiffLoader::readUint32(const Uint8* bytes)
+{
+    return ((Uint32)bytes[0] << 24) | ((Uint32)bytes[1] << 16) | ((Uint32)bytes[2] << 8) | bytes[3];
+} // AiffLoader::readUint32(const Uint8*)
+
+//--------------------------------------------------------------------------
+/**
+ Reads a big-endian 80-bit extended precision number (which
+ AIFF files store the sample rate as).
+ 
+ @param bytes Where the number is.
+ @return The number.
+ */
+double AiffLoader::readExtended(const Uint8* bytes)
+{
+    int exponent = ((bytes[0] & 0x7F) << 8) | bytes[1];
+    unsigned long long mantissa = ((unsigned long long)readUint32(bytes + 2) << 32) | readUint32(bytes + 6);
+    double value = ldexp((double)mantissa, exponent - 16383 - 63);
+    return (bytes[0] & 0x80) ? -value : value;
+} // AiffLoader::readExtended(const Uint8*)
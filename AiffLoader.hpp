@@ -0,0 +1,51 @@
+/**
+ AiffLoader.hpp
+ Virtual Keyboard
+ Class which loads AIFF and uncompressed AIFF-C files straight
+ into the mixer's format, faster than SDL Mixer's own loader.
+ The file is memory-mapped and its COMM and SSND chunks are
+ read in place, and the big-endian 16- or 24-bit samples are
+ converted (with SIMD byte shuffles where the CPU has them)
+ directly into the buffer the mixer plays from, without any
+ copy in between. Files it cannot convert this way (other
+ formats, sample rates, or channel counts) are left to
+ Mix_LoadWAV.
+ 
+ @author Graeme Zinck
+ @version 1.0 5/4/2018
+ */
+
+#ifndef AiffLoader_hpp
+#define AiffLoader_hpp
+
+#include <SDL2/SDL.h>
+#include <SDL2_mixer/SDL_mixer.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class AiffLoader
+{
+public:
+    static Mix_Chunk* load(const std::string& path);
+    static void benchmark(const std::vector<std::string>& paths, std::ostream& out);
+private:
+    // What the COMM chunk says about the samples
+    struct Format
+    {
+        unsigned int numChannels;
+        unsigned int numFrames;
+        unsigned int sampleSize; // Bits per sample
+        double sampleRate;
+    }; // Format
+    
+    static bool parse(const Uint8* file, size_t fileSize, Format& format, const Uint8*& samples);
+    static void convert16(const Uint8* in, Sint16* out, unsigned int numSamples, bool isMono);
+    static void convert24(const Uint8* in, Sint16* out, unsigned int numSamples, bool isMono);
+    static Uint32 readUint32(const Uint8* bytes);
+    static double readExtended(const Uint8* bytes);
+    
+    static const unsigned int NUM_BENCHMARK_PASSES = 3; // The fastest is kept (the first reads from the disk)
+}; // AiffLoader
+
+#endif /* AiffLoader_hpp */
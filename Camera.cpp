@@ -30,6 +30,8 @@ Camera::Camera(const glm::vec3& pos, float fov, float aspect, float zNear, float
     updateAspectRatio(aspect); // Creates the perspective projection matrix
     
     m_position = pos;
+    m_previousPosition = pos;
+    m_renderPosition = pos;
     m_up = glm::vec3(0,1,0); // Default
     
     // Turn the camera in right direction
@@ -46,6 +48,7 @@ Camera::Camera(const glm::vec3& pos, float fov, float aspect, float zNear, float
  */
 void Camera::updateAspectRatio(float aspect)
 {
+    m_aspect = aspect;
     m_perspective = glm::perspective(m_fov, aspect, m_zNear, m_zFar);
 } // Camera::updateAspectRatio(float)
 
@@ -57,52 +60,72 @@ void Camera::updateAspectRatio(float aspect)
  */
 glm::mat4 Camera::getViewProjection() const
 {
-    return m_perspective * glm::lookAt(m_position, m_position + m_forward, m_up);
+    return m_perspective * getView();
 } // Camera::getViewProjection()
 
+//--------------------------------------------------------------------------
+/**
+ Gets the view matrix, which moves world coordinates into
+ the camera's coordinates (looking down the negative z-axis).
+ 
+ @return The view matrix.
+ */
+glm::mat4 Camera::getView() const
+{
+    return glm::lookAt(m_renderPosition, m_renderPosition + m_forward, m_up);
+} // Camera::getView()
+
 //--------------------------------------------------------------------------
 /**
  Useful function for moving the camera forward by the move speed.
+ 
+ @param seconds How long the camera moves for.
  */
-void Camera::moveForward()
+void Camera::moveForward(float seconds)
 {
-    float x = m_position.x + (m_forward.x * MOVE_SPEED);
-    float z = m_position.z + (m_forward.z * MOVE_SPEED);
+    float x = m_position.x + (m_forward.x * MOVE_SPEED * seconds);
+    float z = m_position.z + (m_forward.z * MOVE_SPEED * seconds);
     m_position = glm::vec3(x, m_position.y, z);
-} // Camera::moveForward()
+} // Camera::moveForward(float)
 
 //--------------------------------------------------------------------------
 /**
  Useful function for moving the camera backward by the move speed.
+ 
+ @param seconds How long the camera moves for.
  */
-void Camera::moveBackward()
+void Camera::moveBackward(float seconds)
 {
-    float x = m_position.x - (m_forward.x * MOVE_SPEED);
-    float z = m_position.z - (m_forward.z * MOVE_SPEED);
+    float x = m_position.x - (m_forward.x * MOVE_SPEED * seconds);
+    float z = m_position.z - (m_forward.z * MOVE_SPEED * seconds);
     m_position = glm::vec3(x, m_position.y, z);
-} // Camera::moveBackward()
+} // Camera::moveBackward(float)
 
 //--------------------------------------------------------------------------
 /**
  Useful function for moving the camera right by the move speed.
+ 
+ @param seconds How long the camera moves for.
  */
-void Camera::moveRight()
+void Camera::moveRight(float seconds)
 {
-    float x = m_position.x - (m_forward.z * MOVE_SPEED);
-    float z = m_position.z + (m_forward.x * MOVE_SPEED);
+    float x = m_position.x - (m_forward.z * MOVE_SPEED * seconds);
+    float z = m_position.z + (m_forward.x * MOVE_SPEED * seconds);
     m_position = glm::vec3(x, m_position.y, z);
-} // Camera::moveRight()
+} // Camera::moveRight(float)
 
 //--------------------------------------------------------------------------
 /**
  Useful function for moving the camera left by the move speed.
+ 
+ @param seconds How long the camera moves for.
  */
-void Camera::moveLeft()
+void Camera::moveLeft(float seconds)
 {
-    float x = m_position.x + (m_forward.z * MOVE_SPEED);
-    float z = m_position.z - (m_forward.x * MOVE_SPEED);
+    float x = m_position.x + (m_forward.z * MOVE_SPEED * seconds);
+    float z = m_position.z - (m_forward.x * MOVE_SPEED * seconds);
     m_position = glm::vec3(x, m_position.y, z);
-} // Camera::moveLeft()
+} // Camera::moveLeft(float)
 
 //--------------------------------------------------------------------------
 /**
@@ -129,3 +152,46 @@ void Camera::turnXY(float x, float y)
     float forwardZ = -cos(m_xRot) * cos(m_yRot);
     m_forward = glm::vec3(forwardX, forwardY, forwardZ);
 } // void Camera::turnXY(float, float)
+
+//--------------------------------------------------------------------------
+/**
+ Puts the camera at a position and turns it to exactly the
+ given rotations (used to play back a recorded session).
+ 
+ @param pos The new position of the camera.
+ @param xRot The rotation in the x direction.
+ @param yRot The rotation in the y direction.
+ */
+void Camera::setPose(const glm::vec3& pos, float xRot, float yRot)
+{
+    m_position = pos;
+    m_previousPosition = pos;
+    m_renderPosition = pos;
+    m_xRot = xRot;
+    m_yRot = yRot;
+    turnXY(0, 0);
+} // Camera::setPose(const glm::vec3&, float, float)
+
+//--------------------------------------------------------------------------
+/**
+ Starts a tick of the simulation, remembering where the camera
+ was so that frames can be drawn between this tick and the last.
+ */
+void Camera::beginTick()
+{
+    m_previousPosition = m_position;
+} // Camera::beginTick()
+
+//--------------------------------------------------------------------------
+/**
+ Places the camera for drawing between the last two ticks of
+ the simulation. Only the position is blended; the rotation
+ follows the mouse every frame.
+ 
+ @param alpha How far through the current tick the frame is
+ (0 at the previous tick, 1 at the latest one).
+ */
+void Camera::interpolate(float alpha)
+{
+    m_renderPosition = glm::mix(m_previousPosition, m_position, alpha);
+} // Camera::interpolate(float)
@@ -22,20 +22,61 @@ public:
     
     void updateAspectRatio(float aspect);
     glm::mat4 getViewProjection() const;
-    void moveForward();
-    void moveBackward();
-    void moveRight();
-    void moveLeft();
+    glm::mat4 getView() const;
+    void moveForward(float seconds);
+    void moveBackward(float seconds);
+    void moveRight(float seconds);
+    void moveLeft(float seconds);
     void turnXY(float x, float y);
+    void setPose(const glm::vec3& pos, float xRot, float yRot);
+    void beginTick();
+    void interpolate(float alpha);
     
     /**
-     Gets the position of the camera.
+     Gets whether the camera moved during the last tick of the
+     simulation (so frames drawn in between look different).
+     */
+    inline bool isMoving() { return m_previousPosition != m_position; };
+    
+    /**
+     Gets the position of the camera in the simulation.
      
      @return Vec3 of the position.
      */
     inline glm::vec3 getPos() { return m_position; };
+    /**
+     Gets the position the camera is drawn from (between the
+     last two ticks of the simulation).
+     
+     @return Vec3 of the position.
+     */
+    inline glm::vec3 getRenderPos() { return m_renderPosition; };
+    /**
+     Gets the rotation in the "x" direction (around the y-axis).
+     */
+    inline float getXRot() { return m_xRot; };
+    /**
+     Gets the rotation in the "y" direction (up and down).
+     */
+    inline float getYRot() { return m_yRot; };
+    /**
+     Gets the aspect ratio of the projection.
+     */
+    inline float getAspectRatio() { return m_aspect; };
+    /**
+     Gets the distance to the near plane of the frustum.
+     */
+    inline float getZNear() { return m_zNear; };
+    /**
+     Gets the distance to the far plane of the frustum.
+     */
+    inline float getZFar() { return m_zFar; };
+    /**
+     Gets the projection matrix.
+     */
+    inline const glm::mat4& getProjection() { return m_perspective; };
 private:    
-    const float MOVE_SPEED = 0.2;
+    const float MOVE_SPEED = 12.0; // Units per second
     const float ROT_SPEED = 0.003;
     
     // Constants/variables for rotating camera's direction
@@ -44,11 +85,14 @@ private:
     
     // For the projection matrix
     float m_fov; // field of view
+    float m_aspect;
     float m_zNear;
     float m_zFar;
     glm::mat4 m_perspective;
     
-    glm::vec3 m_position;
+    glm::vec3 m_position; // At the latest tick of the simulation
+    glm::vec3 m_previousPosition; // At the tick before
+    glm::vec3 m_renderPosition; // Blended between the two for drawing
     glm::vec3 m_forward;
     glm::vec3 m_up;
 }; // Camera
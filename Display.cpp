@@ -10,6 +10,7 @@
 #include "Display.hpp"
 #include <iostream>
 #include <glm/glm.hpp>
+#include <math.h>
 #include <SDL2_mixer/SDL_mixer.h>
 
 //--------------------------------------------------------------------------
@@ -21,8 +22,10 @@
  @param width Width of the window to create.
  @param height Height of the window to create.
  @param title Title for the window to create.
+ @param isHidden True to never show the window (when only
+ drawing offscreen).
 */
-Display::Display(int width, int height, const std::string& title)
+Display::Display(int width, int height, const std::string& title, bool isHidden)
 {
     SDL_Init(SDL_INIT_EVERYTHING);
     
@@ -42,6 +45,7 @@ Display::Display(int width, int height, const std::string& title)
     SDL_GL_SetAttribute(SDL_GL_BUFFER_SIZE, RGB_SIZE * 4);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, RGB_SIZE * 2);
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, ON);
+    SDL_GL_SetAttribute(SDL_GL_FRAMEBUFFER_SRGB_CAPABLE, ON); // Gamma corrected for free when writing
     
     // Set the width and height of the window
     m_width = width;
@@ -54,8 +58,38 @@ Display::Display(int width, int height, const std::string& title)
     m_rightPressed = false;
     m_leftPressed = false;
     
+    // Lights are not clustered unless setLightClusters() is called
+    m_lightClusters = NULL;
+    m_shadowMap = NULL;
+    m_hud = NULL;
+    m_frameCapture = NULL;
+    m_renderState = NULL;
+    m_session = NULL;
+    m_renderCamera = NULL;
+    
+    // Nothing is drawn on the render thread until startRenderThread() is called
+    m_snapshotReady = SDL_CreateSemaphore(0);
+    m_isRendering = false;
+    m_isHudVisible = false;
+    m_isRecording = false;
+    m_numScreenshots = 0;
+    m_numScreenshotsTaken = 0;
+    m_viewportWidth = 0;
+    m_viewportHeight = 0;
+    
+    // The simulation starts now
+    m_lastUpdate = std::chrono::steady_clock::now();
+    m_lastInputTime = m_lastUpdate;
+    m_simMs = 0.0f;
+    m_cameraWasMoving = false;
+    
+    // Nothing has been drawn or culled yet
+    m_lastKeysDrawn = 0;
+    m_lastKeysCulled = 0;
+    
     // Create the window with an OpenGL context
-    m_window = SDL_CreateWindow(title.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, m_width, m_height, SDL_WINDOW_OPENGL);
+    Uint32 windowFlags = isHidden ? (SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN) : SDL_WINDOW_OPENGL;
+    m_window = SDL_CreateWindow(title.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, m_width, m_height, windowFlags);
     m_glContext = SDL_GL_CreateContext(m_window);
     m_isClosed = false; // The display will be open until the user quits somehow
     m_justOpened = true; // Triggers the first refresh of the screen
@@ -63,16 +97,28 @@ Display::Display(int width, int height, const std::string& title)
     
     // Make the mouse pointer disappear so the user can navigate
     // the keyboard world in first-person
-    SDL_SetRelativeMouseMode(SDL_TRUE);
+    if(!isHidden)
+        SDL_SetRelativeMouseMode(SDL_TRUE);
     
     // Disable legacy OpenGL commands and start up OpenGL
     glewExperimental = GL_TRUE;
     glewInit();
     
+    // If the framebuffer stores sRGB colours, let OpenGL do the
+    // gamma correction instead of the fragment shader
+    GLint encoding = GL_LINEAR;
+    glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_BACK_LEFT, GL_FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING, &encoding);
+    m_hasSrgbFramebuffer = (glGetError() == GL_NO_ERROR && encoding == GL_SRGB);
+    if(m_hasSrgbFramebuffer)
+        glEnable(GL_FRAMEBUFFER_SRGB);
+    
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE); // Don't draw the faces that are NOT facing the camera
     glCullFace(GL_BACK);
     glShadeModel(GL_SMOOTH);
+    
+    // Time the frames (the queries need the context)
+    m_frameTimer = new FrameTimer();
 } // Display::Display(int, int, const std::string&)
 
 //--------------------------------------------------------------------------
@@ -82,6 +128,10 @@ Display::Display(int width, int height, const std::string& title)
 */
 Display::~Display()
 {
+    stopRenderThread();
+    SDL_DestroySemaphore(m_snapshotReady);
+    delete m_renderCamera;
+    delete m_frameTimer;
     SDL_GL_DeleteContext(m_glContext);
     SDL_DestroyWindow(m_window);
     Mix_Quit();
@@ -100,6 +150,13 @@ Display::~Display()
 */
 void Display::clear(float r, float g, float b, float a)
 {
+    // An sRGB framebuffer expects linear colours
+    if(m_hasSrgbFramebuffer)
+    {
+        r = powf(r, GAMMA);
+        g = powf(g, GAMMA);
+        b = powf(b, GAMMA);
+    } // if
     glClearColor(r, g, b, a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 } // clear(float, float, float, float);
@@ -109,13 +166,17 @@ void Display::clear(float r, float g, float b, float a)
  Updates the display if needed.
  Situations where this will occur:
  1) If the display was just created
- 2) If a keyboard key is currently moving
- 3) If W, S, A, or D is pressed (to move)
- 4) If W, S, A, or D was previously pressed and not yet released
- 5) If F or ESC is pressed (fullscreen/windowed mode toggles)
- 6) If the cursor moves (the camera)
- It then moves the camera accordingly and redraws the scene
- if necessary.
+ 2) If a keyboard key moved during a tick of the simulation
+ 3) If the camera is moving (W, S, A, or D is held down)
+ 4) If F or ESC is pressed (fullscreen/windowed mode toggles)
+ 5) If the cursor moves (the camera)
+ 6) If frames are being recorded
+ The camera and the keys are simulated in fixed ticks of
+ SIM_TICK_MS, as many as fit in the time since the last
+ update, so they move at the same speed at any frame rate.
+ A snapshot is then handed to the render thread, with the
+ camera placed between the last two ticks. The render thread
+ must have been started with startRenderThread().
 */
 void Display::update()
 {
@@ -129,10 +190,6 @@ void Display::update()
         m_justOpened = false;
     } // if
     
-    // If a key is moving down, update!
-    if(m_keyboardKeys->keyIsMoving())
-        mustUpdate = true;
-    
     // Update, depending on interaction
     while(SDL_PollEvent(&e)) // Take the next event in queue, put it in e.
     {
@@ -175,7 +232,6 @@ void Display::update()
                     else
                     {
                         SDL_SetWindowFullscreen(m_window, 0);
-                        glViewport(0, 0, m_width, m_height);
                         SDL_SetWindowSize(m_window, m_width, m_height);
                         m_camera->updateAspectRatio(getAspectRatio());
                         m_isFullScreen = false;
@@ -187,7 +243,6 @@ void Display::update()
                     if(m_isFullScreen)
                     {
                         SDL_SetWindowFullscreen(m_window, 0);
-                        glViewport(0, 0, m_width, m_height);
                         SDL_SetWindowSize(m_window, m_width, m_height);
                         m_camera->updateAspectRatio(getAspectRatio());
                         m_isFullScreen = false;
@@ -203,6 +258,30 @@ void Display::update()
                     m_keyboardKeys->nextSoundSetting();
                     break;
                     
+                case SDL_SCANCODE_H: // Show or hide the performance overlay
+                    if(m_hud)
+                    {
+                        m_isHudVisible = !m_isHudVisible;
+                        mustUpdate = true;
+                    } // if
+                    break;
+                    
+                case SDL_SCANCODE_P: // Save a screenshot
+                    if(m_frameCapture)
+                    {
+                        m_numScreenshots++;
+                        mustUpdate = true;
+                    } // if
+                    break;
+                    
+                case SDL_SCANCODE_R: // Start or stop recording
+                    if(m_frameCapture)
+                    {
+                        m_isRecording = !m_isRecording;
+                        mustUpdate = true;
+                    } // if
+                    break;
+                    
                 default:
                     break;
             } // switch
@@ -233,43 +312,264 @@ void Display::update()
         else if (e.type == SDL_MOUSEMOTION)
         {
             m_camera->turnXY(e.motion.xrel, e.motion.yrel);
+            m_lastInputTime = std::chrono::steady_clock::now();
+            m_rotationLatch.store(m_camera->getXRot(), m_camera->getYRot(), m_lastInputTime);
             mustUpdate = true;
         } // else if
     } // while
     
-    // Check if a button is currently pressed down
-    if(m_forwPressed)
+    // Run the simulation up to now (dropping time after a long stall)
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    m_simMs += std::chrono::duration<float, std::milli>(now - m_lastUpdate).count();
+    m_lastUpdate = now;
+    if(m_simMs > MAX_CATCH_UP_MS)
+        m_simMs = MAX_CATCH_UP_MS;
+    while(m_simMs >= SIM_TICK_MS)
     {
-        m_camera->moveForward();
+        if(simulateTick())
+            mustUpdate = true;
+        m_simMs -= SIM_TICK_MS;
+    } // while
+    
+    // Frames between ticks show the camera part way along (and the
+    // update where it stops shows it at its final position)
+    if(m_camera->isMoving() || m_cameraWasMoving)
+        mustUpdate = true;
+    m_cameraWasMoving = m_camera->isMoving();
+    m_camera->interpolate(m_simMs / SIM_TICK_MS);
+    
+    // A recording needs every frame, even if nothing moved
+    if(m_isRecording)
         mustUpdate = true;
+    
+    // ONLY UPDATE if there was motion (the render thread draws
+    // the latest snapshot when it is ready for another frame)
+    if(mustUpdate)
+    {
+        if(m_session)
+            m_session->record(m_camera, m_keyboardKeys);
+        takeSnapshot(m_snapshots.getBack());
+        m_snapshots.publish();
+        if(SDL_SemValue(m_snapshotReady) == 0)
+            SDL_SemPost(m_snapshotReady);
     } // if
+    
+    // Wait for more input, or until the next tick is due
+    SDL_WaitEventTimeout(NULL, (int)ceilf(SIM_TICK_MS - m_simMs));
+} // Display::update()
+
+//--------------------------------------------------------------------------
+/**
+ Runs one tick of the simulation: moves the camera for the
+ movement keys held down, presses the key the camera is over,
+ and moves the keys going up or down.
+ 
+ @return True if a key moved (so the frame must be redrawn).
+*/
+bool Display::simulateTick()
+{
+    float seconds = SIM_TICK_MS / 1000.0f;
+    m_camera->beginTick();
+    if(m_forwPressed)
+        m_camera->moveForward(seconds);
     if(m_backPressed)
+        m_camera->moveBackward(seconds);
+    if(m_rightPressed)
+        m_camera->moveRight(seconds);
+    if(m_leftPressed)
+        m_camera->moveLeft(seconds);
+    m_keyboardKeys->pressKeyAt(m_camera->getPos()); // Press the key down (if not already down)
+    return m_keyboardKeys->advanceClock(SIM_TICK_MS);
+} // Display::simulateTick()
+
+//--------------------------------------------------------------------------
+/**
+ Copies the state of the simulation which is needed to draw a
+ frame: the camera (placed between the last two ticks), how
+ far down each key is, and what the user asked for.
+ 
+ @param snapshot The snapshot to fill.
+*/
+void Display::takeSnapshot(FrameSnapshot& snapshot)
+{
+    snapshot.cameraPos = m_camera->getRenderPos();
+    snapshot.cameraXRot = m_camera->getXRot();
+    snapshot.cameraYRot = m_camera->getYRot();
+    snapshot.inputTime = m_lastInputTime;
+    snapshot.aspect = m_camera->getAspectRatio();
+    snapshot.width = getWidth();
+    snapshot.height = getHeight();
+    m_keyboardKeys->getKeyLevels(snapshot.keyLevels);
+    snapshot.isHudVisible = m_isHudVisible;
+    snapshot.isRecording = m_isRecording;
+    snapshot.numScreenshots = m_numScreenshots;
+} // Display::takeSnapshot(FrameSnapshot&)
+
+//--------------------------------------------------------------------------
+/**
+ Starts drawing on the render thread. The OpenGL context is
+ handed over to it, so nothing may be drawn on the main thread
+ until stopRenderThread() is called.
+*/
+void Display::startRenderThread()
+{
+    if(m_renderThread.joinable())
+        return;
+    m_isHudVisible = m_hud && m_hud->isVisible();
+    m_isRecording = m_frameCapture && m_frameCapture->isRecording();
+    m_rotationLatch.store(m_camera->getXRot(), m_camera->getYRot(), m_lastInputTime);
+    m_isRendering = true;
+    SDL_GL_MakeCurrent(m_window, NULL);
+    m_renderThread = std::thread(&Display::renderLoop, this);
+} // Display::startRenderThread()
+
+//--------------------------------------------------------------------------
+/**
+ Stops the render thread after the frame it is drawing, and
+ takes the OpenGL context back to the main thread.
+*/
+void Display::stopRenderThread()
+{
+    if(!m_renderThread.joinable())
+        return;
+    m_isRendering = false;
+    SDL_SemPost(m_snapshotReady);
+    m_renderThread.join();
+    SDL_GL_MakeCurrent(m_window, m_glContext);
+} // Display::stopRenderThread()
+
+//--------------------------------------------------------------------------
+/**
+ Runs on the render thread: draws the latest snapshot each time
+ one is published, until stopRenderThread() is called.
+*/
+void Display::renderLoop()
+{
+    SDL_GL_MakeCurrent(m_window, m_glContext);
+    while(m_isRendering)
     {
-        m_camera->moveBackward();
-        mustUpdate = true;
+        SDL_SemWaitTimeout(m_snapshotReady, RENDER_WAIT_MS);
+        if(m_snapshots.acquire())
+            renderFrame(m_snapshots.getFront());
+    } // while
+    SDL_GL_MakeCurrent(m_window, NULL);
+} // Display::renderLoop()
+
+//--------------------------------------------------------------------------
+/**
+ Draws one snapshot into the window and swaps the buffers, after
+ doing what the user asked for since the last frame (resizing,
+ the overlay, screenshots and recording).
+ 
+ @param snapshot The snapshot to draw.
+*/
+void Display::renderFrame(const FrameSnapshot& snapshot)
+{
+    if(snapshot.width != m_viewportWidth || snapshot.height != m_viewportHeight)
+    {
+        glViewport(0, 0, snapshot.width, snapshot.height);
+        m_viewportWidth = snapshot.width;
+        m_viewportHeight = snapshot.height;
     } // if
-    if(m_rightPressed)
+    if(m_hud && m_hud->isVisible() != snapshot.isHudVisible)
+        m_hud->setVisible(snapshot.isHudVisible);
+    if(m_frameCapture)
     {
-        m_camera->moveRight();
-        mustUpdate = true;
+        if(snapshot.isRecording && !m_frameCapture->isRecording())
+            m_frameCapture->startRecording();
+        else if(!snapshot.isRecording && m_frameCapture->isRecording())
+        {
+            m_frameCapture->stopRecording();
+            m_frameCapture->report(std::cout);
+        } // else if
+        if(snapshot.numScreenshots != m_numScreenshotsTaken)
+        {
+            m_frameCapture->takeScreenshot();
+            m_numScreenshotsTaken = snapshot.numScreenshots;
+        } // if
     } // if
-    if(m_leftPressed)
+    
+    if(m_renderState)
+        m_renderState->resetNumDrawCalls();
+    m_frameTimer->beginFrame();
+    drawScene(snapshot);
+    if(m_frameCapture)
+        m_frameCapture->capture(snapshot.width, snapshot.height); // Read back before the swap
+    m_frameTimer->beginSwap();
+    SDL_GL_SwapWindow(m_window); // Swap buffers
+    m_frameTimer->endFrame();
+    
+    // Report the frame times every so often
+    if(m_frameTimer->getNumFrames() % FRAMES_PER_REPORT == 0)
+        m_frameTimer->report(std::cout);
+    
+    // Report the culling results when they change
+    if(m_keyboardKeys->getNumKeysDrawn() != m_lastKeysDrawn || m_keyboardKeys->getNumKeysCulled() != m_lastKeysCulled)
     {
-        m_camera->moveLeft();
-        mustUpdate = true;
+        m_lastKeysDrawn = m_keyboardKeys->getNumKeysDrawn();
+        m_lastKeysCulled = m_keyboardKeys->getNumKeysCulled();
+        std::cout << "Keys drawn: " << m_lastKeysDrawn << ", culled: " << m_lastKeysCulled
+                  << " (" << m_keyboardKeys->getNumGroupsCulled() << " octaves culled), state changes avoided: "
+                  << m_keyboardKeys->getNumStateChangesAvoided() << std::endl;
     } // if
+} // Display::renderFrame(const FrameSnapshot&)
+
+//--------------------------------------------------------------------------
+/**
+ Draws one frame of a snapshot into whatever framebuffer is
+ bound (the window's, or an offscreen one). The keys and a
+ copy of the camera are moved to where the snapshot has them,
+ so the simulation can carry on while the frame is drawn. On
+ the render thread, the camera is then turned by the newest
+ mouse motion as late as possible: the shadows, which do not
+ depend on the camera, are drawn first, and the rotation is
+ latched just before the lights are clustered and the view
+ and projection are uploaded with the keys. The buffers are
+ not swapped.
+ 
+ @param snapshot The snapshot to draw.
+*/
+void Display::drawScene(const FrameSnapshot& snapshot)
+{
+    m_renderCamera->setPose(snapshot.cameraPos, snapshot.cameraXRot, snapshot.cameraYRot);
+    if(m_renderCamera->getAspectRatio() != snapshot.aspect)
+        m_renderCamera->updateAspectRatio(snapshot.aspect);
+    m_keyboardKeys->setDrawnLevels(snapshot.keyLevels);
     
-    // ONLY UPDATE if there was motion
-    if(mustUpdate)
+    clear(0.0f, 0.15f, 0.3f, 1.0f);
+    if(m_shadowMap)
     {
-        clear(0.0f, 0.15f, 0.3f, 1.0f);
-        // Get the key
-        int theKey = m_keyboardKeys->getSelectedKey(m_camera->getPos());
-        m_keyboardKeys->keyDown(theKey); // Press the key down (if not already down)
-        m_keyboardKeys->draw(m_camera); // Draw all the keys
-        SDL_GL_SwapWindow(m_window); // Swap buffers
+        m_frameTimer->beginPass(FrameTimer::SHADOW_PASS);
+        m_keyboardKeys->updateShadows(m_shadowMap); // Redraw only the parts that changed
+        m_shadowMap->bindTextures();
+        m_frameTimer->endPass(FrameTimer::SHADOW_PASS);
     } // if
-} // Display::update()
+    
+    // Late latch the newest rotation (an offline render keeps the snapshot's)
+    if(m_isRendering)
+    {
+        float xRot;
+        float yRot;
+        std::chrono::steady_clock::time_point inputTime;
+        m_rotationLatch.load(xRot, yRot, inputTime);
+        m_renderCamera->setPose(snapshot.cameraPos, xRot, yRot);
+        m_frameTimer->setInputTimes(inputTime, snapshot.inputTime);
+    } // if
+    if(m_lightClusters)
+    {
+        m_lightClusters->update(m_renderCamera); // Sort the lights into the camera's clusters
+        m_lightClusters->bindTextures();
+    } // if
+    m_frameTimer->beginPass(FrameTimer::KEYS_PASS);
+    m_keyboardKeys->draw(m_renderCamera); // Draw all the keys
+    m_frameTimer->endPass(FrameTimer::KEYS_PASS);
+    if(m_hud && m_hud->isVisible())
+    {
+        m_frameTimer->beginPass(FrameTimer::HUD_PASS);
+        m_hud->draw(m_frameTimer);
+        m_frameTimer->endPass(FrameTimer::HUD_PASS);
+    } // if
+} // Display::drawScene(const FrameSnapshot&)
 
 //--------------------------------------------------------------------------
 /**
@@ -377,6 +677,8 @@ int Display::getScreenHeight()
 void Display::setCamera(Camera * camera)
 {
     m_camera = camera;
+    delete m_renderCamera;
+    m_renderCamera = new Camera(*camera); // Only the render thread uses the copy
 } // Display::setCamera(Camera)
 
 //--------------------------------------------------------------------------
@@ -387,3 +689,69 @@ void Display::setKeyboardKeys(KeyboardKeys* keys)
 {
     m_keyboardKeys = keys;
 } // Display::setKeyboardKeys(KeyboardKeys*)
+
+//--------------------------------------------------------------------------
+/**
+ Sets the lights to sort into clusters before every frame
+ (only needed when the shaders use clustered lights).
+*/
+void Display::setLightClusters(LightClusters* lightClusters)
+{
+    m_lightClusters = lightClusters;
+} // Display::setLightClusters(LightClusters*)
+
+//--------------------------------------------------------------------------
+/**
+ Sets the shadow map to update with the keys before every
+ frame (only needed when the shaders use shadows).
+*/
+void Display::setShadowMap(ShadowMap* shadowMap)
+{
+    m_shadowMap = shadowMap;
+} // Display::setShadowMap(ShadowMap*)
+
+//--------------------------------------------------------------------------
+/**
+ Sets the performance overlay, which is shown and hidden with
+ the H key.
+*/
+void Display::setPerformanceHud(PerformanceHud* hud)
+{
+    m_hud = hud;
+} // Display::setPerformanceHud(PerformanceHud*)
+
+//--------------------------------------------------------------------------
+/**
+ Sets the capturer which reads back every frame drawn (for
+ screenshots and recordings).
+ 
+ @param frameCapture The capturer to use.
+*/
+void Display::setFrameCapture(FrameCapture* frameCapture)
+{
+    m_frameCapture = frameCapture;
+} // Display::setFrameCapture(FrameCapture*)
+
+//--------------------------------------------------------------------------
+/**
+ Sets the session which records the state at every frame
+ drawn (so that it can be rendered offline later).
+ 
+ @param session The session to record into.
+*/
+void Display::setSession(Session* session)
+{
+    m_session = session;
+} // Display::setSession(Session*)
+
+//--------------------------------------------------------------------------
+/**
+ Sets the OpenGL state tracker whose draw call count is reset
+ at the start of every frame (so it counts one frame's calls).
+ 
+ @param renderState The state tracker the shaders draw with.
+*/
+void Display::setRenderState(RenderState* renderState)
+{
+    m_renderState = renderState;
+} // Display::setRenderState(RenderState*)
@@ -4,7 +4,10 @@
  This class is for a display object which initializes the
  windowing system and creates an OpenGL context.
  This object is used to refresh the window while the program
- is running.
+ is running. Input and the simulation are handled on the main
+ thread, and the frames are drawn on a render thread from
+ snapshots of the simulation, so a slow buffer swap never holds
+ up the input or the notes.
  
  @author Graeme Zinck
  @version 1.0 3/28/2018
@@ -16,22 +19,38 @@
 #define GLEW_STATIC
 #include <GL/glew.h>
 
+#include <atomic>
+#include <chrono>
 #include <string>
+#include <thread>
 #include <SDL2/SDL.h>
 #include "Camera.hpp"
 #include "Transform.hpp"
 #include "Shader.hpp"
 #include "KeyboardKeys.hpp"
+#include "LightClusters.hpp"
+#include "ShadowMap.hpp"
+#include "FrameTimer.hpp"
+#include "PerformanceHud.hpp"
+#include "FrameCapture.hpp"
+#include "Session.hpp"
+#include "SnapshotBuffer.hpp"
+#include "RotationLatch.hpp"
+#include "RenderState.hpp"
 
 class Display
 {
 public:
-    Display(int width, int height, const std::string& title); // Constructor
+    Display(int width, int height, const std::string& title, bool isHidden = false); // Constructor
     virtual ~Display(); // Destructor
     
     // Methods
     void clear(float r, float g, float b, float a);
     void update(); // Updates the display depending on user input
+    void takeSnapshot(FrameSnapshot& snapshot); // Copies what is needed to draw a frame
+    void drawScene(const FrameSnapshot& snapshot); // Draws one frame without swapping buffers
+    void startRenderThread();
+    void stopRenderThread();
     bool isClosed();
     // Get characteristics of the window
     float getAspectRatio();
@@ -43,11 +62,61 @@ public:
     int getScreenWidth();
     void setCamera(Camera * camera);
     void setKeyboardKeys(KeyboardKeys* keys);
+    void setLightClusters(LightClusters* lightClusters);
+    void setShadowMap(ShadowMap* shadowMap);
+    void setPerformanceHud(PerformanceHud* hud);
+    void setFrameCapture(FrameCapture* frameCapture);
+    void setSession(Session* session);
+    void setRenderState(RenderState* renderState);
+    
+    /**
+     Gets the timer which times every frame drawn.
+     */
+    inline FrameTimer* getFrameTimer() { return m_frameTimer; }
+    
+    /**
+     Gets whether the framebuffer does gamma correction itself
+     (so shaders should output linear colours).
+     */
+    inline bool hasSrgbFramebuffer() { return m_hasSrgbFramebuffer; }
 private:
+    bool simulateTick();
+    void renderLoop();
+    void renderFrame(const FrameSnapshot& snapshot);
+    
     SDL_Window* m_window; // Points to the SDL window object
     SDL_GLContext m_glContext; // Holds the OpenGL context to use
     Camera * m_camera; // Camera associated with the display (used for updating)
     KeyboardKeys* m_keyboardKeys; // KeyboardKeys (used for updating)
+    LightClusters* m_lightClusters; // Sorted into clusters every frame (NULL if not used)
+    ShadowMap* m_shadowMap; // Updated with the keys every frame (NULL if not used)
+    FrameTimer* m_frameTimer; // Times the frames on the CPU and GPU
+    PerformanceHud* m_hud; // Drawn over the keys when shown (NULL if not used)
+    FrameCapture* m_frameCapture; // Reads back every frame drawn (NULL if not used)
+    Session* m_session; // Records every frame drawn (NULL if not used)
+    RenderState* m_renderState; // Counts the draw calls of each frame (NULL if not used)
+    Camera* m_renderCamera; // Copy of the camera which the render thread draws from
+    
+    // Snapshots of the simulation handed to the render thread
+    SnapshotBuffer m_snapshots;
+    SDL_sem* m_snapshotReady; // Posted when a snapshot is published
+    std::thread m_renderThread;
+    std::atomic<bool> m_isRendering; // Cleared to stop the render thread
+    
+    // The newest rotation from the mouse, read by the render thread
+    // just before the camera is used (late latching)
+    RotationLatch m_rotationLatch;
+    std::chrono::steady_clock::time_point m_lastInputTime; // When the mouse last moved the camera
+    
+    // What the main thread asks the render thread to do (passed in each snapshot)
+    bool m_isHudVisible;
+    bool m_isRecording;
+    unsigned int m_numScreenshots;
+    
+    // What the render thread has done so far
+    unsigned int m_numScreenshotsTaken;
+    int m_viewportWidth;
+    int m_viewportHeight;
     
     // Variables with important facts about the display
     int m_width;
@@ -55,6 +124,7 @@ private:
     bool m_justOpened; // True when first initialize the display
     bool m_isClosed;
     bool m_isFullScreen;
+    bool m_hasSrgbFramebuffer; // True if OpenGL gamma corrects what is drawn
     
     // Hold whether certain keys are pressed or not
     bool m_forwPressed;
@@ -62,10 +132,24 @@ private:
     bool m_rightPressed;
     bool m_leftPressed;
     
+    // The simulation runs in fixed ticks, however fast frames are drawn
+    std::chrono::steady_clock::time_point m_lastUpdate;
+    float m_simMs; // Time not yet simulated (less than one tick after catching up)
+    bool m_cameraWasMoving; // As of the last update (so the update it stops on is published)
+    
+    // Culling results from the last frame (reported when they change)
+    unsigned int m_lastKeysDrawn;
+    unsigned int m_lastKeysCulled;
+    
     // Class Constants
     const int RGB_SIZE = 8;
     const int ON = 1;
     const int NUM_AUDIO_CHANNELS = 64;
+    const float GAMMA = 2.2f; // Gamma of an sRGB display
+    const unsigned int FRAMES_PER_REPORT = 240; // How often the frame times are reported
+    const float SIM_TICK_MS = 10.0f; // Length of one tick of the simulation (100 Hz)
+    const float MAX_CATCH_UP_MS = 250.0f; // Time simulated at most per frame (after a stall)
+    const Uint32 RENDER_WAIT_MS = 100; // How long the render thread sleeps before checking if it must stop
 }; // Display
 
 #endif /* Display_hpp */
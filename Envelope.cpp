@@ -0,0 +1,359 @@
+/**
+ Envelope.cpp
+ Virtual Keyboard
+ Implementation of Envelope.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 5/5/2018
+ */
+
+#include "Envelope.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ENVELOPE_USE_SSE2
+#endif
+
+std::vector<Envelope> Envelope::m_channelEnvelopes;
+std::vector<int> Envelope::m_channelFadeOutMs;
+int Envelope::m_numChannels = 0;
+
+//--------------------------------------------------------------------------
+/**
+ Creates an envelope which is silent until noteOn() is called.
+ */
+Envelope::Envelope()
+{
+    m_stage = SILENT_STAGE;
+    m_level = 0.0f;
+    m_step = 0.0f;
+    m_framesLeft = 0;
+    m_attackFrames = 0;
+    m_decayFrames = 0;
+    m_sustainLevel = 1.0f;
+    m_releaseFrames = 0;
+    m_releaseRequested = false;
+} // Envelope::Envelope()
+
+//--------------------------------------------------------------------------
+/**
+ Copies an envelope (including where it is in its stages).
+ 
+ @param other The envelope to copy.
+ */
+Envelope::Envelope(const Envelope& other)
+: m_releaseRequested(false)
+{
+    *this = other;
+} // Envelope::Envelope(const Envelope&)
+
+//--------------------------------------------------------------------------
+/**
+ Copies an envelope (including where it is in its stages).
+ 
+ @param other The envelope to copy.
+ @return This envelope.
+ */
+Envelope& Envelope::operator=(const Envelope& other)
+{
+    m_stage = other.m_stage;
+    m_level = other.m_level;
+    m_step = other.m_step;
+    m_framesLeft = other.m_framesLeft;
+    m_attackFrames = other.m_attackFrames;
+    m_decayFrames = other.m_decayFrames;
+    m_sustainLevel = other.m_sustainLevel;
+    m_releaseFrames = other.m_releaseFrames;
+    m_releaseRequested = other.m_releaseRequested.load();
+    return *this;
+} // Envelope::operator=(const Envelope&)
+
+//--------------------------------------------------------------------------
+/**
+ Starts the envelope from silence, as a key is pressed.
+ 
+ @param shape The shape of the envelope.
+ @param frequency How many sample frames there are per second.
+ */
+void Envelope::noteOn(const EnvelopeShape& shape, int frequency)
+{
+    m_attackFrames = (unsigned int)(shape.attackMs * frequency / 1000.0f);
+    m_decayFrames = (unsigned int)(shape.decayMs * frequency / 1000.0f);
+    m_sustainLevel = shape.sustainLevel;
+    m_releaseFrames = (unsigned int)(shape.releaseMs * frequency / 1000.0f);
+    m_releaseRequested = false;
+    m_level = 0.0f;
+    startStage(ATTACK_STAGE);
+} // Envelope::noteOn(const EnvelopeShape&, int)
+
+//--------------------------------------------------------------------------
+/**
+ Starts the release from wherever the envelope is now, as the
+ key is let go (releasing again does not restart the release).
+ */
+void Envelope::noteOff()
+{
+    if(m_stage < RELEASE_STAGE)
+        startStage(RELEASE_STAGE);
+} // Envelope::noteOff()
+
+//--------------------------------------------------------------------------
+/**
+ Applies the next block of the envelope to a voice's samples.
+ 
+ @param samples The samples (interleaved), changed in place.
+ @param numFrames How many sample frames there are.
+ @param numChannels How many channels each frame has.
+ @return How many frames were shaped before the envelope
+ became silent (the rest are left as they are, and the voice
+ should be stopped), or numFrames if it is still sounding.
+ */
+unsigned int Envelope::apply(Sint16* samples, unsigned int numFrames, int numChannels)
+{
+    unsigned int frame = 0;
+    while(frame < numFrames && m_stage != SILENT_STAGE)
+    {
+        unsigned int count = numFrames - frame;
+        if(m_stage != SUSTAIN_STAGE && m_framesLeft < count)
+            count = m_framesLeft;
+        applyRamp(samples + frame * numChannels, count, numChannels, m_level, m_step);
+        m_level += m_step * count;
+        frame += count;
+        if(m_stage != SUSTAIN_STAGE)
+        {
+            m_framesLeft -= count;
+            if(m_framesLeft == 0)
+                startStage(m_stage + 1);
+        } // if
+    } // while
+    return frame;
+} // Envelope::apply(Sint16*, unsigned int, int)
+
+//--------------------------------------------------------------------------
+/**
+ Reads the shape of an envelope written as "A,D,S,R": the
+ attack, decay and release in milliseconds and the sustain
+ level from 0 to 1 (e.g. "5,0,1,1000").
+ 
+ @param text The shape as text.
+ @param shape Set to the shape if it could be read.
+ @return True if the text was a valid shape.
+ */
+bool Envelope::parseShape(const std::string& text, EnvelopeShape& shape)
+{
+    EnvelopeShape parsed;
+    char extra;
+    if(sscanf(text.c_str(), "%f,%f,%f,%f%c", &parsed.attackMs, &parsed.decayMs, &parsed.sustainLevel, &parsed.releaseMs, &extra) != 4)
+        return false;
+    if(!(parsed.attackMs >= 0.0f && parsed.decayMs >= 0.0f && parsed.releaseMs >= 0.0f && parsed.sustainLevel >= 0.0f && parsed.sustainLevel <= 1.0f))
+        return false;
+    shape = parsed;
+    return true;
+} // Envelope::parseShape(const std::string&, EnvelopeShape&)
+
+//--------------------------------------------------------------------------
+/**
+ Plays a chunk on a free SDL Mixer channel, shaped by an
+ envelope. The envelope is started and its effect registered
+ before the chunk plays, so the audio thread never mixes a
+ block without it. The channel is stopped as soon as the
+ envelope is silent. If SDL Mixer's samples are not 16-bit,
+ the chunk plays as it is and is faded out over the release
+ instead. SDL Mixer must be open.
+ 
+ @param chunk The chunk to play.
+ @param shape The shape of the envelope.
+ @return The channel it plays on, or -1 if it could not be
+ played (Mix_GetError() says why).
+ */
+int Envelope::playChannel(Mix_Chunk* chunk, const EnvelopeShape& shape)
+{
+    int frequency = 0;
+    Uint16 format = 0;
+    int numChannels = 0;
+    bool canShape = Mix_QuerySpec(&frequency, &format, &numChannels) != 0 && format == AUDIO_S16SYS;
+    
+    // Only the main thread plays chunks, so the channel stays free until it
+    // is played. The audio thread may still be removing the last note's
+    // effect (with the mixer locked, so before the new one is registered),
+    // which is why the effect has no done callback touching the envelope.
+    if(m_channelEnvelopes.empty())
+        m_channelEnvelopes.resize(Mix_AllocateChannels(-1));
+    m_numChannels = numChannels;
+    int channel = Mix_GroupAvailable(-1);
+    if(channel < 0)
+    {
+        Mix_SetError("No free channels available");
+        return -1;
+    } // if
+    bool isShaped = canShape && channel < (int)m_channelEnvelopes.size();
+    if(channel >= (int)m_channelFadeOutMs.size())
+        m_channelFadeOutMs.resize(channel + 1, -1);
+    m_channelFadeOutMs[channel] = isShaped ? -1 : (int)shape.releaseMs;
+    if(isShaped)
+    {
+        m_channelEnvelopes[channel].noteOn(shape, frequency);
+        Mix_RegisterEffect(channel, applyToChannel, NULL, &m_channelEnvelopes[channel]);
+    } // if
+    if(Mix_PlayChannel(channel, chunk, 0) < 0)
+    {
+        if(isShaped)
+            Mix_UnregisterEffect(channel, applyToChannel); // It would be applied twice the next time
+        return -1;
+    } // if
+    return channel;
+} // Envelope::playChannel(Mix_Chunk*, const EnvelopeShape&)
+
+//--------------------------------------------------------------------------
+/**
+ Asks for the release of the envelope on an SDL Mixer channel.
+ The audio thread starts the release at its next block (so the
+ envelope only ever changes stage there), and the channel stops
+ once the release is over. A channel played without an
+ envelope is faded out by SDL Mixer instead.
+ 
+ @param channel The channel played on.
+ */
+void Envelope::releaseChannel(int channel)
+{
+    if(channel < 0 || channel >= (int)m_channelFadeOutMs.size())
+        return;
+    int fadeOutMs = m_channelFadeOutMs[channel];
+    if(fadeOutMs < 0)
+        m_channelEnvelopes[channel].m_releaseRequested = true;
+    else if(fadeOutMs > 0)
+        Mix_FadeOutChannel(channel, fadeOutMs);
+    else
+        Mix_HaltChannel(channel);
+} // Envelope::releaseChannel(int)
+
+//--------------------------------------------------------------------------
+/**
+ Sets up the step and length of a stage, skipping stages that
+ take no time (and going straight to silence after the decay
+ if the sustain level is zero).
+ 
+ @param stage The stage to start.
+ */
+void Envelope::startStage(int stage)
+{
+    m_stage = stage;
+    m_step = 0.0f;
+    if(m_stage == ATTACK_STAGE)
+    {
+        if(m_attackFrames == 0)
+            m_stage = DECAY_STAGE;
+        else
+        {
+            m_framesLeft = m_attackFrames;
+            m_step = (1.0f - m_level) / m_attackFrames;
+            return;
+        } // else
+    } // if
+    if(m_stage == DECAY_STAGE)
+    {
+        m_level = 1.0f;
+        if(m_decayFrames == 0)
+            m_stage = SUSTAIN_STAGE;
+        else
+        {
+            m_framesLeft = m_decayFrames;
+            m_step = (m_sustainLevel - 1.0f) / m_decayFrames;
+            return;
+        } // else
+    } // if
+    if(m_stage == SUSTAIN_STAGE)
+    {
+        m_level = m_sustainLevel;
+        if(m_level > 0.0f)
+            return;
+        m_stage = SILENT_STAGE;
+    } // if
+    if(m_stage == RELEASE_STAGE)
+    {
+        if(m_releaseFrames == 0 || m_level <= 0.0f)
+            m_stage = SILENT_STAGE;
+        else
+        {
+            m_framesLeft = m_releaseFrames;
+            m_step = -m_level / m_releaseFrames;
+            return;
+        } // else
+    } // if
+    m_level = 0.0f;
+} // Envelope::startStage(int)
+
+//--------------------------------------------------------------------------
+/**
+ Multiplies samples by a linear ramp of gains, rounding to the
+ nearest sample.
+ 
+ @param samples The samples (interleaved), changed in place.
+ @param numFrames How many sample frames there are.
+ @param numChannels How many channels each frame has.
+ @param level The gain of the first frame.
+ @param step How much the gain changes from frame to frame.
+ */
+void Envelope::applyRamp(Sint16* samples, unsigned int numFrames, int numChannels, float level, float step)
+{
+    if(level == 1.0f && step == 0.0f)
+        return; // Holding at full volume
+    unsigned int frame = 0;
+#ifdef ENVELOPE_USE_SSE2
+    // Four stereo frames at a time, with the gain of each frame in one lane
+    if(numChannels == 2)
+    {
+        __m128 gains = _mm_add_ps(_mm_set1_ps(level), _mm_mul_ps(_mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), _mm_set1_ps(step)));
+        __m128 gainStep = _mm_set1_ps(step * 4.0f);
+        for(; frame + 4 <= numFrames; frame += 4)
+        {
+            __m128i in = _mm_loadu_si128((const __m128i*)(samples + frame * 2));
+            __m128 low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16));
+            __m128 high = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16));
+            low = _mm_mul_ps(low, _mm_unpacklo_ps(gains, gains));
+            high = _mm_mul_ps(high, _mm_unpackhi_ps(gains, gains));
+            _mm_storeu_si128((__m128i*)(samples + frame * 2), _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high)));
+            gains = _mm_add_ps(gains, gainStep);
+        } // for
+    } // if
+#endif
+    for(; frame < numFrames; frame++)
+    {
+        float gain = level + step * frame;
+        for(int channel = 0; channel < numChannels; channel++)
+        {
+            Sint16& sample = samples[frame * numChannels + channel];
+            sample = (Sint16)lrintf(sample * gain);
+        } // for
+    } // for
+} // Envelope::applyRamp(Sint16*, unsigned int, int, float, float)
+
+//--------------------------------------------------------------------------
+/**
+ Shapes the next block of an SDL Mixer channel (an effect,
+ called on the audio thread), starting the release first if it
+ was asked for. Once the envelope is silent, the rest of the
+ block is silenced and the channel is stopped.
+ 
+ @param channel The channel being mixed.
+ @param stream The channel's samples, changed in place.
+ @param length How many bytes there are.
+ @param envelope The channel's envelope.
+ */
+void Envelope::applyToChannel(int channel, void* stream, int length, void* envelope)
+{
+    Envelope* channelEnvelope = (Envelope*)envelope;
+    if(channelEnvelope->m_releaseRequested.exchange(false))
+        channelEnvelope->noteOff();
+    Sint16* samples = (Sint16*)stream;
+    unsigned int numFrames = (unsigned int)length / (sizeof(Sint16) * m_numChannels);
+    unsigned int numShaped = channelEnvelope->apply(samples, numFrames, m_numChannels);
+    if(numShaped < numFrames)
+    {
+        memset(samples + numShaped * m_numChannels, 0, (numFrames - numShaped) * m_numChannels * sizeof(Sint16));
+        Mix_ExpireChannel(channel, 1); // Halting here would remove this effect while it runs
+    } // if
+} // Envelope::applyToChannel(int, void*, int, void*)
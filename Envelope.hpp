@@ -0,0 +1,93 @@
+/**
+ Envelope.hpp
+ Virtual Keyboard
+ Class which shapes the volume of one voice with an ADSR
+ envelope: it rises from silence over the attack, falls to
+ the sustain level over the decay, holds there while the key
+ is down, and falls to silence over the release once the key
+ is let go. The envelope is applied to whole blocks of samples
+ at a time, as a few linear ramps (four frames at a time with
+ SSE2). A voice is over as soon as its envelope is silent.
+ The offline mixer gives each voice an envelope, and SDL
+ Mixer's channels get one each through an effect.
+ 
+ @author Graeme Zinck
+ @version 1.0 5/5/2018
+ */
+
+#ifndef Envelope_hpp
+#define Envelope_hpp
+
+#include <SDL2/SDL.h>
+#include <SDL2_mixer/SDL_mixer.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+// The shape of an envelope (each bank of sounds has its own)
+struct EnvelopeShape
+{
+    float attackMs;
+    float decayMs;
+    float sustainLevel; // 0 to 1 (0 ends the note after the decay)
+    float releaseMs;
+}; // EnvelopeShape
+
+class Envelope
+{
+public:
+    Envelope();
+    Envelope(const Envelope& other);
+    Envelope& operator=(const Envelope& other);
+    
+    void noteOn(const EnvelopeShape& shape, int frequency);
+    void noteOff();
+    unsigned int apply(Sint16* samples, unsigned int numFrames, int numChannels);
+    
+    static bool parseShape(const std::string& text, EnvelopeShape& shape);
+    static int playChannel(Mix_Chunk* chunk, const EnvelopeShape& shape);
+    static void releaseChannel(int channel);
+    
+    /**
+     Gets whether the envelope has reached silence (or was
+     never started).
+     */
+    inline bool isSilent() { return m_stage == SILENT_STAGE; }
+private:
+    // The stages of the envelope, in order
+    enum {
+        ATTACK_STAGE,
+        DECAY_STAGE,
+        SUSTAIN_STAGE,
+        RELEASE_STAGE,
+        SILENT_STAGE
+    }; // enum
+    
+    void startStage(int stage);
+    static void applyRamp(Sint16* samples, unsigned int numFrames, int numChannels, float level, float step);
+    static void applyToChannel(int channel, void* stream, int length, void* envelope);
+    
+    int m_stage;
+    float m_level; // Gain at the start of the next frame
+    float m_step; // Change in gain per frame in this stage
+    unsigned int m_framesLeft; // Frames to the end of this stage (not used while sustaining)
+    
+    // The shape, in frames
+    unsigned int m_attackFrames;
+    unsigned int m_decayFrames;
+    float m_sustainLevel;
+    unsigned int m_releaseFrames;
+    
+    // Set by releaseChannel() on the main thread, and turned into a
+    // release by the audio thread at the start of its next block
+    std::atomic<bool> m_releaseRequested;
+    
+    // The envelope of each of SDL Mixer's channels (only used by the audio
+    // thread while a channel plays, and started before it plays), and
+    // how long to fade out each channel played without one (-1 if it has one)
+    static std::vector<Envelope> m_channelEnvelopes;
+    static std::vector<int> m_channelFadeOutMs;
+    static int m_numChannels; // Per sample frame of SDL Mixer's output
+}; // Envelope
+
+#endif /* Envelope_hpp */
@@ -0,0 +1,563 @@
+/**
+ FrameCapture.cpp
+ Virtual Keyboard
+ Implementation of FrameCapture.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/24/2018
+ */
+
+#include "FrameCapture.hpp"
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+//--------------------------------------------------------------------------
+/**
+ Builds the table for CRC-32 (used by every PNG chunk).
+ 
+ @return The CRC of each byte value.
+ */
+static std::vector<uint32_t> makeCrcTable()
+{
+    std::vector<uint32_t> table(256);
+    for(uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for(int bit = 0; bit < 8; bit++)
+            crc = (crc & 1) ? (0xEDB88320u ^ (crc >> 1)) : (crc >> 1);
+        table[i] = crc;
+    } // for
+    return table;
+} // makeCrcTable()
+
+//--------------------------------------------------------------------------
+/**
+ Adds bytes to a CRC-32.
+ 
+ @param crc The CRC so far (0xFFFFFFFF to begin with).
+ @param data The bytes to add.
+ @param size How many bytes to add.
+ @return The new CRC (which must be inverted once every
+ byte has been added).
+ */
+static uint32_t updateCrc(uint32_t crc, const unsigned char* data, size_t size)
+{
+    static const std::vector<uint32_t> TABLE = makeCrcTable();
+    for(size_t i = 0; i < size; i++)
+        crc = TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+} // updateCrc(uint32_t, const unsigned char*, size_t)
+
+//--------------------------------------------------------------------------
+/**
+ Adds a 32-bit number to a buffer, most significant byte
+ first (as PNG and zlib store them).
+ 
+ @param buffer The buffer to add to.
+ @param value The number to add.
+ */
+static void appendBigEndian(std::vector<unsigned char>& buffer, uint32_t value)
+{
+    buffer.push_back((unsigned char)(value >> 24));
+    buffer.push_back((unsigned char)(value >> 16));
+    buffer.push_back((unsigned char)(value >> 8));
+    buffer.push_back((unsigned char)value);
+} // appendBigEndian(std::vector<unsigned char>&, uint32_t)
+
+//--------------------------------------------------------------------------
+/**
+ Writes one PNG chunk (length, type, data and CRC).
+ 
+ @param file The file to write to.
+ @param type The four letters of the chunk's type.
+ @param data The data of the chunk.
+ @param size How many bytes of data there are.
+ @return True if the chunk was written.
+ */
+static bool writeChunk(FILE* file, const char* type, const unsigned char* data, size_t size)
+{
+    std::vector<unsigned char> header;
+    appendBigEndian(header, (uint32_t)size);
+    header.insert(header.end(), type, type + 4);
+    uint32_t crc = updateCrc(0xFFFFFFFFu, (const unsigned char*)type, 4);
+    crc = updateCrc(crc, data, size);
+    std::vector<unsigned char> footer;
+    appendBigEndian(footer, crc ^ 0xFFFFFFFFu);
+    
+    return fwrite(&header[0], 1, header.size(), file) == header.size()
+        && (size == 0 || fwrite(data, 1, size, file) == size)
+        && fwrite(&footer[0], 1, footer.size(), file) == footer.size();
+} // writeChunk(FILE*, const char*, const unsigned char*, size_t)
+
+//--------------------------------------------------------------------------
+/**
+ Creates a capturer which saves into a folder (made when the
+ first frame is saved). Nothing is captured until a recording
+ is started or a screenshot is asked for. An OpenGL context
+ must already exist.
+ 
+ @param folder The path of the folder WITHOUT a final slash.
+ @param format How recordings are saved (PNG_SEQUENCE or
+ RAW_VIDEO).
+ */
+FrameCapture::FrameCapture(const std::string& folder, int format)
+{
+    m_folder = folder;
+    m_format = format;
+    
+    for(unsigned int i = 0; i < NUM_SLOTS; i++)
+    {
+        glGenBuffers(1, &m_slots[i].buffer);
+        m_slots[i].size = 0;
+        m_slots[i].fence = 0;
+    } // for
+    m_nextSlot = 0;
+    m_numPending = 0;
+    m_isRecording = false;
+    m_screenshotIsWanted = false;
+    m_isLossless = false;
+    m_numRecordings = 0;
+    m_numRecorded = 0;
+    m_numScreenshots = 0;
+    m_numFramesSeen = 0;
+    m_numSlotsDropped = 0;
+    m_maxFramesToMap = 0;
+    
+    m_isWriting = false;
+    m_mustStop = false;
+    m_numQueueDropped = 0;
+    m_numWritten = 0;
+    m_numFailed = 0;
+    m_totalLatencyMs = 0.0f;
+    m_maxLatencyMs = 0.0f;
+    
+    m_folderIsMade = false;
+    m_rawFile = NULL;
+    m_rawRecording = 0;
+    m_rawWidth = 0;
+    m_rawHeight = 0;
+    
+    m_writer = std::thread(&FrameCapture::writeFrames, this);
+} // FrameCapture::FrameCapture(const std::string&, int)
+
+//--------------------------------------------------------------------------
+/**
+ Destroys the capturer once every frame read so far is saved.
+ */
+FrameCapture::~FrameCapture()
+{
+    finish();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_mustStop = true;
+    }
+    m_frameQueued.notify_one();
+    m_writer.join();
+    
+    for(unsigned int i = 0; i < NUM_SLOTS; i++)
+        glDeleteBuffers(1, &m_slots[i].buffer);
+} // FrameCapture::~FrameCapture()
+
+//--------------------------------------------------------------------------
+/**
+ Starts recording every frame captured, as a new recording.
+ */
+void FrameCapture::startRecording()
+{
+    if(m_isRecording)
+        return;
+    m_isRecording = true;
+    m_numRecordings++;
+    m_numRecorded = 0;
+} // FrameCapture::startRecording()
+
+//--------------------------------------------------------------------------
+/**
+ Stops recording. Frames already read are still saved.
+ */
+void FrameCapture::stopRecording()
+{
+    m_isRecording = false;
+} // FrameCapture::stopRecording()
+
+//--------------------------------------------------------------------------
+/**
+ Saves the next frame captured as a PNG file.
+ */
+void FrameCapture::takeScreenshot()
+{
+    m_screenshotIsWanted = true;
+} // FrameCapture::takeScreenshot()
+
+//--------------------------------------------------------------------------
+/**
+ Sets whether every frame must be kept. A lossless capture
+ waits for the GPU and the writer when they fall behind, which
+ is only wanted when nobody is watching the frames as they are
+ drawn.
+ 
+ @param isLossless True to never drop frames.
+ */
+void FrameCapture::setLossless(bool isLossless)
+{
+    m_isLossless = isLossless;
+} // FrameCapture::setLossless(bool)
+
+//--------------------------------------------------------------------------
+/**
+ Called once per frame after everything is drawn and before
+ the buffers are swapped. Hands any slots the GPU has finished
+ to the writer and, if this frame is wanted, starts copying the
+ back buffer into the next slot. If the GPU has not finished
+ with that slot yet, the frame is dropped rather than waiting.
+ 
+ @param width The width of what is drawn in pixels.
+ @param height The height of what is drawn in pixels.
+ */
+void FrameCapture::capture(int width, int height)
+{
+    m_numFramesSeen++;
+    readFinishedSlots(false);
+    if(!m_isRecording && !m_screenshotIsWanted)
+        return;
+    if(m_numPending == NUM_SLOTS && m_isLossless)
+        readFinishedSlots(true);
+    if(m_numPending == NUM_SLOTS)
+    {
+        m_numSlotsDropped++; // A wanted screenshot waits for the next frame
+        return;
+    } // if
+    
+    // Copy the pixels into the buffer (the copy happens on the GPU later)
+    Slot& slot = m_slots[m_nextSlot];
+    GLsizeiptr size = (GLsizeiptr)width * height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if(slot.size != size)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        slot.size = size;
+    } // if
+    GLint readFramebuffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+    glReadBuffer(readFramebuffer == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0); // The window, or an offscreen framebuffer
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    
+    slot.width = width;
+    slot.height = height;
+    slot.isScreenshot = m_screenshotIsWanted;
+    slot.isRecorded = m_isRecording;
+    slot.screenshot = m_screenshotIsWanted ? m_numScreenshots++ : 0;
+    slot.recording = m_numRecordings;
+    slot.number = m_isRecording ? m_numRecorded++ : 0;
+    slot.frameRead = m_numFramesSeen;
+    slot.readTime = std::chrono::steady_clock::now();
+    m_screenshotIsWanted = false;
+    
+    m_nextSlot = (m_nextSlot + 1) % NUM_SLOTS;
+    m_numPending++;
+} // FrameCapture::capture(int, int)
+
+//--------------------------------------------------------------------------
+/**
+ Waits until every frame read so far has been saved.
+ */
+void FrameCapture::finish()
+{
+    readFinishedSlots(true);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(!m_queue.empty() || m_isWriting)
+        m_frameWritten.wait(lock);
+} // FrameCapture::finish()
+
+//--------------------------------------------------------------------------
+/**
+ Writes how many frames were saved and dropped, and how long
+ frames took to get from the GPU to the disk.
+ 
+ @param out The stream to write to.
+ */
+void FrameCapture::report(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    out << "Capture: " << m_numWritten << " frame(s) saved, "
+        << m_numSlotsDropped << " dropped waiting for the GPU, "
+        << m_numQueueDropped << " dropped waiting for the disk";
+    if(m_numFailed > 0)
+        out << ", " << m_numFailed << " failed to save";
+    if(m_numWritten > 0)
+        out << "; latency " << m_totalLatencyMs / m_numWritten << " ms average, "
+            << m_maxLatencyMs << " ms max (mapped up to " << m_maxFramesToMap << " frame(s) after reading)";
+    out << std::endl;
+} // FrameCapture::report(std::ostream&)
+
+//--------------------------------------------------------------------------
+/**
+ Hands every slot the GPU has finished to the writer, oldest
+ first. Slots finish in order, so this stops at the first one
+ that is not finished.
+ 
+ @param wait True to wait for the GPU to finish every slot.
+ */
+void FrameCapture::readFinishedSlots(bool wait)
+{
+    while(m_numPending > 0)
+    {
+        Slot& slot = m_slots[(m_nextSlot + NUM_SLOTS - m_numPending) % NUM_SLOTS];
+        GLuint64 timeout = wait ? 1000000000ull : 0; // Nanoseconds
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        if(status == GL_TIMEOUT_EXPIRED && !wait)
+            break;
+        
+        // Mapping waits for the copy if the wait above gave up
+        if(m_numFramesSeen - slot.frameRead > m_maxFramesToMap)
+            m_maxFramesToMap = m_numFramesSeen - slot.frameRead;
+        queueSlot(slot);
+        glDeleteSync(slot.fence);
+        slot.fence = 0;
+        m_numPending--;
+    } // while
+} // FrameCapture::readFinishedSlots(bool)
+
+//--------------------------------------------------------------------------
+/**
+ Copies the pixels of a finished slot into a frame (flipping
+ it so that the top row is first) and queues it for the
+ writer, unless the writer is already too far behind (a
+ lossless capture waits for it instead).
+ 
+ @param slot The slot to copy.
+ */
+void FrameCapture::queueSlot(Slot& slot)
+{
+    Frame frame;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while(m_isLossless && m_queue.size() >= MAX_QUEUED_FRAMES)
+            m_frameWritten.wait(lock);
+        if(m_queue.size() >= MAX_QUEUED_FRAMES)
+        {
+            m_numQueueDropped++;
+            return;
+        } // if
+        if(!m_freePixels.empty())
+        {
+            frame.pixels.swap(m_freePixels.back());
+            m_freePixels.pop_back();
+        } // if
+    }
+    
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT);
+    if(pixels)
+    {
+        // OpenGL reads the bottom row first
+        size_t rowSize = (size_t)slot.width * 4;
+        frame.pixels.resize(rowSize * slot.height);
+        for(int row = 0; row < slot.height; row++)
+            memcpy(&frame.pixels[rowSize * row], pixels + rowSize * (slot.height - 1 - row), rowSize);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } // if
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!pixels)
+    {
+        m_numFailed++;
+        m_freePixels.push_back(std::vector<unsigned char>());
+        m_freePixels.back().swap(frame.pixels);
+        return;
+    } // if
+    frame.width = slot.width;
+    frame.height = slot.height;
+    frame.isScreenshot = slot.isScreenshot;
+    frame.isRecorded = slot.isRecorded;
+    frame.screenshot = slot.screenshot;
+    frame.recording = slot.recording;
+    frame.number = slot.number;
+    frame.readTime = slot.readTime;
+    m_queue.push_back(Frame());
+    std::swap(m_queue.back(), frame);
+    m_frameQueued.notify_one();
+} // FrameCapture::queueSlot(Slot&)
+
+//--------------------------------------------------------------------------
+/**
+ Runs on the writer thread: saves queued frames until the
+ capturer is destroyed and nothing is left in the queue.
+ */
+void FrameCapture::writeFrames()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true)
+    {
+        while(m_queue.empty() && !m_mustStop)
+            m_frameQueued.wait(lock);
+        if(m_queue.empty())
+            break; // Told to stop, and everything is saved
+        
+        Frame frame;
+        std::swap(frame, m_queue.front());
+        m_queue.pop_front();
+        m_isWriting = true;
+        lock.unlock();
+        
+        bool isWritten = writeFrame(frame);
+        float latencyMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frame.readTime).count();
+        
+        lock.lock();
+        m_isWriting = false;
+        if(isWritten)
+        {
+            m_numWritten++;
+            m_totalLatencyMs += latencyMs;
+            if(latencyMs > m_maxLatencyMs)
+                m_maxLatencyMs = latencyMs;
+        } // if
+        else
+            m_numFailed++;
+        m_freePixels.push_back(std::vector<unsigned char>());
+        m_freePixels.back().swap(frame.pixels);
+        m_frameWritten.notify_all();
+    } // while
+    
+    if(m_rawFile)
+        fclose(m_rawFile);
+    m_rawFile = NULL;
+} // FrameCapture::writeFrames()
+
+//--------------------------------------------------------------------------
+/**
+ Saves one frame as a screenshot and/or as part of its
+ recording. Runs on the writer thread.
+ 
+ @param frame The frame to save.
+ @return True if everything was saved.
+ */
+bool FrameCapture::writeFrame(const Frame& frame)
+{
+    if(!m_folderIsMade)
+    {
+        mkdir(m_folder.c_str(), 0755); // Fails harmlessly if it is already there
+        m_folderIsMade = true;
+    } // if
+    
+    bool isWritten = true;
+    char name[64];
+    if(frame.isScreenshot)
+    {
+        snprintf(name, sizeof(name), "/screenshot_%03u.png", frame.screenshot);
+        isWritten = writePng(m_folder + name, frame) && isWritten;
+    } // if
+    if(frame.isRecorded && m_format == RAW_VIDEO)
+        isWritten = writeRaw(frame) && isWritten;
+    else if(frame.isRecorded)
+    {
+        snprintf(name, sizeof(name), "/recording_%03u_%06u.png", frame.recording, frame.number);
+        isWritten = writePng(m_folder + name, frame) && isWritten;
+    } // else if
+    return isWritten;
+} // FrameCapture::writeFrame(const Frame&)
+
+//--------------------------------------------------------------------------
+/**
+ Saves a frame as a PNG file. The image data is stored without
+ compression (as stored deflate blocks), since compressing
+ every frame would make the writer fall behind.
+ 
+ @param path The path of the file.
+ @param frame The frame to save.
+ @return True if the file was saved.
+ */
+bool FrameCapture::writePng(const std::string& path, const Frame& frame)
+{
+    static const unsigned char SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    static const size_t MAX_BLOCK = 65535; // Largest stored deflate block
+    
+    // 8-bit RGBA, no interlacing
+    std::vector<unsigned char> header;
+    appendBigEndian(header, (uint32_t)frame.width);
+    appendBigEndian(header, (uint32_t)frame.height);
+    header.push_back(8);
+    header.push_back(6);
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+    
+    // Each row starts with its filter type (0 for none)
+    size_t rowSize = (size_t)frame.width * 4;
+    std::vector<unsigned char> rows;
+    rows.reserve((rowSize + 1) * frame.height);
+    for(int row = 0; row < frame.height; row++)
+    {
+        rows.push_back(0);
+        rows.insert(rows.end(), frame.pixels.begin() + rowSize * row, frame.pixels.begin() + rowSize * (row + 1));
+    } // for
+    
+    // zlib stream of stored blocks, then the Adler-32 of the rows
+    std::vector<unsigned char> data;
+    data.reserve(rows.size() + rows.size() / MAX_BLOCK * 5 + 16);
+    data.push_back(0x78);
+    data.push_back(0x01);
+    size_t offset = 0;
+    do
+    {
+        size_t blockSize = std::min(MAX_BLOCK, rows.size() - offset);
+        bool isLast = (offset + blockSize == rows.size());
+        data.push_back(isLast ? 1 : 0);
+        data.push_back((unsigned char)blockSize);
+        data.push_back((unsigned char)(blockSize >> 8));
+        data.push_back((unsigned char)~blockSize);
+        data.push_back((unsigned char)(~blockSize >> 8));
+        data.insert(data.end(), rows.begin() + offset, rows.begin() + offset + blockSize);
+        offset += blockSize;
+    } while(offset < rows.size());
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for(size_t i = 0; i < rows.size(); i++)
+    {
+        a = (a + rows[i]) % 65521;
+        b = (b + a) % 65521;
+    } // for
+    appendBigEndian(data, (b << 16) | a);
+    
+    FILE* file = fopen(path.c_str(), "wb");
+    if(!file)
+        return false;
+    bool isWritten = fwrite(SIGNATURE, 1, sizeof(SIGNATURE), file) == sizeof(SIGNATURE)
+                  && writeChunk(file, "IHDR", &header[0], header.size())
+                  && writeChunk(file, "IDAT", &data[0], data.size())
+                  && writeChunk(file, "IEND", NULL, 0);
+    return (fclose(file) == 0) && isWritten;
+} // FrameCapture::writePng(const std::string&, const Frame&)
+
+//--------------------------------------------------------------------------
+/**
+ Adds a frame to the raw video file of its recording. A new
+ file is started for each recording (and whenever the size of
+ the frames changes), named with the size so that it can be
+ read back, e.g. with
+ ffmpeg -f rawvideo -pix_fmt rgba -s 800x600 -r 60 -i file.rgba
+ 
+ @param frame The frame to save.
+ @return True if the frame was saved.
+ */
+bool FrameCapture::writeRaw(const Frame& frame)
+{
+    if(!m_rawFile || m_rawRecording != frame.recording || m_rawWidth != frame.width || m_rawHeight != frame.height)
+    {
+        if(m_rawFile)
+            fclose(m_rawFile);
+        char name[64];
+        snprintf(name, sizeof(name), "/recording_%03u_%dx%d_%06u.rgba", frame.recording, frame.width, frame.height, frame.number);
+        m_rawFile = fopen((m_folder + name).c_str(), "wb");
+        m_rawRecording = frame.recording;
+        m_rawWidth = frame.width;
+        m_rawHeight = frame.height;
+    } // if
+    return m_rawFile && fwrite(&frame.pixels[0], 1, frame.pixels.size(), m_rawFile) == frame.pixels.size();
+} // FrameCapture::writeRaw(const Frame&)
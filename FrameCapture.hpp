@@ -0,0 +1,144 @@
+/**
+ FrameCapture.hpp
+ Virtual Keyboard
+ Class which captures what is drawn, for screenshots and for
+ recording video. The back buffer is read into a ring of pixel
+ buffer objects, which are only mapped a few frames later once
+ the GPU has finished copying into them, so capturing never
+ makes the CPU wait for the GPU. The pixels are then handed to
+ a writer thread which saves them as a sequence of PNG files or
+ as one file of raw RGBA video. Frames which cannot be captured
+ without waiting are dropped (and counted) instead, unless the
+ capture is lossless (for offline rendering).
+ 
+ @author Graeme Zinck
+ @version 1.0 4/24/2018
+ */
+
+#ifndef FrameCapture_hpp
+#define FrameCapture_hpp
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FrameCapture
+{
+public:
+    FrameCapture(const std::string& folder, int format);
+    virtual ~FrameCapture();
+    
+    void startRecording();
+    void stopRecording();
+    void takeScreenshot();
+    void setLossless(bool isLossless);
+    void capture(int width, int height);
+    void finish();
+    void report(std::ostream& out);
+    
+    /**
+     Gets whether every frame is being recorded.
+     */
+    inline bool isRecording() { return m_isRecording; }
+    
+    // How recordings are saved (screenshots are always PNG files)
+    enum
+    {
+        PNG_SEQUENCE, // One PNG file per frame
+        RAW_VIDEO, // One file of top-down RGBA frames per recording
+        
+        NUM_FORMATS
+    };
+private:
+    // One pixel buffer in the ring
+    struct Slot
+    {
+        GLuint buffer;
+        GLsizeiptr size; // Bytes allocated for the buffer
+        GLsync fence; // Signalled once the GPU has copied the pixels
+        int width;
+        int height;
+        bool isScreenshot;
+        bool isRecorded;
+        unsigned int screenshot; // Number of the screenshot
+        unsigned int recording; // Number of the recording
+        unsigned int number; // Number of the frame in its recording
+        unsigned int frameRead; // Value of m_numFramesSeen when the pixels were read
+        std::chrono::steady_clock::time_point readTime;
+    }; // Slot
+    
+    // One frame waiting for the writer thread
+    struct Frame
+    {
+        std::vector<unsigned char> pixels; // RGBA, top row first
+        int width;
+        int height;
+        bool isScreenshot;
+        bool isRecorded;
+        unsigned int screenshot;
+        unsigned int recording;
+        unsigned int number;
+        std::chrono::steady_clock::time_point readTime;
+    }; // Frame
+    
+    void readFinishedSlots(bool wait);
+    void queueSlot(Slot& slot);
+    void writeFrames();
+    bool writeFrame(const Frame& frame);
+    bool writePng(const std::string& path, const Frame& frame);
+    bool writeRaw(const Frame& frame);
+    
+    static const unsigned int NUM_SLOTS = 3; // Frames the GPU may fall behind before one is dropped
+    static const unsigned int MAX_QUEUED_FRAMES = 8; // Frames the writer may fall behind before one is dropped
+    
+    std::string m_folder;
+    int m_format;
+    
+    // Used only by the render thread
+    Slot m_slots[NUM_SLOTS];
+    unsigned int m_nextSlot; // Where in the ring the next frame is read
+    unsigned int m_numPending; // Slots before m_nextSlot which have not been mapped
+    bool m_isRecording;
+    bool m_screenshotIsWanted;
+    bool m_isLossless; // Wait instead of dropping frames
+    unsigned int m_numRecordings;
+    unsigned int m_numRecorded; // Frames read in the current recording
+    unsigned int m_numScreenshots;
+    unsigned int m_numFramesSeen; // Calls to capture()
+    unsigned int m_numSlotsDropped; // Frames skipped because every slot was in use
+    unsigned int m_maxFramesToMap; // Most frames between reading a slot and mapping it
+    
+    // Shared with the writer thread (guarded by m_mutex)
+    std::mutex m_mutex;
+    std::condition_variable m_frameQueued; // Signalled when a frame is queued or the thread must stop
+    std::condition_variable m_frameWritten; // Signalled whenever the writer finishes a frame
+    std::deque<Frame> m_queue;
+    std::vector<std::vector<unsigned char> > m_freePixels; // Pixel arrays to reuse
+    bool m_isWriting; // The writer is saving a frame it took off the queue
+    bool m_mustStop;
+    unsigned int m_numQueueDropped; // Frames skipped because the writer was too far behind
+    unsigned int m_numWritten;
+    unsigned int m_numFailed;
+    float m_totalLatencyMs; // From reading the pixels until they are on disk
+    float m_maxLatencyMs;
+    
+    // Used only by the writer thread
+    bool m_folderIsMade;
+    FILE* m_rawFile;
+    unsigned int m_rawRecording; // Recording the raw file belongs to
+    int m_rawWidth;
+    int m_rawHeight;
+    
+    std::thread m_writer;
+}; // FrameCapture
+
+#endif /* FrameCapture_hpp */
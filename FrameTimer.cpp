@@ -0,0 +1,278 @@
+/**
+ FrameTimer.cpp
+ Virtual Keyboard
+ Implementation of FrameTimer.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/22/2018
+ */
+
+#include "FrameTimer.hpp"
+#include <algorithm>
+#include <iomanip>
+
+//--------------------------------------------------------------------------
+/**
+ Creates a timer, with the queries for the ring of frames if
+ the GPU can be timed. The OpenGL context must be current.
+ */
+FrameTimer::FrameTimer()
+{
+    // Timestamp queries are core in OpenGL 3.3 (llvmpipe has them too)
+    m_hasGpuTimer = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    if(m_hasGpuTimer)
+    {
+        for(unsigned int i = 0; i < NUM_QUERY_FRAMES; i++)
+            glGenQueries(NUM_TIMESTAMPS, m_queryFrames[i].queries);
+    } // if
+    m_nextFrame = 0;
+    m_numPending = 0;
+    m_current = NULL;
+    
+    for(int i = 0; i < NUM_METRICS; i++)
+    {
+        m_windows[i].samples.reserve(WINDOW_SIZE);
+        m_windows[i].next = 0;
+        m_latest[i] = 0.0f;
+    } // for
+    m_hasInputTimes = false;
+    m_numFrames = 0;
+    m_numGpuFramesSkipped = 0;
+} // FrameTimer::FrameTimer()
+
+//--------------------------------------------------------------------------
+/**
+ Destroys the timer and its queries.
+ */
+FrameTimer::~FrameTimer()
+{
+    if(m_hasGpuTimer)
+    {
+        for(unsigned int i = 0; i < NUM_QUERY_FRAMES; i++)
+            glDeleteQueries(NUM_TIMESTAMPS, m_queryFrames[i].queries);
+    } // if
+} // FrameTimer::~FrameTimer()
+
+//--------------------------------------------------------------------------
+/**
+ Starts timing a frame. The results of earlier frames that
+ the GPU has finished are read first. If the GPU is so far
+ behind that every frame in the ring is still waiting, this
+ frame is only timed on the CPU.
+ */
+void FrameTimer::beginFrame()
+{
+    m_frameStart = std::chrono::steady_clock::now();
+    m_current = NULL;
+    if(!m_hasGpuTimer)
+        return;
+    
+    readFinishedFrames();
+    if(m_numPending == NUM_QUERY_FRAMES)
+    {
+        m_numGpuFramesSkipped++;
+        return;
+    } // if
+    
+    m_current = &m_queryFrames[m_nextFrame];
+    for(int i = 0; i < NUM_PASSES; i++)
+        m_current->passIsTimed[i] = false;
+    glQueryCounter(m_current->queries[FRAME_BEGIN_T], GL_TIMESTAMP);
+} // FrameTimer::beginFrame()
+
+//--------------------------------------------------------------------------
+/**
+ Marks the start of a pass on the GPU.
+ 
+ @param pass Which pass is starting.
+ */
+void FrameTimer::beginPass(int pass)
+{
+    if(!m_current)
+        return;
+    glQueryCounter(m_current->queries[PASS_BEGIN_T + 2 * pass], GL_TIMESTAMP);
+} // FrameTimer::beginPass(int)
+
+//--------------------------------------------------------------------------
+/**
+ Marks the end of a pass on the GPU.
+ 
+ @param pass Which pass is ending.
+ */
+void FrameTimer::endPass(int pass)
+{
+    if(!m_current)
+        return;
+    glQueryCounter(m_current->queries[PASS_BEGIN_T + 2 * pass + 1], GL_TIMESTAMP);
+    m_current->passIsTimed[pass] = true;
+} // FrameTimer::endPass(int)
+
+//--------------------------------------------------------------------------
+/**
+ Marks the end of the frame's drawing, just before the
+ buffers are swapped.
+ */
+void FrameTimer::beginSwap()
+{
+    m_swapStart = std::chrono::steady_clock::now();
+    if(!m_current)
+        return;
+    glQueryCounter(m_current->queries[FRAME_END_T], GL_TIMESTAMP);
+    m_nextFrame = (m_nextFrame + 1) % NUM_QUERY_FRAMES;
+    m_numPending++;
+    m_current = NULL;
+} // FrameTimer::beginSwap()
+
+//--------------------------------------------------------------------------
+/**
+ Finishes timing a frame, just after the buffers are swapped.
+ The GPU times of this frame are added later, once the GPU
+ has finished it.
+ */
+void FrameTimer::endFrame()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    addSample(CPU_FRAME_M, std::chrono::duration<float, std::milli>(now - m_frameStart).count());
+    addSample(CPU_SWAP_M, std::chrono::duration<float, std::milli>(now - m_swapStart).count());
+    
+    // Only frames that show new mouse motion say how long it took to show
+    if(m_hasInputTimes && m_drawnInput > m_lastDrawnInput)
+    {
+        addSample(INPUT_TO_SWAP_M, std::chrono::duration<float, std::milli>(now - m_drawnInput).count());
+        addSample(SNAPSHOT_INPUT_TO_SWAP_M, std::chrono::duration<float, std::milli>(now - m_snapshotInput).count());
+        m_lastDrawnInput = m_drawnInput;
+    } // if
+    m_hasInputTimes = false;
+    m_numFrames++;
+} // FrameTimer::endFrame()
+
+//--------------------------------------------------------------------------
+/**
+ Sets when the mouse motion shown in this frame was handled,
+ so that the time until it is on screen can be measured at the
+ end of the frame. Both times are measured, so one run shows
+ the latency with and without late latching.
+ 
+ @param drawnInput When the mouse motion of the rotation drawn
+ was handled.
+ @param snapshotInput When the mouse motion of the rotation in
+ the frame's snapshot was handled.
+ */
+void FrameTimer::setInputTimes(std::chrono::steady_clock::time_point drawnInput, std::chrono::steady_clock::time_point snapshotInput)
+{
+    m_hasInputTimes = true;
+    m_drawnInput = drawnInput;
+    m_snapshotInput = snapshotInput;
+} // FrameTimer::setInputTimes(std::chrono::steady_clock::time_point, std::chrono::steady_clock::time_point)
+
+//--------------------------------------------------------------------------
+/**
+ Reads the results of the pending frames, oldest first, until
+ one is found that the GPU has not finished. The GPU finishes
+ commands in order, so once the last timestamp of a frame is
+ available, all of them are.
+ */
+void FrameTimer::readFinishedFrames()
+{
+    while(m_numPending > 0)
+    {
+        QueryFrame& frame = m_queryFrames[(m_nextFrame + NUM_QUERY_FRAMES - m_numPending) % NUM_QUERY_FRAMES];
+        GLint isAvailable = GL_FALSE;
+        glGetQueryObjectiv(frame.queries[FRAME_END_T], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+        if(!isAvailable)
+            return;
+        
+        GLuint64 timestamps[NUM_TIMESTAMPS];
+        glGetQueryObjectui64v(frame.queries[FRAME_BEGIN_T], GL_QUERY_RESULT, &timestamps[FRAME_BEGIN_T]);
+        glGetQueryObjectui64v(frame.queries[FRAME_END_T], GL_QUERY_RESULT, &timestamps[FRAME_END_T]);
+        addSample(GPU_FRAME_M, (timestamps[FRAME_END_T] - timestamps[FRAME_BEGIN_T]) / 1.0e6f);
+        for(int i = 0; i < NUM_PASSES; i++)
+        {
+            if(!frame.passIsTimed[i])
+                continue;
+            int begin = PASS_BEGIN_T + 2 * i;
+            glGetQueryObjectui64v(frame.queries[begin], GL_QUERY_RESULT, &timestamps[begin]);
+            glGetQueryObjectui64v(frame.queries[begin + 1], GL_QUERY_RESULT, &timestamps[begin + 1]);
+            addSample(GPU_FRAME_M + 1 + i, (timestamps[begin + 1] - timestamps[begin]) / 1.0e6f);
+        } // for
+        m_numPending--;
+    } // while
+} // FrameTimer::readFinishedFrames()
+
+//--------------------------------------------------------------------------
+/**
+ Adds a time to a metric's window, replacing the oldest one
+ once the window is full.
+ 
+ @param metric Which metric the time is for.
+ @param ms The time in milliseconds.
+ */
+void FrameTimer::addSample(int metric, float ms)
+{
+    Window& window = m_windows[metric];
+    if(window.samples.size() < WINDOW_SIZE)
+        window.samples.push_back(ms);
+    else
+        window.samples[window.next] = ms;
+    window.next = (window.next + 1) % WINDOW_SIZE;
+    m_latest[metric] = ms;
+} // FrameTimer::addSample(int, float)
+
+//--------------------------------------------------------------------------
+/**
+ Gets a percentile of the times in a metric's window.
+ 
+ @param metric Which metric to look at.
+ @param percentile The percentile, from 0 to 100 (50 is the median).
+ @return The time in milliseconds (0 if there are no times yet).
+ */
+float FrameTimer::getPercentile(int metric, float percentile)
+{
+    const std::vector<float>& samples = m_windows[metric].samples;
+    if(samples.empty())
+        return 0.0f;
+    
+    m_sorted = samples;
+    size_t rank = (size_t)(percentile / 100.0f * (m_sorted.size() - 1) + 0.5f);
+    std::nth_element(m_sorted.begin(), m_sorted.begin() + rank, m_sorted.end());
+    return m_sorted[rank];
+} // FrameTimer::getPercentile(int, float)
+
+//--------------------------------------------------------------------------
+/**
+ Gets the most recent time of a metric.
+ 
+ @param metric Which metric to look at.
+ @return The time in milliseconds (0 if there are no times yet).
+ */
+float FrameTimer::getLatest(int metric)
+{
+    return m_latest[metric];
+} // FrameTimer::getLatest(int)
+
+//--------------------------------------------------------------------------
+/**
+ Writes the median, 95th, and 99th percentiles of every
+ metric on one line. Comparing the swap time with the GPU
+ frame time shows whether a slow swap is waiting on the GPU.
+ 
+ @param out Where to write the report.
+ */
+void FrameTimer::report(std::ostream& out)
+{
+    const char* NAMES[NUM_METRICS] = { "CPU frame", "swap", "GPU frame", "GPU shadows", "GPU keys", "GPU HUD", "input to swap", "input to swap (unlatched)" };
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << "Frame times over " << m_windows[CPU_FRAME_M].samples.size() << " frames (p50/p95/p99 ms):" << std::fixed << std::setprecision(2);
+    for(int i = 0; i < NUM_METRICS; i++)
+    {
+        if(m_windows[i].samples.empty())
+            continue;
+        out << " " << NAMES[i] << " " << getPercentile(i, 50.0f) << "/" << getPercentile(i, 95.0f) << "/" << getPercentile(i, 99.0f) << ";";
+    } // for
+    if(m_numGpuFramesSkipped > 0)
+        out << " " << m_numGpuFramesSkipped << " frame(s) not timed on the GPU;";
+    out << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+} // FrameTimer::report(std::ostream&)
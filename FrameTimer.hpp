@@ -0,0 +1,134 @@
+/**
+ FrameTimer.hpp
+ Virtual Keyboard
+ Class which times every frame on the CPU and, with timestamp
+ queries, on the GPU (the whole frame and each main pass). The
+ queries of the last few frames are kept in a ring and only read
+ once the GPU has finished them, so timing never makes the CPU
+ wait. It also times how long mouse motion takes to reach the
+ screen. Times are kept in rolling windows and reported as
+ percentiles.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/22/2018
+ */
+
+#ifndef FrameTimer_hpp
+#define FrameTimer_hpp
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+class FrameTimer
+{
+public:
+    FrameTimer();
+    virtual ~FrameTimer();
+    
+    void beginFrame();
+    void beginPass(int pass);
+    void endPass(int pass);
+    void beginSwap();
+    void endFrame();
+    void setInputTimes(std::chrono::steady_clock::time_point drawnInput, std::chrono::steady_clock::time_point snapshotInput);
+    float getPercentile(int metric, float percentile);
+    float getLatest(int metric);
+    void report(std::ostream& out);
+    
+    /**
+     Gets whether the GPU can be timed (GL_ARB_timer_query).
+     */
+    inline bool hasGpuTimer() { return m_hasGpuTimer; }
+    /**
+     Gets how many frames have been timed.
+     */
+    inline unsigned int getNumFrames() { return m_numFrames; }
+    /**
+     Gets how many frames were not timed on the GPU because
+     the GPU was too far behind to reuse their queries.
+     */
+    inline unsigned int getNumGpuFramesSkipped() { return m_numGpuFramesSkipped; }
+    
+    // The passes which are timed on the GPU
+    enum
+    {
+        SHADOW_PASS,
+        KEYS_PASS,
+        HUD_PASS,
+        
+        NUM_PASSES
+    };
+    
+    // What is timed (in milliseconds)
+    enum
+    {
+        CPU_FRAME_M, // From beginFrame() until the buffers are swapped
+        CPU_SWAP_M, // Spent in SDL_GL_SwapWindow (waiting for the GPU if it is behind)
+        GPU_FRAME_M,
+        GPU_SHADOW_PASS_M, // One per pass, in the same order as the passes
+        GPU_KEYS_PASS_M,
+        GPU_HUD_PASS_M,
+        INPUT_TO_SWAP_M, // From the newest mouse motion drawn until the buffers are swapped
+        SNAPSHOT_INPUT_TO_SWAP_M, // The same, for the mouse motion in the frame's snapshot (without late latching)
+        
+        NUM_METRICS
+    };
+private:
+    // Timestamps recorded in each frame
+    enum
+    {
+        FRAME_BEGIN_T,
+        FRAME_END_T,
+        PASS_BEGIN_T, // Then the end of the first pass, the beginning of the next, ...
+        
+        NUM_TIMESTAMPS = PASS_BEGIN_T + 2 * NUM_PASSES
+    };
+    
+    // The queries of one frame
+    struct QueryFrame
+    {
+        GLuint queries[NUM_TIMESTAMPS];
+        bool passIsTimed[NUM_PASSES];
+    }; // QueryFrame
+    
+    // The last times of one metric
+    struct Window
+    {
+        std::vector<float> samples;
+        unsigned int next; // Where the next sample goes
+    }; // Window
+    
+    void readFinishedFrames();
+    void addSample(int metric, float ms);
+    
+    static const unsigned int NUM_QUERY_FRAMES = 4; // Frames the GPU may fall behind before one is skipped
+    static const unsigned int WINDOW_SIZE = 240; // Samples the percentiles are taken over
+    
+    bool m_hasGpuTimer;
+    QueryFrame m_queryFrames[NUM_QUERY_FRAMES];
+    unsigned int m_nextFrame; // Where in the ring the next frame is recorded
+    unsigned int m_numPending; // Frames before m_nextFrame the GPU may not have finished
+    QueryFrame* m_current; // Frame being recorded (NULL if the GPU is not timed this frame)
+    
+    std::chrono::steady_clock::time_point m_frameStart;
+    std::chrono::steady_clock::time_point m_swapStart;
+    
+    // Mouse motion drawn in this frame and the last one timed
+    bool m_hasInputTimes;
+    std::chrono::steady_clock::time_point m_drawnInput;
+    std::chrono::steady_clock::time_point m_snapshotInput;
+    std::chrono::steady_clock::time_point m_lastDrawnInput;
+    
+    Window m_windows[NUM_METRICS];
+    float m_latest[NUM_METRICS];
+    std::vector<float> m_sorted; // Scratch space for percentiles
+    
+    unsigned int m_numFrames;
+    unsigned int m_numGpuFramesSkipped;
+}; // FrameTimer
+
+#endif /* FrameTimer_hpp */
@@ -0,0 +1,133 @@
+/**
+ Frustum.cpp
+ Virtual Keyboard
+ Implementation of Frustum.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/14/2018
+ */
+
+#include "Frustum.hpp"
+#include <math.h>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define FRUSTUM_USE_SSE
+#endif
+
+//--------------------------------------------------------------------------
+/**
+ Creates a frustum where every plane accepts everything
+ (so all boxes are visible until update() is called).
+ */
+Frustum::Frustum()
+{
+    for(int i = 0; i < NUM_PADDED_PLANES; i++)
+    {
+        m_planeX[i] = 0.0f;
+        m_planeY[i] = 0.0f;
+        m_planeZ[i] = 0.0f;
+        m_planeW[i] = 1.0f;
+    } // for
+} // Frustum::Frustum()
+
+//--------------------------------------------------------------------------
+/**
+ Extracts the six clipping planes (left, right, bottom,
+ top, near, far) from a view-projection matrix. Each
+ plane is a sum or difference of the fourth row of the
+ matrix and one of the other rows (Gribb/Hartmann).
+ The two padding planes are left as (0, 0, 0, 1), which
+ every point is inside of.
+ 
+ @param viewProjection The camera's view-projection matrix.
+ */
+void Frustum::update(const glm::mat4& viewProjection)
+{
+    // glm matrices are column-major, so row r is (m[0][r], m[1][r], m[2][r], m[3][r])
+    const glm::mat4& m = viewProjection;
+    for(int i = 0; i < NUM_PLANES; i++)
+    {
+        int row = i / 2; // x for left/right, y for bottom/top, z for near/far
+        float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+        float a = m[0][3] + sign * m[0][row];
+        float b = m[1][3] + sign * m[1][row];
+        float c = m[2][3] + sign * m[2][row];
+        float d = m[3][3] + sign * m[3][row];
+        
+        // Normalize so that distances are comparable between planes
+        float length = sqrtf(a * a + b * b + c * c);
+        if(length > 0.0f)
+        {
+            a /= length;
+            b /= length;
+            c /= length;
+            d /= length;
+        } // if
+        m_planeX[i] = a;
+        m_planeY[i] = b;
+        m_planeZ[i] = c;
+        m_planeW[i] = d;
+    } // for
+} // Frustum::update(const glm::mat4&)
+
+//--------------------------------------------------------------------------
+/**
+ Checks if an axis-aligned bounding box is at least partly
+ inside the frustum. For every plane, only the corner of the
+ box that is furthest along the plane's normal is tested: if
+ even that corner is behind the plane, the whole box is.
+ This is conservative (a few boxes near the corners of the
+ frustum are reported visible when they are not), which is
+ fine for culling.
+ 
+ @param boxMin The minimum corner of the box in world coordinates.
+ @param boxMax The maximum corner of the box in world coordinates.
+ @return True if the box may be visible.
+ */
+bool Frustum::boxIsVisible(const glm::vec3& boxMin, const glm::vec3& boxMax) const
+{
+#ifdef FRUSTUM_USE_SSE
+    const __m128 minX = _mm_set1_ps(boxMin.x);
+    const __m128 minY = _mm_set1_ps(boxMin.y);
+    const __m128 minZ = _mm_set1_ps(boxMin.z);
+    const __m128 maxX = _mm_set1_ps(boxMax.x);
+    const __m128 maxY = _mm_set1_ps(boxMax.y);
+    const __m128 maxZ = _mm_set1_ps(boxMax.z);
+    const __m128 zero = _mm_setzero_ps();
+    
+    // Test four planes at a time
+    for(int i = 0; i < NUM_PADDED_PLANES; i += 4)
+    {
+        __m128 nx = _mm_load_ps(&m_planeX[i]);
+        __m128 ny = _mm_load_ps(&m_planeY[i]);
+        __m128 nz = _mm_load_ps(&m_planeZ[i]);
+        __m128 nw = _mm_load_ps(&m_planeW[i]);
+        
+        // Choose the max corner where the normal is positive, else the min corner
+        __m128 maskX = _mm_cmpgt_ps(nx, zero);
+        __m128 maskY = _mm_cmpgt_ps(ny, zero);
+        __m128 maskZ = _mm_cmpgt_ps(nz, zero);
+        __m128 px = _mm_or_ps(_mm_and_ps(maskX, maxX), _mm_andnot_ps(maskX, minX));
+        __m128 py = _mm_or_ps(_mm_and_ps(maskY, maxY), _mm_andnot_ps(maskY, minY));
+        __m128 pz = _mm_or_ps(_mm_and_ps(maskZ, maxZ), _mm_andnot_ps(maskZ, minZ));
+        
+        // dot(n, p) + w for the four planes
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, px), _mm_mul_ps(ny, py)),
+                                 _mm_add_ps(_mm_mul_ps(nz, pz), nw));
+        if(_mm_movemask_ps(_mm_cmplt_ps(dist, zero)) != 0)
+            return false;
+    } // for
+    return true;
+#else
+    for(int i = 0; i < NUM_PLANES; i++)
+    {
+        float px = (m_planeX[i] > 0.0f) ? boxMax.x : boxMin.x;
+        float py = (m_planeY[i] > 0.0f) ? boxMax.y : boxMin.y;
+        float pz = (m_planeZ[i] > 0.0f) ? boxMax.z : boxMin.z;
+        if(m_planeX[i] * px + m_planeY[i] * py + m_planeZ[i] * pz + m_planeW[i] < 0.0f)
+            return false;
+    } // for
+    return true;
+#endif
+} // Frustum::boxIsVisible(const glm::vec3&, const glm::vec3&)
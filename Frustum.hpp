@@ -0,0 +1,39 @@
+/**
+ Frustum.hpp
+ Virtual Keyboard
+ Class for a view frustum which is extracted from the camera's
+ view-projection matrix and used to check whether bounding boxes
+ can be seen before anything is drawn.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/14/2018
+ */
+
+#ifndef Frustum_hpp
+#define Frustum_hpp
+
+#include <glm/glm.hpp>
+
+class Frustum
+{
+public:
+    Frustum();
+    
+    void update(const glm::mat4& viewProjection);
+    bool boxIsVisible(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+private:
+    // Six planes, padded to eight so that the planes can
+    // be tested four at a time with SIMD instructions.
+    static const int NUM_PLANES = 6;
+    static const int NUM_PADDED_PLANES = 8;
+    
+    // Planes stored as structure-of-arrays, where plane i is
+    // (m_planeX[i], m_planeY[i], m_planeZ[i], m_planeW[i]) and
+    // a point p is inside the plane if dot(n, p) + w >= 0.
+    alignas(16) float m_planeX[NUM_PADDED_PLANES];
+    alignas(16) float m_planeY[NUM_PADDED_PLANES];
+    alignas(16) float m_planeZ[NUM_PADDED_PLANES];
+    alignas(16) float m_planeW[NUM_PADDED_PLANES];
+}; // Frustum
+
+#endif /* Frustum_hpp */
@@ -0,0 +1,384 @@
+/**
+ KeyBatch.cpp
+ Virtual Keyboard
+ Implementation of KeyBatch.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/15/2018
+ */
+
+#include "KeyBatch.hpp"
+#include <algorithm>
+
+//--------------------------------------------------------------------------
+/**
+ Creates an empty batch. Variants and draws are added
+ afterwards, and then the batch is uploaded to the GPU.
+ 
+ @param shader A shader from a ShaderLibrary with the
+ KEY_BATCH_F feature.
+ */
+KeyBatch::KeyBatch(Shader* shader)
+{
+    m_shader = shader;
+    m_isUploaded = false;
+    m_indexType = GL_UNSIGNED_INT;
+    m_numBytes = 0;
+    m_numUnpackedBytes = 0;
+    m_vertexSize = 0;
+    m_materialsChanged = false;
+    for(unsigned int i = 0; i < MAX_MATERIALS; i++)
+        m_materials[i].isChanged = false;
+    m_vertexArrayObject = 0;
+    for(unsigned int i = 0; i < NUM_BUFFERS; i++)
+        m_buffers[i] = 0;
+    
+    // Nothing to upload yet
+    m_firstDirtyCommand = 1;
+    m_lastDirtyCommand = 0;
+    m_firstDirtyData = 1;
+    m_lastDirtyData = 0;
+} // KeyBatch::KeyBatch(Shader*)
+
+//--------------------------------------------------------------------------
+/**
+ Destroys the batch and its buffers on the GPU.
+ */
+KeyBatch::~KeyBatch()
+{
+    if(m_isUploaded)
+    {
+        glDeleteBuffers(NUM_BUFFERS, m_buffers);
+        glDeleteVertexArrays(1, &m_vertexArrayObject);
+    } // if
+} // KeyBatch::~KeyBatch()
+
+//--------------------------------------------------------------------------
+/**
+ Checks if the OpenGL context can draw a batch. This
+ needs multi-draw-indirect and commands with a base
+ instance (OpenGL 4.3, or the ARB extensions).
+ 
+ @return True if the batch can be used.
+ */
+bool KeyBatch::isSupported()
+{
+    return GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+} // KeyBatch::isSupported()
+
+//--------------------------------------------------------------------------
+/**
+ Adds the geometry for one kind of key to the merged
+ vertex and index buffers.
+ 
+ @param vertices The vertices of the key.
+ @param numVertices The number of vertices.
+ @param indices The indices of the triangles of the key.
+ @param numIndices The number of indices.
+ @return The index of the variant, to be used in addDraw().
+ */
+unsigned int KeyBatch::addVariant(Vertex* vertices, unsigned int numVertices, unsigned int* indices, unsigned int numIndices)
+{
+    Variant variant;
+    variant.count = numIndices;
+    variant.firstIndex = (GLuint)m_model.indices.size();
+    variant.baseVertex = (GLint)m_model.positions.size();
+    variant.numVertices = numVertices;
+    
+    for(unsigned int i = 0; i < numVertices; i++)
+    {
+        m_model.positions.push_back(*vertices[i].getPos());
+        m_model.normals.push_back(glm::normalize(*vertices[i].getNormal())); // So the shader doesn't have to
+    } // for
+    
+    // Indices stay relative to the variant (baseVertex offsets them)
+    for(unsigned int i = 0; i < numIndices; i++)
+        m_model.indices.push_back(indices[i]);
+    
+    m_variants.push_back(variant);
+    return (unsigned int)m_variants.size() - 1;
+} // KeyBatch::addVariant(Vertex*, unsigned int, unsigned int*, unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Adds a key to the batch.
+ 
+ @param variant Which kind of key it is (from addVariant()).
+ @param material Which material to draw it with (less than
+ MAX_MATERIALS).
+ @param translation Where the key is in the world.
+ @return The index of the draw, used to update it later.
+ */
+unsigned int KeyBatch::addDraw(unsigned int variant, unsigned int material, const glm::vec3& translation)
+{
+    DrawCommand command;
+    command.count = m_variants[variant].count;
+    command.instanceCount = 1;
+    command.firstIndex = m_variants[variant].firstIndex;
+    command.baseVertex = m_variants[variant].baseVertex;
+    command.baseInstance = (GLuint)m_commands.size(); // Picks this draw's data in the shader
+    
+    m_commands.push_back(command);
+    m_drawData.push_back(glm::vec4(translation, (float)material));
+    m_drawVariants.push_back(variant);
+    m_drawMaterials.push_back(material);
+    return (unsigned int)m_commands.size() - 1;
+} // KeyBatch::addDraw(unsigned int, unsigned int, const glm::vec3&)
+
+//--------------------------------------------------------------------------
+/**
+ Sets the properties of one of the batch's materials. They
+ are sent to the shader when the batch is next drawn, so the
+ shader does not have to finish compiling now.
+ 
+ @param material Index of the material (less than MAX_MATERIALS).
+ @param ambient Amount the material reflects ambient R, G, and B light.
+ @param diffuse Amount the material reflects diffuse R, G, and B light.
+ @param specular Amount the material reflects specular R, G, and B light.
+ @param specularExponent How mirror-like the surface is.
+ */
+void KeyBatch::setMaterialProperties(unsigned int material, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float specularExponent)
+{
+    Material& properties = m_materials[material];
+    properties.ambient = ambient;
+    properties.diffuse = diffuse;
+    properties.specular = specular;
+    properties.specularExponent = specularExponent;
+    properties.isChanged = true;
+    m_materialsChanged = true;
+} // KeyBatch::setMaterialProperties(unsigned int, glm::vec3, glm::vec3, glm::vec3, float)
+
+//--------------------------------------------------------------------------
+/**
+ Puts the merged geometry, the draw data, and the indirect
+ commands into buffers on the GPU. The per-draw data is an
+ instanced attribute, so the base instance of each command
+ selects which vec4 the key's vertices see.
+ */
+void KeyBatch::upload()
+{
+    RenderState* renderState = m_shader->getRenderState();
+    glGenVertexArrays(1, &m_vertexArrayObject);
+    renderState->bindVertexArray(m_vertexArrayObject);
+    glGenBuffers(NUM_BUFFERS, m_buffers);
+    
+    // BUFFERS 1 and 2: packed vertices and indices of all the variants
+    // (the indices are relative to each variant, so they stay small)
+    PackedVertices packed(m_model.positions, m_model.normals, m_model.indices);
+    packed.upload(m_buffers[VERTEX_VB], m_buffers[INDEX_VB]);
+    m_indexType = packed.getIndexType();
+    m_numBytes = packed.getNumBytes();
+    m_numUnpackedBytes = packed.getNumUnpackedBytes();
+    m_vertexSize = packed.getVertexSize();
+    
+    // BUFFER 3: one vec4 per draw, advanced once per instance
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffers[DRAW_DATA_VB]);
+    glBufferData(GL_ARRAY_BUFFER, m_drawData.size() * sizeof(m_drawData[0]), &m_drawData[0], GL_DYNAMIC_DRAW); // Changes when keys move
+    GLint drawDataAttrib = Shader::DRAW_DATA_A;
+    glEnableVertexAttribArray(drawDataAttrib);
+    glVertexAttribPointer(drawDataAttrib, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    glVertexAttribDivisor(drawDataAttrib, 1);
+    
+    // BUFFER 4: lighting baked for each key's own vertices (if baked)
+    if(!m_bakedLight.empty())
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffers[BAKED_LIGHT_VB]);
+        glBufferData(GL_ARRAY_BUFFER, m_bakedLight.size() * sizeof(m_bakedLight[0]), &m_bakedLight[0], GL_STATIC_DRAW);
+        GLint bakedAttrib = Shader::BAKED_LIGHT_A;
+        glEnableVertexAttribArray(bakedAttrib);
+        glVertexAttribPointer(bakedAttrib, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    } // if
+    
+    renderState->bindVertexArray(0);
+    
+    // BUFFER 5: the indirect commands (not part of the vertex array's state)
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_buffers[INDIRECT_B]);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, m_commands.size() * sizeof(m_commands[0]), &m_commands[0], GL_DYNAMIC_DRAW); // Changes when keys are culled
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    
+    m_isUploaded = true;
+} // KeyBatch::upload()
+
+//--------------------------------------------------------------------------
+/**
+ Works out the ambient and diffuse light of every key where it
+ is now, and switches to a shader which only adds the specular
+ light to it. Since the lighting differs from key to key, each
+ key is given its own copy of its variant's vertices. A key
+ that moves is lit by the shader again until it returns.
+ Call this after all the draws and materials are added.
+ 
+ @param baker The lights to bake.
+ @param bakedShader A version of the batch's shader with the
+ ShaderLibrary::BAKED_LIGHTING_F feature.
+ */
+void KeyBatch::bakeLighting(const LightBaker& baker, Shader* bakedShader)
+{
+    Model model;
+    model.indices = m_model.indices;
+    m_bakedLight.clear();
+    m_bakedTranslations.clear();
+    for(unsigned int i = 0; i < m_commands.size(); i++)
+    {
+        const Variant& variant = m_variants[m_drawVariants[i]];
+        const Material& material = m_materials[m_drawMaterials[i]];
+        glm::vec3 translation = glm::vec3(m_drawData[i]);
+        
+        // Copy the variant's vertices for this key only
+        m_commands[i].baseVertex = (GLint)model.positions.size();
+        for(unsigned int j = 0; j < variant.numVertices; j++)
+        {
+            const glm::vec3& position = m_model.positions[variant.baseVertex + j];
+            const glm::vec3& normal = m_model.normals[variant.baseVertex + j];
+            model.positions.push_back(position);
+            model.normals.push_back(normal);
+            m_bakedLight.push_back(baker.bakeVertex(position + translation, normal, material.ambient, material.diffuse));
+        } // for
+        m_bakedTranslations.push_back(translation);
+        m_drawData[i].w = getDrawMaterial(i, translation);
+    } // for
+    m_model = model;
+    
+    // The new shader needs every material
+    m_shader = bakedShader;
+    for(unsigned int i = 0; i < MAX_MATERIALS; i++)
+        m_materials[i].isChanged = true;
+    m_materialsChanged = true;
+    
+    // Upload everything again with the new vertices
+    if(m_isUploaded)
+    {
+        m_shader->getRenderState()->bindVertexArray(0); // Its name may be reused
+        glDeleteBuffers(NUM_BUFFERS, m_buffers);
+        glDeleteVertexArrays(1, &m_vertexArrayObject);
+        upload();
+    } // if
+} // KeyBatch::bakeLighting(const LightBaker&, Shader*)
+
+//--------------------------------------------------------------------------
+/**
+ Shows or hides a key. A hidden key keeps its command but
+ draws zero instances, so the number of commands submitted
+ never changes.
+ 
+ @param draw Index of the draw (from addDraw()).
+ @param visible True if the key should be drawn.
+ */
+void KeyBatch::setVisible(unsigned int draw, bool visible)
+{
+    GLuint instanceCount = visible ? 1 : 0;
+    if(m_commands[draw].instanceCount == instanceCount)
+        return;
+    
+    m_commands[draw].instanceCount = instanceCount;
+    if(m_firstDirtyCommand > m_lastDirtyCommand)
+    {
+        m_firstDirtyCommand = draw;
+        m_lastDirtyCommand = draw;
+    } // if
+    else
+    {
+        m_firstDirtyCommand = std::min(m_firstDirtyCommand, draw);
+        m_lastDirtyCommand = std::max(m_lastDirtyCommand, draw);
+    } // else
+} // KeyBatch::setVisible(unsigned int, bool)
+
+//--------------------------------------------------------------------------
+/**
+ Moves a key.
+ 
+ @param draw Index of the draw (from addDraw()).
+ @param translation Where the key is in the world.
+ */
+void KeyBatch::setTranslation(unsigned int draw, const glm::vec3& translation)
+{
+    glm::vec4 data(translation, getDrawMaterial(draw, translation));
+    if(m_drawData[draw] == data)
+        return;
+    
+    m_drawData[draw] = data;
+    if(m_firstDirtyData > m_lastDirtyData)
+    {
+        m_firstDirtyData = draw;
+        m_lastDirtyData = draw;
+    } // if
+    else
+    {
+        m_firstDirtyData = std::min(m_firstDirtyData, draw);
+        m_lastDirtyData = std::max(m_lastDirtyData, draw);
+    } // else
+} // KeyBatch::setTranslation(unsigned int, const glm::vec3&)
+
+//--------------------------------------------------------------------------
+/**
+ Gets the w of a key's draw data: its material, plus
+ MAX_MATERIALS if its lighting is baked and it is still where
+ it was baked (the shader splits the two apart again).
+ 
+ @param draw Index of the draw (from addDraw()).
+ @param translation Where the key is in the world.
+ @return The material to put in the draw data.
+ */
+float KeyBatch::getDrawMaterial(unsigned int draw, const glm::vec3& translation)
+{
+    unsigned int material = m_drawMaterials[draw];
+    if(!m_bakedTranslations.empty() && m_bakedTranslations[draw] == translation)
+        material += MAX_MATERIALS;
+    return (float)material;
+} // KeyBatch::getDrawMaterial(unsigned int, const glm::vec3&)
+
+//--------------------------------------------------------------------------
+/**
+ Re-uploads only the commands and draw data that changed
+ since the last frame.
+ */
+void KeyBatch::flush()
+{
+    if(m_firstDirtyCommand <= m_lastDirtyCommand)
+    {
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, m_firstDirtyCommand * sizeof(DrawCommand),
+                        (m_lastDirtyCommand - m_firstDirtyCommand + 1) * sizeof(DrawCommand), &m_commands[m_firstDirtyCommand]);
+        m_firstDirtyCommand = 1;
+        m_lastDirtyCommand = 0;
+    } // if
+    if(m_firstDirtyData <= m_lastDirtyData)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffers[DRAW_DATA_VB]);
+        glBufferSubData(GL_ARRAY_BUFFER, m_firstDirtyData * sizeof(glm::vec4),
+                        (m_lastDirtyData - m_firstDirtyData + 1) * sizeof(glm::vec4), &m_drawData[m_firstDirtyData]);
+        m_firstDirtyData = 1;
+        m_lastDirtyData = 0;
+    } // if
+} // KeyBatch::flush()
+
+//--------------------------------------------------------------------------
+/**
+ Draws every key in the batch with one call. Keys that
+ were hidden with setVisible() draw nothing.
+ 
+ @param camera The camera to use when drawing the keys.
+ */
+void KeyBatch::draw(Camera* camera)
+{
+    m_shader->use();
+    m_shader->update(Transform(), camera); // The model matrix comes from the draw data
+    if(m_materialsChanged)
+    {
+        for(unsigned int i = 0; i < MAX_MATERIALS; i++)
+        {
+            Material& properties = m_materials[i];
+            if(properties.isChanged)
+                m_shader->setMaterial(i, properties.ambient, properties.diffuse, properties.specular, properties.specularExponent);
+            properties.isChanged = false;
+        } // for
+        m_materialsChanged = false;
+    } // if
+    m_shader->getRenderState()->bindVertexArray(m_vertexArrayObject);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_buffers[INDIRECT_B]);
+    
+    flush();
+    glMultiDrawElementsIndirect(GL_TRIANGLES, m_indexType, 0, (GLsizei)m_commands.size(), 0);
+    m_shader->getRenderState()->countDrawCall();
+    
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+} // KeyBatch::draw(Camera*)
@@ -0,0 +1,148 @@
+/**
+ KeyBatch.hpp
+ Virtual Keyboard
+ Class which puts the geometry of every kind of key into one
+ vertex/index buffer and draws all of the keys with a single
+ multi-draw-indirect call. Each key is one indirect command, and
+ the data for each draw (its translation and material) is fetched
+ in the shader through the command's base instance.
+ The lighting of keys at rest can be baked, in which case each
+ key gets its own copy of its variant's vertices.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/15/2018
+ */
+
+#ifndef KeyBatch_hpp
+#define KeyBatch_hpp
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "Mesh.hpp"
+#include "Shader.hpp"
+#include "Camera.hpp"
+#include "LightBaker.hpp"
+
+class KeyBatch
+{
+public:
+    KeyBatch(Shader* shader);
+    virtual ~KeyBatch();
+    
+    static bool isSupported();
+    
+    // Methods for building the batch
+    unsigned int addVariant(Vertex* vertices, unsigned int numVertices, unsigned int* indices, unsigned int numIndices);
+    unsigned int addDraw(unsigned int variant, unsigned int material, const glm::vec3& translation);
+    void setMaterialProperties(unsigned int material, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float specularExponent);
+    void upload();
+    void bakeLighting(const LightBaker& baker, Shader* bakedShader);
+    
+    // Methods used every frame
+    void setVisible(unsigned int draw, bool visible);
+    void setTranslation(unsigned int draw, const glm::vec3& translation);
+    void draw(Camera* camera);
+    
+    /**
+     Gets how many bytes of vertices and indices are on the GPU
+     (not counting the draw data and baked lighting).
+     */
+    inline unsigned int getNumBytes() { return m_numBytes; }
+    /**
+     Gets how many bytes the same geometry would take with float
+     positions and normals in separate buffers and 32-bit indices.
+     */
+    inline unsigned int getNumUnpackedBytes() { return m_numUnpackedBytes; }
+    /**
+     Gets how many bytes are fetched for each vertex drawn.
+     */
+    inline unsigned int getVertexSize() { return m_vertexSize; }
+    
+    static const unsigned int MAX_MATERIALS = 2; // White and black keys
+private:
+    // Layout of one command in the indirect buffer (defined by OpenGL)
+    struct DrawCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    }; // DrawCommand
+    
+    // Where one kind of key lives in the merged buffers
+    struct Variant
+    {
+        GLuint count;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint numVertices;
+    }; // Variant
+    
+    // Properties of one material, kept until they are sent to the shader
+    struct Material
+    {
+        glm::vec3 ambient;
+        glm::vec3 diffuse;
+        glm::vec3 specular;
+        float specularExponent;
+        bool isChanged; // Not sent to the shader yet
+    }; // Material
+    
+    // An enumerated type for the buffers which go in the m_buffers array.
+    enum {
+        VERTEX_VB, // Positions and normals, interleaved
+        DRAW_DATA_VB,
+        BAKED_LIGHT_VB,
+        INDEX_VB,
+        INDIRECT_B,
+        
+        NUM_BUFFERS
+    }; // enum
+    
+    void flush();
+    float getDrawMaterial(unsigned int draw, const glm::vec3& translation);
+    
+    Shader* m_shader; // Shader compiled with ShaderLibrary::KEY_BATCH_F
+    GLuint m_vertexArrayObject;
+    GLuint m_buffers[NUM_BUFFERS];
+    bool m_isUploaded;
+    GLenum m_indexType; // GL_UNSIGNED_BYTE, _SHORT or _INT, whichever fits
+    unsigned int m_numBytes; // Of the packed vertices and indices
+    unsigned int m_numUnpackedBytes; // With float attributes and 32-bit indices
+    unsigned int m_vertexSize;
+    
+    // Materials that the draws pick from
+    Material m_materials[MAX_MATERIALS];
+    bool m_materialsChanged;
+    
+    // Merged geometry of all the variants
+    Model m_model;
+    std::vector<Variant> m_variants;
+    
+    // One command and one vec4 of draw data (xyz translation,
+    // w material) per key, kept on the CPU so that only the
+    // parts that changed have to be re-uploaded.
+    std::vector<DrawCommand> m_commands;
+    std::vector<glm::vec4> m_drawData;
+    std::vector<unsigned int> m_drawVariants;
+    std::vector<unsigned int> m_drawMaterials;
+    
+    // Baked lighting of each key's vertices, which is only used
+    // while the key is where it was baked (empty if not baked)
+    std::vector<glm::vec4> m_bakedLight;
+    std::vector<glm::vec3> m_bakedTranslations;
+    
+    // Range of commands/draw data changed since the last upload
+    // (first > last when nothing changed)
+    unsigned int m_firstDirtyCommand;
+    unsigned int m_lastDirtyCommand;
+    unsigned int m_firstDirtyData;
+    unsigned int m_lastDirtyData;
+}; // KeyBatch
+
+#endif /* KeyBatch_hpp */
@@ -0,0 +1,313 @@
+/**
+ KeyGeometry.hpp
+ Virtual Keyboard
+ Builds the meshes of the white and black keys from a few
+ measurements (widths, heights, lengths, the bevel along the
+ top of the white keys, and how far the black keys are from the
+ notches around them) while compiling, so that keys of other
+ sizes only need other measurements. Each face is given by its
+ corners and the side of the key it is on: its normal is worked
+ out from its corners, its triangles are wound counterclockwise
+ seen from outside, and it has vertices of its own (so the keys
+ are flat shaded).
+ 
+ @author Graeme Zinck
+ @version 1.0 4/30/2018
+ */
+
+#ifndef KeyGeometry_hpp
+#define KeyGeometry_hpp
+
+// A point or direction (x to the right, y up, z towards the player)
+struct KeyPoint
+{
+    float x;
+    float y;
+    float z;
+}; // KeyPoint
+
+// A vertex of a key's mesh
+struct KeyVertex
+{
+    KeyPoint position;
+    KeyPoint normal;
+}; // KeyVertex
+
+// The measurements of the keys. A white key's left side is at
+// x = 0, and the front of it below the lip is at z = 0. A black
+// key is built in the same place as the white key to its left.
+struct KeyboardShape
+{
+    float whiteWidth;
+    float whiteSpacing; // From one white key's left side to the next one's
+    float whiteHeight;
+    float whiteLength; // From the front below the lip to the back (of both colours)
+    float lipDepth; // How far the top of a white key sticks out over its front
+    float lipHeight; // How thick the lip is (the bevel goes down as far)
+    float bevel; // How far in the bevel along each side of the top goes
+    float blackLeft; // Where a black key's left side is
+    float blackWidth;
+    float blackFront; // How far behind the white keys' front a black key starts
+    float blackFrontHeight;
+    float blackHeight;
+    float blackSlant; // How far back the slant from the front to the top goes
+    float clearance; // The gap between a black key and the notch around it
+}; // KeyboardShape
+
+// The keys of the piano (a white key is 2.2 wide and 15 long)
+constexpr KeyboardShape STANDARD_KEYBOARD_SHAPE = { 2.2f, 2.4f, 1.9f, 15.0f, 0.2f, 0.2f, 0.1f,
+                                                    1.7f, 1.2f, 5.2f, 1.9f, 3.0f, 0.7f, 0.2f };
+
+//--------------------------------------------------------------------------
+/**
+ A mesh built while compiling, with room for MAX_VERTICES
+ vertices and MAX_INDICES indices (using more does not compile).
+ */
+template<unsigned int MAX_VERTICES, unsigned int MAX_INDICES>
+struct KeyMesh
+{
+    constexpr KeyMesh() : vertices{}, indices{}, numVertices(0), numIndices(0) {}
+    
+    //----------------------------------------------------------------------
+    /**
+     Adds a flat, convex face. Corners which repeat the one
+     before them (from measurements of zero) are left out, and
+     faces with no area are not added.
+     
+     @param corners The corners, in order around the face (either way).
+     @param numCorners The number of corners (at most 6).
+     @param side A direction the face points towards, away from
+     the inside of the key.
+     */
+    constexpr void addFace(const KeyPoint* corners, unsigned int numCorners, const KeyPoint& side)
+    {
+        KeyPoint points[6] = {};
+        unsigned int numPoints = 0;
+        for(unsigned int i = 0; i < numCorners; i++)
+            if(numPoints == 0 || !isSamePoint(corners[i], points[numPoints - 1]))
+                points[numPoints++] = corners[i];
+        if(numPoints > 1 && isSamePoint(points[numPoints - 1], points[0]))
+            numPoints--;
+        if(numPoints < 3)
+            return;
+        
+        // Newell's normal, which points the way the corners go
+        // around counterclockwise
+        KeyPoint normal = { 0.0f, 0.0f, 0.0f };
+        for(unsigned int i = 0; i < numPoints; i++)
+        {
+            const KeyPoint& a = points[i];
+            const KeyPoint& b = points[(i + 1) % numPoints];
+            normal.x += (a.y - b.y) * (a.z + b.z);
+            normal.y += (a.z - b.z) * (a.x + b.x);
+            normal.z += (a.x - b.x) * (a.y + b.y);
+        } // for
+        float length = squareRoot(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        if(length == 0.0f)
+            return;
+        
+        // Turn the face around if it was given clockwise
+        bool isReversed = normal.x * side.x + normal.y * side.y + normal.z * side.z < 0.0f;
+        if(isReversed)
+            length = -length;
+        normal = { normal.x / length, normal.y / length, normal.z / length };
+        
+        unsigned int first = numVertices;
+        for(unsigned int i = 0; i < numPoints; i++)
+            vertices[numVertices++] = { points[isReversed ? numPoints - 1 - i : i], normal };
+        for(unsigned int i = 1; i + 1 < numPoints; i++)
+        {
+            indices[numIndices++] = first;
+            indices[numIndices++] = first + i;
+            indices[numIndices++] = first + i + 1;
+        } // for
+    } // KeyMesh::addFace(const KeyPoint*, unsigned int, const KeyPoint&)
+    
+    //----------------------------------------------------------------------
+    /**
+     Adds a flat four-sided face (see addFace()).
+     */
+    constexpr void addQuad(const KeyPoint& a, const KeyPoint& b, const KeyPoint& c, const KeyPoint& d, const KeyPoint& side)
+    {
+        const KeyPoint corners[4] = { a, b, c, d };
+        addFace(corners, 4, side);
+    } // KeyMesh::addQuad(const KeyPoint&, const KeyPoint&, const KeyPoint&, const KeyPoint&, const KeyPoint&)
+    
+    //----------------------------------------------------------------------
+    /**
+     Checks if two points are the same.
+     */
+    static constexpr bool isSamePoint(const KeyPoint& a, const KeyPoint& b)
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    } // KeyMesh::isSamePoint(const KeyPoint&, const KeyPoint&)
+    
+    //----------------------------------------------------------------------
+    /**
+     Works out a square root while compiling (with Newton's method).
+     */
+    static constexpr float squareRoot(float value)
+    {
+        if(value <= 0.0f)
+            return 0.0f;
+        float root = value > 1.0f ? value : 1.0f;
+        for(int i = 0; i < 64; i++)
+            root = 0.5f * (root + value / root);
+        return root;
+    } // KeyMesh::squareRoot(float)
+    
+    KeyVertex vertices[MAX_VERTICES];
+    unsigned int indices[MAX_INDICES];
+    unsigned int numVertices;
+    unsigned int numIndices;
+}; // KeyMesh
+
+// Room for a white key with both notches (14 quads and 2
+// pentagons), and for a black key (5 quads and 2 pentagons)
+typedef KeyMesh<66, 102> WhiteKeyMesh;
+typedef KeyMesh<30, 48> BlackKeyMesh;
+
+//--------------------------------------------------------------------------
+/**
+ Builds a white key: a lip sticking out over the front, a bevel
+ along both sides of the top, and a notch cut out of the back
+ of either side for a black key if asked.
+ 
+ @param shape The measurements of the keys.
+ @param hasLeftNotch True to cut a notch for the black key to the left.
+ @param hasRightNotch True to cut a notch for the black key to the right.
+ @return The mesh.
+ */
+constexpr WhiteKeyMesh makeWhiteKeyMesh(const KeyboardShape& shape, bool hasLeftNotch, bool hasRightNotch)
+{
+    const KeyPoint LEFT = { -1.0f, 0.0f, 0.0f };
+    const KeyPoint RIGHT = { 1.0f, 0.0f, 0.0f };
+    const KeyPoint DOWN = { 0.0f, -1.0f, 0.0f };
+    const KeyPoint UP = { 0.0f, 1.0f, 0.0f };
+    const KeyPoint BACK = { 0.0f, 0.0f, -1.0f };
+    const KeyPoint FRONT = { 0.0f, 0.0f, 1.0f };
+    
+    // Across the key
+    float left = 0.0f;
+    float right = shape.whiteWidth;
+    float bevelLeft = left + shape.bevel;
+    float bevelRight = right - shape.bevel;
+    float notchLeft = hasLeftNotch ? shape.blackLeft + shape.blackWidth - shape.whiteSpacing + shape.clearance : left;
+    float notchRight = hasRightNotch ? shape.blackLeft - shape.clearance : right;
+    
+    // Up the key
+    float bottom = 0.0f;
+    float lipBottom = shape.whiteHeight - shape.lipHeight;
+    float top = shape.whiteHeight;
+    
+    // Along the key
+    float lipFront = shape.lipDepth;
+    float front = 0.0f;
+    float notchFront = shape.clearance - shape.blackFront;
+    float back = -shape.whiteLength;
+    float leftEnd = hasLeftNotch ? notchFront : back; // Where the left side stops
+    float rightEnd = hasRightNotch ? notchFront : back;
+    
+    WhiteKeyMesh mesh;
+    
+    // The lip, and the front below it
+    mesh.addQuad({ left, lipBottom, lipFront }, { right, lipBottom, lipFront }, { bevelRight, top, lipFront }, { bevelLeft, top, lipFront }, FRONT);
+    mesh.addQuad({ left, lipBottom, front }, { right, lipBottom, front }, { right, lipBottom, lipFront }, { left, lipBottom, lipFront }, DOWN);
+    mesh.addQuad({ left, bottom, front }, { right, bottom, front }, { right, lipBottom, front }, { left, lipBottom, front }, FRONT);
+    
+    // The top and bottom (narrower behind where the notches start)
+    if(!hasLeftNotch && !hasRightNotch)
+    {
+        mesh.addQuad({ bevelLeft, top, lipFront }, { bevelRight, top, lipFront }, { bevelRight, top, back }, { bevelLeft, top, back }, UP);
+        mesh.addQuad({ left, bottom, front }, { right, bottom, front }, { right, bottom, back }, { left, bottom, back }, DOWN);
+    } // if
+    else
+    {
+        float topLeft = hasLeftNotch ? notchLeft : bevelLeft;
+        float topRight = hasRightNotch ? notchRight : bevelRight;
+        mesh.addQuad({ bevelLeft, top, lipFront }, { bevelRight, top, lipFront }, { bevelRight, top, notchFront }, { bevelLeft, top, notchFront }, UP);
+        mesh.addQuad({ topLeft, top, notchFront }, { topRight, top, notchFront }, { topRight, top, back }, { topLeft, top, back }, UP);
+        mesh.addQuad({ left, bottom, front }, { right, bottom, front }, { right, bottom, notchFront }, { left, bottom, notchFront }, DOWN);
+        mesh.addQuad({ notchLeft, bottom, notchFront }, { notchRight, bottom, notchFront }, { notchRight, bottom, back }, { notchLeft, bottom, back }, DOWN);
+    } // else
+    
+    // The bevels and the sides below them
+    mesh.addQuad({ left, lipBottom, lipFront }, { bevelLeft, top, lipFront }, { bevelLeft, top, leftEnd }, { left, lipBottom, leftEnd }, LEFT);
+    mesh.addQuad({ right, lipBottom, lipFront }, { bevelRight, top, lipFront }, { bevelRight, top, rightEnd }, { right, lipBottom, rightEnd }, RIGHT);
+    mesh.addQuad({ left, bottom, front }, { left, lipBottom, front }, { left, lipBottom, leftEnd }, { left, bottom, leftEnd }, LEFT);
+    mesh.addQuad({ right, bottom, front }, { right, lipBottom, front }, { right, lipBottom, rightEnd }, { right, bottom, rightEnd }, RIGHT);
+    
+    // The notches: a step across the key where each starts, and a
+    // wall along the key beside the black key
+    if(hasLeftNotch)
+    {
+        const KeyPoint step[5] = { { left, bottom, notchFront }, { notchLeft, bottom, notchFront }, { notchLeft, top, notchFront },
+                                   { bevelLeft, top, notchFront }, { left, lipBottom, notchFront } };
+        mesh.addFace(step, 5, BACK);
+        mesh.addQuad({ notchLeft, bottom, notchFront }, { notchLeft, top, notchFront }, { notchLeft, top, back }, { notchLeft, bottom, back }, LEFT);
+    } // if
+    if(hasRightNotch)
+    {
+        const KeyPoint step[5] = { { notchRight, bottom, notchFront }, { right, bottom, notchFront }, { right, lipBottom, notchFront },
+                                   { bevelRight, top, notchFront }, { notchRight, top, notchFront } };
+        mesh.addFace(step, 5, BACK);
+        mesh.addQuad({ notchRight, bottom, notchFront }, { notchRight, top, notchFront }, { notchRight, top, back }, { notchRight, bottom, back }, RIGHT);
+    } // if
+    
+    // The back (bevelled on the sides without notches)
+    KeyPoint backFace[6] = {};
+    unsigned int numCorners = 0;
+    backFace[numCorners++] = { notchLeft, bottom, back };
+    backFace[numCorners++] = { notchRight, bottom, back };
+    if(!hasRightNotch)
+        backFace[numCorners++] = { right, lipBottom, back };
+    backFace[numCorners++] = { hasRightNotch ? notchRight : bevelRight, top, back };
+    backFace[numCorners++] = { hasLeftNotch ? notchLeft : bevelLeft, top, back };
+    if(!hasLeftNotch)
+        backFace[numCorners++] = { left, lipBottom, back };
+    mesh.addFace(backFace, numCorners, BACK);
+    return mesh;
+} // makeWhiteKeyMesh(const KeyboardShape&, bool, bool)
+
+//--------------------------------------------------------------------------
+/**
+ Builds a black key: a block with a slant from the front up to
+ the top.
+ 
+ @param shape The measurements of the keys.
+ @return The mesh.
+ */
+constexpr BlackKeyMesh makeBlackKeyMesh(const KeyboardShape& shape)
+{
+    const KeyPoint LEFT = { -1.0f, 0.0f, 0.0f };
+    const KeyPoint RIGHT = { 1.0f, 0.0f, 0.0f };
+    const KeyPoint DOWN = { 0.0f, -1.0f, 0.0f };
+    const KeyPoint UP = { 0.0f, 1.0f, 0.0f };
+    const KeyPoint BACK = { 0.0f, 0.0f, -1.0f };
+    const KeyPoint FRONT = { 0.0f, 0.0f, 1.0f };
+    
+    float left = shape.blackLeft;
+    float right = shape.blackLeft + shape.blackWidth;
+    float bottom = 0.0f;
+    float frontTop = shape.blackFrontHeight;
+    float top = shape.blackHeight;
+    float front = -shape.blackFront;
+    float slantBack = front - shape.blackSlant;
+    float back = -shape.whiteLength;
+    
+    BlackKeyMesh mesh;
+    mesh.addQuad({ left, bottom, front }, { right, bottom, front }, { right, frontTop, front }, { left, frontTop, front }, FRONT);
+    mesh.addQuad({ left, frontTop, front }, { right, frontTop, front }, { right, top, slantBack }, { left, top, slantBack }, UP);
+    mesh.addQuad({ left, top, slantBack }, { right, top, slantBack }, { right, top, back }, { left, top, back }, UP);
+    mesh.addQuad({ left, bottom, front }, { right, bottom, front }, { right, bottom, back }, { left, bottom, back }, DOWN);
+    mesh.addQuad({ left, bottom, back }, { right, bottom, back }, { right, top, back }, { left, top, back }, BACK);
+    const KeyPoint leftSide[5] = { { left, bottom, back }, { left, bottom, front }, { left, frontTop, front },
+                                   { left, top, slantBack }, { left, top, back } };
+    mesh.addFace(leftSide, 5, LEFT);
+    const KeyPoint rightSide[5] = { { right, bottom, back }, { right, bottom, front }, { right, frontTop, front },
+                                    { right, top, slantBack }, { right, top, back } };
+    mesh.addFace(rightSide, 5, RIGHT);
+    return mesh;
+} // makeBlackKeyMesh(const KeyboardShape&)
+
+#endif /* KeyGeometry_hpp */
@@ -10,135 +10,93 @@
 #include "KeyboardKeys.hpp"
 #include "Transform.hpp"
 #include <SDL2/SDL.h>
+#include <algorithm>
 #include <iostream>
 #include <math.h>
 
-// Helper methods
-//--------------------------------------------------------------------------
-/**
- Callback function for SDL timer function which
- presses down a key in increments until it is at
- the bottom.
- 
- @param interval Milliseconds between increments pushing
- down a keyboard key.
- @param param A keyboard key to press down.
-*/
-Uint32 pressDownKey(Uint32 interval, void* param)
-{
-    OneKeyboardKey* theKey = (OneKeyboardKey*)param;
-    if(!theKey->isAtBottom())
-    {
-        theKey->keyDown();
-        return interval;
-    } // if
-    return 0;
-} // pressDownKey(Uint32, void*)
-
-//--------------------------------------------------------------------------
-/**
- Callback function for SDL timer function which
- pulls up a key in increments until it is at
- the top.
- 
- @param interval Milliseconds between increments pulling
- up a keyboard key.
- @param param A keyboard key to pull up.
- */
-Uint32 liftUpKey(Uint32 interval, void* param)
-{
-    OneKeyboardKey* theKey = (OneKeyboardKey*)param;
-    if(!theKey->isAtTop())
-    {
-        theKey->keyUp();
-        return interval;
-    } // if
-    return 0;
-} // liftUpKey(Uint32, void*)
+// The mesh of each kind of key, built while compiling
+constexpr WhiteKeyMesh WHITE_MESH = makeWhiteKeyMesh(STANDARD_KEYBOARD_SHAPE, false, false);
+constexpr WhiteKeyMesh WHITE_L_MESH = makeWhiteKeyMesh(STANDARD_KEYBOARD_SHAPE, true, false);
+constexpr WhiteKeyMesh WHITE_R_MESH = makeWhiteKeyMesh(STANDARD_KEYBOARD_SHAPE, false, true);
+constexpr WhiteKeyMesh WHITE_LR_MESH = makeWhiteKeyMesh(STANDARD_KEYBOARD_SHAPE, true, true);
+constexpr BlackKeyMesh BLACK_MESH = makeBlackKeyMesh(STANDARD_KEYBOARD_SHAPE);
 
 //--------------------------------------------------------------------------
 /**
  Creates the KeyboardKeys object by initializing
- all the white keys and black keys and putting them
- in an array.
+ all the white keys and black keys where the layout
+ puts them.
  
- @param shader The shader, which the keyboard keys will
- need so that they can set their material properties when
- they are drawn.
+ @param shaders The library of shaders, from which each kind
+ of key gets the cheapest shader that can draw its material.
+ @param resourceFolder The folder holding the sound folders.
+ @param layout Which keys there are and where they go.
 */
-KeyboardKeys::KeyboardKeys(Shader* shader, std::string resourceFolder)
+KeyboardKeys::KeyboardKeys(ShaderLibrary* shaders, std::string resourceFolder, const KeyboardLayout& layout)
+: m_layout(layout), m_renderQueue(shaders->getRenderState())
 {
     resFolder = resourceFolder;
-    
-    // Initialize the arrays of keys
-    whiteKeys = new OneKeyboardKey*[NUM_WHITE_KEYS];
-    blackKeys = new OneKeyboardKey*[NUM_BLACK_KEYS];
+    m_shaders = shaders;
     
     // No key down at the moment
     m_curKeyDown = -1;
     
+    // Keys are drawn one at a time until useBatchRendering() is called
+    m_keyBatch = NULL;
+    
     // Initialize the sound as sound 0 (the organ sound)
     m_soundToUse = 0;
+    m_envelopes[OneKeyboardKey::ORGAN_SOUND] = ORGAN_ENVELOPE;
+    m_envelopes[OneKeyboardKey::PIANO_SOUND] = PIANO_ENVELOPE;
     
-    // Hold a transformation matrix to move the vertices
-    // from model coordinates to world coordinates
-    Transform transform;
+    // Nothing drawn yet
+    m_numKeysDrawn = 0;
+    m_numKeysCulled = 0;
+    m_numGroupsCulled = 0;
+    m_numKeyboardsCulled = 0;
     
-    int whiteKeysFilled = 0;
-    int blackKeysFilled = 0;
+    // Only one keyboard until setNumKeyboards() is called
+    m_keyboardOffsets.assign(1, glm::vec3(0.0f));
+    m_numColumns = 1;
+    m_columnSpacing = m_layout.getLength() + KEYBOARD_GAP;
     
-    // Create the A-key to start (has notch in right side)
-    makeWhiteKeyR(whiteKeysFilled++, shader, transform, "0a");
+    // Keys are only ever moved, so their normals never have to be transformed
+    Shader* whiteShader = shaders->getShaderForMaterial(WHITE_D, WHITE_S, ShaderLibrary::TRANSLATION_ONLY_F);
+    Shader* blackShader = shaders->getShaderForMaterial(BLACK_D, BLACK_S, ShaderLibrary::TRANSLATION_ONLY_F);
     
-    // Create the Bb-key
-    makeBlackKey(blackKeysFilled++, shader, transform, "0bb");
-    transform.moveRight(X_DIFF_BETWEEN_WHITE_KEYS);
+    // Start compiling the batch's shader too, so that it compiles
+    // while the sounds load and the keys are sent to the GPU
+    if(KeyBatch::isSupported())
+        shaders->getShader(getBatchFeatures());
     
-    // Create the B-key (has notch in left side)
-    makeWhiteKeyL(whiteKeysFilled++, shader, transform, "0b");
-    transform.moveRight(X_DIFF_BETWEEN_WHITE_KEYS);
+    // Copy the mesh of each kind of key, then reorder its triangles
+    // for the vertex cache and for overdraw, once, before any key
+    // (or the batch) uses them
+    useKeyMesh(KeyboardLayout::WHITE_VARIANT, WHITE_MESH.vertices, WHITE_MESH.numVertices, WHITE_MESH.indices, WHITE_MESH.numIndices);
+    useKeyMesh(KeyboardLayout::WHITE_L_VARIANT, WHITE_L_MESH.vertices, WHITE_L_MESH.numVertices, WHITE_L_MESH.indices, WHITE_L_MESH.numIndices);
+    useKeyMesh(KeyboardLayout::WHITE_R_VARIANT, WHITE_R_MESH.vertices, WHITE_R_MESH.numVertices, WHITE_R_MESH.indices, WHITE_R_MESH.numIndices);
+    useKeyMesh(KeyboardLayout::WHITE_LR_VARIANT, WHITE_LR_MESH.vertices, WHITE_LR_MESH.numVertices, WHITE_LR_MESH.indices, WHITE_LR_MESH.numIndices);
+    useKeyMesh(KeyboardLayout::BLACK_VARIANT, BLACK_MESH.vertices, BLACK_MESH.numVertices, BLACK_MESH.indices, BLACK_MESH.numIndices);
+    const char* VARIANT_NAMES[KeyboardLayout::NUM_KEY_VARIANTS] = { "white", "white L", "white R", "white LR", "black" };
+    for(unsigned int i = 0; i < KeyboardLayout::NUM_KEY_VARIANTS; i++)
+        m_meshOptimizer.optimize(VARIANT_NAMES[i], &m_variantVertices[i][0], (unsigned int)m_variantVertices[i].size(), &m_variantIndices[i][0], (unsigned int)m_variantIndices[i].size());
     
-    // Create octaves from C to B (this is the convention for note names musically)
-    for(unsigned int octave = 1; octave <= NUM_OCTAVES; octave++)
+    // Make the keys from the lowest note up, starting a new group
+    // (for culling) at every C
+    for(unsigned int i = 0; i < m_layout.getNumKeys(); i++)
     {
-        std::string octaveStr = std::to_string(octave);
-        // C-key (R)
-        makeWhiteKeyR(whiteKeysFilled++, shader, transform, octaveStr + "c");
-        // Db-key
-        makeBlackKey(blackKeysFilled++, shader, transform, octaveStr + "db");
-        transform.moveRight(X_DIFF_BETWEEN_WHITE_KEYS);
-        // D-key (LR)
-        makeWhiteKeyLR(whiteKeysFilled++, shader, transform, octaveStr + "d");
-        // Eb-key
-        makeBlackKey(blackKeysFilled++, shader, transform, octaveStr + "eb");
-        transform.moveRight(X_DIFF_BETWEEN_WHITE_KEYS);
-        // E-key (L)
-        makeWhiteKeyL(whiteKeysFilled++, shader, transform, octaveStr + "e");
-        transform.moveRight(X_DIFF_BETWEEN_WHITE_KEYS);
-        // F-key (R)
-        makeWhiteKeyR(whiteKeysFilled++, shader, transform, octaveStr + "f");
-        // Gb-key
-        makeBlackKey(blackKeysFilled++, shader, transform, octaveStr + "gb");
-        transform.moveRight(X_DIFF_BETWEEN_WHITE_KEYS);
-        // G-key (LR)
-        makeWhiteKeyLR(whiteKeysFilled++, shader, transform, octaveStr + "g");
-        // Ab-key
-        makeBlackKey(blackKeysFilled++, shader, transform, octaveStr + "ab");
-        transform.moveRight(X_DIFF_BETWEEN_WHITE_KEYS);
-        // A-key (LR)
-        makeWhiteKeyLR(whiteKeysFilled++, shader, transform, octaveStr + "a");
-        // Bb-key
-        makeBlackKey(blackKeysFilled++, shader, transform, octaveStr + "bb");
-        transform.moveRight(X_DIFF_BETWEEN_WHITE_KEYS);
-        // B-key (L)
-        makeWhiteKeyL(whiteKeysFilled++, shader, transform, octaveStr + "b");
-        transform.moveRight(X_DIFF_BETWEEN_WHITE_KEYS);
+        const KeyboardLayout::Key& key = m_layout.getKey(i);
+        if(key.startsGroup)
+            startKeyGroup();
+        
+        // Moves the key's vertices from model coordinates to world coordinates
+        Transform transform;
+        transform.moveRight(key.x);
+        makeKey(key, key.isBlack ? blackShader : whiteShader, transform);
     } // for
     
-    // Create the last C-key (has no notches)
-    makeWhiteKey(whiteKeysFilled++, shader, transform, std::to_string(NUM_OCTAVES + 1) + "c");
-    transform.moveRight(X_DIFF_BETWEEN_WHITE_KEYS);
-} // KeyboardKeys::KeyboardKeys(Shader*)
+    finishKeyGroups();
+} // KeyboardKeys::KeyboardKeys(ShaderLibrary*, std::string, const KeyboardLayout&)
 
 //--------------------------------------------------------------------------
 /**
@@ -146,8 +104,7 @@ KeyboardKeys::KeyboardKeys(Shader* shader, std::string resourceFolder)
 */
 KeyboardKeys::~KeyboardKeys()
 {
-    delete[] whiteKeys;
-    delete[] blackKeys;
+    delete m_keyBatch;
 } // KeyboardKeys::~KeyboardKeys()
 
 //--------------------------------------------------------------------------
@@ -160,114 +117,402 @@ void KeyboardKeys::nextSoundSetting()
     m_soundToUse = (m_soundToUse + 1) % OneKeyboardKey::NUM_SOUNDS;
 } // KeyboardKeys::setSound(int)
 
+//--------------------------------------------------------------------------
+/**
+ Sets the sound effect for the keyboard (used to play back a
+ recorded session).
+ 
+ @param sound OneKeyboardKey::ORGAN_SOUND or PIANO_SOUND.
+*/
+void KeyboardKeys::setSoundSetting(unsigned int sound)
+{
+    m_soundToUse = sound % OneKeyboardKey::NUM_SOUNDS;
+} // KeyboardKeys::setSoundSetting(unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Sets the volume envelope of the notes of one sound (for notes
+ played from now on).
+ 
+ @param sound OneKeyboardKey::ORGAN_SOUND or PIANO_SOUND.
+ @param shape The shape of the envelope.
+*/
+void KeyboardKeys::setEnvelope(unsigned int sound, const EnvelopeShape& shape)
+{
+    if(sound < OneKeyboardKey::NUM_SOUNDS)
+        m_envelopes[sound] = shape;
+} // KeyboardKeys::setEnvelope(unsigned int, const EnvelopeShape&)
+
 //--------------------------------------------------------------------------
 /**
  Draws all the white and black keys in the positions
- already defined within the key objects.
+ already defined within the key objects, on every keyboard.
+ Keys outside of the camera's view are culled: first, whole
+ keyboards and groups (octaves) are tested against the view
+ frustum, and then each key in a visible group is tested on
+ its own.
+ Visible keys go through a render queue which sorts them so
+ that as few OpenGL state changes as possible are made.
  
  @param camera The camera to use when drawing the key.
 */
 void KeyboardKeys::draw(Camera* camera)
 {
-    for(unsigned int i = 0; i < NUM_WHITE_KEYS; i++)
+    m_frustum.update(camera->getViewProjection());
+    m_numKeysDrawn = 0;
+    m_numKeysCulled = 0;
+    m_numGroupsCulled = 0;
+    m_numKeyboardsCulled = 0;
+    
+    // Draws in the batch are numbered in the same order as the keyboards and groups
+    unsigned int drawIndex = 0;
+    
+    for(unsigned int k = 0; k < m_keyboardOffsets.size(); k++)
+    {
+        const glm::vec3& offset = m_keyboardOffsets[k];
+        
+        // Reject the whole keyboard at once if possible
+        if(!m_frustum.boxIsVisible(m_boundsMin + offset, m_boundsMax + offset))
+        {
+            m_numKeyboardsCulled++;
+            m_numGroupsCulled += m_keyGroups.size();
+            m_numKeysCulled += m_keys.size();
+            if(m_keyBatch)
+            {
+                for(unsigned int j = 0; j < m_keys.size(); j++)
+                    m_keyBatch->setVisible(drawIndex++, false);
+            } // if
+            continue;
+        } // if
+        
+        for(unsigned int i = 0; i < m_keyGroups.size(); i++)
+        {
+            KeyGroup& group = m_keyGroups[i];
+            
+            // Reject the whole group at once if possible
+            if(!m_frustum.boxIsVisible(group.boundsMin + offset, group.boundsMax + offset))
+            {
+                m_numGroupsCulled++;
+                m_numKeysCulled += group.keys.size();
+                if(m_keyBatch)
+                {
+                    for(unsigned int j = 0; j < group.keys.size(); j++)
+                        m_keyBatch->setVisible(drawIndex++, false);
+                } // if
+                continue;
+            } // if
+            
+            for(unsigned int j = 0; j < group.keys.size(); j++)
+            {
+                glm::vec3 boundsMin;
+                glm::vec3 boundsMax;
+                group.keys[j]->getWorldBounds(boundsMin, boundsMax);
+                boundsMin += offset;
+                boundsMax += offset;
+                bool isVisible = m_frustum.boxIsVisible(boundsMin, boundsMax);
+                if(isVisible)
+                    m_numKeysDrawn++;
+                else
+                    m_numKeysCulled++;
+                
+                if(m_keyBatch)
+                {
+                    // Only update the batch; it is all drawn at the end
+                    m_keyBatch->setVisible(drawIndex, isVisible);
+                    m_keyBatch->setTranslation(drawIndex, group.keys[j]->getTransform()->getPos() + offset);
+                    drawIndex++;
+                } // if
+                else if(isVisible)
+                {
+                    // Queue the key, sorted by state and then by distance
+                    float depth = glm::distance(camera->getRenderPos(), (boundsMin + boundsMax) * 0.5f) / camera->getZFar();
+                    m_renderQueue.submit(group.keys[j], depth, offset);
+                } // else if
+            } // for
+        } // for
+    } // for
+    
+    if(m_keyBatch)
+        m_keyBatch->draw(camera);
+    else
+        m_renderQueue.flush(camera);
+} // KeyboardKeys::draw()
+
+//--------------------------------------------------------------------------
+/**
+ Switches to drawing all of the keys with one call, using a
+ KeyBatch which holds the geometry of every kind of key in one
+ buffer. Only call this if KeyBatch::isSupported() is true.
+*/
+void KeyboardKeys::useBatchRendering()
+{
+    delete m_keyBatch;
+    m_keyBatch = new KeyBatch(m_shaders->getShader(getBatchFeatures()));
+    
+    // Add the variants in the same order as the enum
+    for(unsigned int i = 0; i < KeyboardLayout::NUM_KEY_VARIANTS; i++)
+        m_keyBatch->addVariant(&m_variantVertices[i][0], (unsigned int)m_variantVertices[i].size(), &m_variantIndices[i][0], (unsigned int)m_variantIndices[i].size());
+    
+    m_keyBatch->setMaterialProperties(WHITE_MATERIAL, WHITE_A, WHITE_D, WHITE_S, SPECULAR_EXPONENT);
+    m_keyBatch->setMaterialProperties(BLACK_MATERIAL, BLACK_A, BLACK_D, BLACK_S, SPECULAR_EXPONENT);
+    
+    // One draw per key on each keyboard, in the same order that
+    // draw() walks the keyboards and groups
+    for(unsigned int k = 0; k < m_keyboardOffsets.size(); k++)
+    {
+        for(unsigned int i = 0; i < m_keyGroups.size(); i++)
+        {
+            KeyGroup& group = m_keyGroups[i];
+            for(unsigned int j = 0; j < group.keys.size(); j++)
+            {
+                unsigned int material = (group.variants[j] == KeyboardLayout::BLACK_VARIANT) ? BLACK_MATERIAL : WHITE_MATERIAL;
+                m_keyBatch->addDraw(group.variants[j], material, group.keys[j]->getTransform()->getPos() + m_keyboardOffsets[k]);
+            } // for
+        } // for
+    } // for
+    
+    m_keyBatch->upload();
+} // KeyboardKeys::useBatchRendering()
+
+//--------------------------------------------------------------------------
+/**
+ Draws copies of the keyboard on a grid (as square as it can
+ be, with rows going back from the first keyboard), to see how
+ drawing scales with the size of the scene. The copies share
+ the keys of the first one (their meshes and sounds), so they
+ all move together, and only the first one casts shadows. The
+ lighting of the copies is worked out by the shaders, so do
+ not bake it when there are copies. The batch, if used, is
+ made again with a draw for every key on every keyboard.
+ 
+ @param numKeyboards How many keyboards to draw (at least 1).
+*/
+void KeyboardKeys::setNumKeyboards(unsigned int numKeyboards)
+{
+    if(numKeyboards < 1)
+        numKeyboards = 1;
+    m_numColumns = (unsigned int)ceil(sqrt((double)numKeyboards));
+    m_keyboardOffsets.clear();
+    for(unsigned int i = 0; i < numKeyboards; i++)
+        m_keyboardOffsets.push_back(glm::vec3((i % m_numColumns) * m_columnSpacing, 0.0f, -(float)(i / m_numColumns) * ROW_SPACING));
+    
+    if(m_keyBatch)
+        useBatchRendering();
+} // KeyboardKeys::setNumKeyboards(unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Works out the lighting of the keys at rest ahead of time, so
+ that only the specular light is worked out every frame. Keys
+ that are being pressed are lit as before. Call this after
+ useBatchRendering() if the batch is used.
+ 
+ @param lights The lights the shaders are lit with (in the
+ same order, since the first one may be shadowed).
+ @param numLights The number of lights in the array.
+*/
+void KeyboardKeys::bakeLighting(Light* lights, unsigned int numLights)
+{
+    LightBaker baker(lights, numLights);
+    if(m_keyBatch)
+    {
+        m_keyBatch->bakeLighting(baker, m_shaders->getShader(getBatchFeatures() | ShaderLibrary::BAKED_LIGHTING_F));
+        return;
+    } // if
+    
+    unsigned int features = ShaderLibrary::TRANSLATION_ONLY_F | ShaderLibrary::BAKED_LIGHTING_F;
+    Shader* whiteShader = m_shaders->getShaderForMaterial(WHITE_D, WHITE_S, features);
+    Shader* blackShader = m_shaders->getShaderForMaterial(BLACK_D, BLACK_S, features);
+    for(unsigned int i = 0; i < m_keys.size(); i++)
+        m_keys[i]->bakeLighting(baker, m_layout.getKey(i).isBlack ? blackShader : whiteShader);
+} // KeyboardKeys::bakeLighting(Light*, unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Prints how much memory the keys' vertices and indices take on
+ the GPU, and how many vertex bytes are fetched to draw every key
+ once, both as they are packed and as they would be with float
+ attributes in separate buffers and 32-bit indices. The fetch
+ counts every index drawn (as if there were no vertex cache).
+ 
+ @param out The stream to print to.
+*/
+void KeyboardKeys::reportGeometry(std::ostream& out)
+{
+    unsigned int numBytes = 0;
+    unsigned int numUnpackedBytes = 0;
+    unsigned int numFetched = 0;
+    unsigned int numUnpackedFetched = 0;
+    for(unsigned int i = 0; i < m_keys.size(); i++)
     {
-        whiteKeys[i]->draw(camera);
+        OneKeyboardKey* key = m_keys[i];
+        numBytes += key->getNumBytes();
+        numUnpackedBytes += key->getNumUnpackedBytes();
+        numFetched += key->getDrawCount() * key->getVertexSize();
+        numUnpackedFetched += key->getDrawCount() * PackedVertices::UNPACKED_VERTEX_SIZE;
     } // for
-    for(unsigned int i = 0; i < NUM_BLACK_KEYS; i++)
+    out << "Key geometry: " << numBytes << " bytes (" << numUnpackedBytes << " unpacked) in "
+        << m_keys.size() << " meshes, " << numBytes / m_keys.size() << " per mesh; "
+        << m_keys[0]->getVertexSize() << " bytes per vertex (" << PackedVertices::UNPACKED_VERTEX_SIZE << " unpacked); "
+        << numFetched << " bytes fetched to draw every key (" << numUnpackedFetched << " unpacked)" << std::endl;
+    if(m_keyBatch)
+        out << "Key batch geometry: " << m_keyBatch->getNumBytes() << " bytes (" << m_keyBatch->getNumUnpackedBytes()
+            << " unpacked), " << m_keyBatch->getVertexSize() << " bytes per vertex" << std::endl;
+    m_meshOptimizer.report(out);
+} // KeyboardKeys::reportGeometry(std::ostream&)
+
+//--------------------------------------------------------------------------
+/**
+ Gets the paths of the sound files of every key (organ then
+ piano, from the lowest note up).
+ 
+ @param paths The vector to add the paths to.
+*/
+void KeyboardKeys::getSoundPaths(std::vector<std::string>& paths)
+{
+    for(unsigned int i = 0; i < m_layout.getNumKeys(); i++)
     {
-        blackKeys[i]->draw(camera);
+        const KeyboardLayout::Key& key = m_layout.getKey(i);
+        paths.push_back(resFolder + ORGAN_FOLDER + key.sampleName + SOUND_EXTENSION);
+        paths.push_back(resFolder + PIANO_FOLDER + key.sampleName + SOUND_EXTENSION);
     } // for
-} // KeyboardKeys::draw()
+} // KeyboardKeys::getSoundPaths(std::vector<std::string>&)
+
+//--------------------------------------------------------------------------
+/**
+ Gets the features of the shader used to draw the batch. The
+ batch draws both materials with one shader, so the shader
+ has every feature that either material needs.
+ 
+ @return The features (ShaderLibrary bit flags).
+*/
+unsigned int KeyboardKeys::getBatchFeatures()
+{
+    unsigned int features = ShaderLibrary::KEY_BATCH_F;
+    features |= m_shaders->getFeaturesForMaterial(WHITE_D, WHITE_S);
+    features |= m_shaders->getFeaturesForMaterial(BLACK_D, BLACK_S);
+    return features;
+} // KeyboardKeys::getBatchFeatures()
 
 //--------------------------------------------------------------------------
 /**
  Gets the key which the user is selecting based on the
- user's x-position. While this seems trivial, it involves
- distinguishing between white and black notes (which follow
- a regular 12-note pattern).
- It identifies the edge cases, and then identifies which
- octave the notes lie in (where Ab0 through G1 on the keyboard
- are all considered in "octave 1" for simpler coding, despite
- the fact that Ab0 does not exist. This is irrelevant, so the
- implementation uses a simpler method).
- Then, it finds which of the 12 black/white notes is being
- selected in the given octave, and the index of the key
- is returned.
+ user's x-position. The layout has already worked out which
+ key is under each quarter of a white key (a black key takes
+ the quarter of each white key beside it), so this is a lookup.
  
- @return The index of the note being returned. The convention is
- that 0-51 are for white notes, -1 is for no selection, and
- (-2)-(-37) are for black notes (to distinguish between which
- array the note is in, since if it is below -1, we know the key
- is in the black keys array).
+ @return The index of the key being selected (numbered from
+ the lowest note up), or -1 for no selection.
 */
 int KeyboardKeys::getSelectedKey(glm::vec3 position)
 {
+    // Over a keyboard to the side of the first, use the key there
+    // (the copies share the first keyboard's keys)
     float x = position.x;
-    
-    // --------EDGE CASES--------
-    // Edge case: too far left, no note
-    if(x < 0)   return -1;
-    // If it's super small, then just select the first key
-    if(x < X_DIFF_BETWEEN_WHITE_KEYS * 0.75)   return 0;
-    // Edge case: too far right, no note
-    if(x > NUM_WHITE_KEYS * X_DIFF_BETWEEN_WHITE_KEYS)  return -1;
-    // If it's super high, then just select the white key
-    if(x > ((double)NUM_WHITE_KEYS - 0.5) * X_DIFF_BETWEEN_WHITE_KEYS)    return NUM_WHITE_KEYS - 1;
-    
-    // Get the index of the key (in terms of white key positions)
-    double keyIndex = x / X_DIFF_BETWEEN_WHITE_KEYS;
-    int octave = keyIndex/NUM_KEYS_IN_OCTAVE;
-    // To make it easier to count, make the index
-    // just start from the beginning of the octave
-    keyIndex = fmod(keyIndex, NUM_KEYS_IN_OCTAVE);
-    
-    // Ab key (right end of it)
-    if(keyIndex < 0.25)
-        return (int)(- octave * 5 - 1);
-    // A key
-    if(keyIndex < 0.75)
-        return (int)(octave * 7);
-    // Bb key
-    if(keyIndex < 1.25)
-        return (int)(- octave * 5 - 2);
-    // B key
-    if(keyIndex < 2)
-        return (int)(octave * 7 + 1);
-    // C key
-    if(keyIndex < 2.75)
-        return (int)(octave * 7 + 2);
-    // Db key
-    if(keyIndex < 3.25)
-        return (int)(- octave * 5 - 3);
-    // D
-    if(keyIndex < 3.75)
-        return (int)(octave * 7 + 3);
-    // Eb key
-    if(keyIndex < 4.25)
-        return (int)(- octave * 5 - 4);
-    // E
-    if(keyIndex < 5)
-        return (int)(octave * 7 + 4);
-    // F
-    if(keyIndex < 5.75)
-        return (int)(octave * 7 + 5);
-    // Gb
-    if(keyIndex < 6.25)
-        return (int)(- octave * 5 - 5);
-    // G
-    if(keyIndex < 6.75)
-        return (int)(octave * 7 + 6);
-    // Ab (left end of it)
-    return (int)(- octave * 5 - 6);
+    if(m_numColumns > 1 && x > m_columnSpacing)
+        x -= std::min((unsigned int)(x / m_columnSpacing), m_numColumns - 1) * m_columnSpacing;
+    return m_layout.getKeyAt(x);
 } // KeyboardKeys::getSelectedKey()
 
+//--------------------------------------------------------------------------
+/**
+ Updates a shadow map with the keys, split into the keys
+ at rest and the keys that are pressed. Keys are always
+ listed in the same order, so the shadow map can tell when
+ a key starts or stops moving.
+ 
+ @param shadowMap The shadow map to update.
+*/
+void KeyboardKeys::updateShadows(ShadowMap* shadowMap)
+{
+    m_restingKeys.clear();
+    m_movingKeys.clear();
+    for(unsigned int i = 0; i < m_keys.size(); i++)
+    {
+        if(m_keys[i]->isDrawnAtRest())
+            m_restingKeys.push_back(m_keys[i]);
+        else
+            m_movingKeys.push_back(m_keys[i]);
+    } // for
+    shadowMap->update(m_restingKeys, m_movingKeys);
+} // KeyboardKeys::updateShadows(ShadowMap*)
+
+//--------------------------------------------------------------------------
+/**
+ Plays the keys' sounds through an offline mixer instead of
+ SDL Mixer, so that a session can be rendered at any speed.
+ 
+ @param mixer The mixer to play the sounds through (NULL for
+ SDL Mixer).
+*/
+void KeyboardKeys::setOfflineMixer(OfflineMixer* mixer)
+{
+    for(unsigned int i = 0; i < m_keys.size(); i++)
+        m_keys[i]->setOfflineMixer(mixer);
+} // KeyboardKeys::setOfflineMixer(OfflineMixer*)
+
+//--------------------------------------------------------------------------
+/**
+ Moves every key that is going up or down by the time passed
+ on the simulation's clock (one step every DELAY milliseconds).
+ 
+ @param ms Milliseconds passed on the simulation's clock.
+ @return True if any key moved.
+*/
+bool KeyboardKeys::advanceClock(float ms)
+{
+    bool isMoved = false;
+    for(unsigned int i = 0; i < m_keys.size(); i++)
+        isMoved = m_keys[i]->advanceClock(ms, (float)DELAY) || isMoved;
+    return isMoved;
+} // KeyboardKeys::advanceClock(float)
+
+//--------------------------------------------------------------------------
+/**
+ Presses down the key under a position (and lets go of the key
+ that was down before), if it is not already down.
+ 
+ @param position The position, usually the camera's.
+*/
+void KeyboardKeys::pressKeyAt(const glm::vec3& position)
+{
+    keyDown(getSelectedKey(position));
+} // KeyboardKeys::pressKeyAt(const glm::vec3&)
+
+//--------------------------------------------------------------------------
+/**
+ Copies how far down each key is in the simulation, so that
+ the keys can be drawn from the copy on another thread.
+ 
+ @param levels Where to copy the levels (getNumKeys() of them,
+ from the lowest note up).
+*/
+void KeyboardKeys::getKeyLevels(signed char* levels)
+{
+    for(unsigned int i = 0; i < m_keys.size(); i++)
+        levels[i] = (signed char)m_keys[i]->getKeyLevel();
+} // KeyboardKeys::getKeyLevels(signed char*)
+
+//--------------------------------------------------------------------------
+/**
+ Moves the keys to be drawn at the levels copied by
+ getKeyLevels(). Only the render thread calls this.
+ 
+ @param levels The levels of the keys (getNumKeys() of them,
+ from the lowest note up).
+*/
+void KeyboardKeys::setDrawnLevels(const signed char* levels)
+{
+    for(unsigned int i = 0; i < m_keys.size(); i++)
+        m_keys[i]->setDrawnLevel(levels[i]);
+} // KeyboardKeys::setDrawnLevels(const signed char*)
+
 //--------------------------------------------------------------------------
 /**
  Checks if a given key is already down
  
  @param key Integer representing the index of the
- desired key (-2 or lower if it is a black key, as
- per convention).
+ desired key (from the lowest note up).
  @return True if the key is down.
 */
 bool KeyboardKeys::keyIsDown(int key)
@@ -285,182 +530,154 @@ bool KeyboardKeys::keyIsDown(int key)
 */
 bool KeyboardKeys::keyIsMoving()
 {
-    // Distinguish between cases (white vs black)
-    if(m_curKeyDown >= 0 && m_curKeyDown < NUM_WHITE_KEYS) // WHITE keys
-        return whiteKeys[m_curKeyDown]->keyIsMoving();
-    else if(m_curKeyDown < -1 && m_curKeyDown > - (NUM_BLACK_KEYS + 2)) // BLACK keys
-        return blackKeys[- (m_curKeyDown + 2)]->keyIsMoving();
-    else // NO keys
-        return false;
+    return m_curKeyDown >= 0 && m_keys[m_curKeyDown]->keyIsMoving();
 } // KeyboardKeys::keyIsMoving()
 
 //--------------------------------------------------------------------------
 /**
  Moves down a keyboard key incrementally based on the
- index (which is 0+ for white, -1 for none, and -2- for
- black). Pulls up the key that was previously down.
+ index (from the lowest note up, or -1 for none). Pulls
+ up the key that was previously down.
  Does nothing if the key was already down or if the key
  does not exist.
  
- @param key Index of the key to push down (0+ for white, -2-
- for black).
+ @param key Index of the key to push down.
 */
 void KeyboardKeys::keyDown(int key)
 {
     // Make sure the current key is different from the key selected
-    if(m_curKeyDown != key)
+    if(m_curKeyDown != key && key >= 0 && key < (int)m_keys.size())
     {
-        // Check if the key to press is white
-        if(key >= 0 && key < NUM_WHITE_KEYS)
-        {
-            keyUp(m_curKeyDown);
-            m_curKeyDown = key;
-            OneKeyboardKey* theKey = whiteKeys[key];
-            theKey->playSound(m_soundToUse);
-            SDL_AddTimer(DELAY, pressDownKey, theKey);
-        } // if
-        // Check if the key to press is black
-        // Convention: black keys start at -2 and
-        // go down
-        if(key < -1 && key > - (NUM_BLACK_KEYS + 2))
-        {
-            keyUp(m_curKeyDown);
-            m_curKeyDown = key;
-            int positiveKey = - (key + 2);
-            OneKeyboardKey* theKey = blackKeys[positiveKey];
-            theKey->playSound(m_soundToUse);
-            SDL_AddTimer(DELAY, pressDownKey, theKey);
-        } // if
+        keyUp(m_curKeyDown);
+        m_curKeyDown = key;
+        OneKeyboardKey* theKey = m_keys[key];
+        theKey->playSound(m_soundToUse, m_envelopes[m_soundToUse]);
+        theKey->startMoving(-1);
     } // if
 } // KeyboardKeys::keyDown(int)
 
 //--------------------------------------------------------------------------
 /**
  Moves up a keyboard key incrementally based on the
- index (which is 0+ for white, -1 for none, and -2- for
- black).
+ index (from the lowest note up, or -1 for none).
  Does nothing if the key was already down or if the key
  does not exist.
  
- @param key Index of the key to pull up (0+ for white, -2-
- for black).
+ @param key Index of the key to pull up.
  */
 void KeyboardKeys::keyUp(int key)
 {
-    // If it's white...
-    if(key >= 0 && key < NUM_WHITE_KEYS)
+    if(key >= 0 && key < (int)m_keys.size())
     {
-        OneKeyboardKey* theKey = whiteKeys[key];
+        OneKeyboardKey* theKey = m_keys[key];
         theKey->stopSound();
-        SDL_AddTimer(DELAY, liftUpKey, theKey);
-    } // if
-    // If it's black...
-    if(key < -1 && key > - (NUM_BLACK_KEYS + 2))
-    {
-        int positiveKey = - (key + 2);
-        OneKeyboardKey* theKey = blackKeys[positiveKey];
-        theKey->stopSound();
-        SDL_AddTimer(DELAY, liftUpKey, theKey);
+        theKey->startMoving(1);
     } // if
 } // KeyboardKeys::keyUp(int)
 
-// HELPER METHODS to create each type of key
+// HELPER METHODS to group keys for culling
 //--------------------------------------------------------------------------
 /**
- Creates a black key.
- 
- @param keysFilled Index of the blackKeys array to add
- the key.
- @param shader Pointer to the shader, used to update the
- material property uniforms in the shader.
- @param transform The model matrix for the key.
- @param keyName the name of the key, used for getting the
- audio file for the key.
+ Starts a new group of keys. Every key made after this
+ call (until the next call) is added to the group.
 */
-void KeyboardKeys::makeBlackKey(int keysFilled, Shader* shader, Transform transform, std::string keyName)
+void KeyboardKeys::startKeyGroup()
 {
-    std::string organSoundPath = resFolder + ORGAN_FOLDER + keyName + SOUND_EXTENSION;
-    std::string pianoSoundPath = resFolder + PIANO_FOLDER + keyName + SOUND_EXTENSION;
-    blackKeys[keysFilled] = new OneKeyboardKey(blackVertices, sizeof(blackVertices)/sizeof(blackVertices[0]), blackKeyIndices, sizeof(blackKeyIndices)/sizeof(blackKeyIndices[0]), shader, transform, organSoundPath, pianoSoundPath);
-    blackKeys[keysFilled]->setMaterialProperties(BLACK_A, BLACK_D, BLACK_S, SPECULAR_EXPONENT);
-} // KeyboardKeys::makeWhiteKey(int, Shader*, Transform, std::string)
+    m_keyGroups.push_back(KeyGroup());
+} // KeyboardKeys::startKeyGroup()
 
 //--------------------------------------------------------------------------
 /**
- Creates a white key with no notches.
+ Adds a key to the group that was started last.
  
- @param keysFilled Index of the whiteKeys array to add
- the key.
- @param shader Pointer to the shader, used to update the
- material property uniforms in the shader.
- @param transform The model matrix for the key.
- @param keyName the name of the key, used for getting the
- audio file for the key.
- */
-void KeyboardKeys::makeWhiteKey(int keysFilled, Shader* shader, Transform transform, std::string keyName)
+ @param key The key to add.
+ @param variant Which kind of key it is.
+*/
+void KeyboardKeys::addKeyToGroup(OneKeyboardKey* key, unsigned int variant)
 {
-    std::string organSoundPath = resFolder + ORGAN_FOLDER + keyName + SOUND_EXTENSION;
-    std::string pianoSoundPath = resFolder + PIANO_FOLDER + keyName + SOUND_EXTENSION;
-    whiteKeys[keysFilled] = new OneKeyboardKey(whiteVertices, sizeof(whiteVertices)/sizeof(whiteVertices[0]), whiteKeyIndices, sizeof(whiteKeyIndices)/sizeof(whiteKeyIndices[0]), shader, transform, organSoundPath, pianoSoundPath);
-    whiteKeys[keysFilled]->setMaterialProperties(WHITE_A, WHITE_D, WHITE_S, SPECULAR_EXPONENT);
-} // KeyboardKeys::makeWhiteKey(int, Shader*, Transform, std::string)
+    m_keyGroups.back().keys.push_back(key);
+    m_keyGroups.back().variants.push_back(variant);
+} // KeyboardKeys::addKeyToGroup(OneKeyboardKey*, unsigned int)
 
 //--------------------------------------------------------------------------
 /**
- Creates a white key with no right notch.
- 
- @param keysFilled Index of the whiteKeys array to add
- the key.
- @param shader Pointer to the shader, used to update the
- material property uniforms in the shader.
- @param transform The model matrix for the key.
- @param keyName the name of the key, used for getting the
- audio file for the key.
- */
-void KeyboardKeys::makeWhiteKeyR(int keysFilled, Shader* shader, Transform transform, std::string keyName)
+ Computes the bounding box of each group of keys once all
+ the keys are made, and the box around the whole keyboard.
+ The box is stretched down by how far a key can be pressed so
+ that it stays valid while the keys in the group are moving.
+*/
+void KeyboardKeys::finishKeyGroups()
 {
-    std::string organSoundPath = resFolder + ORGAN_FOLDER + keyName + SOUND_EXTENSION;
-    std::string pianoSoundPath = resFolder + PIANO_FOLDER + keyName + SOUND_EXTENSION;
-    whiteKeys[keysFilled] = new OneKeyboardKey(whiteVertices, sizeof(whiteVertices)/sizeof(whiteVertices[0]), whiteKeyIndicesR, sizeof(whiteKeyIndicesR)/sizeof(whiteKeyIndicesR[0]), shader, transform, organSoundPath, pianoSoundPath);
-    whiteKeys[keysFilled]->setMaterialProperties(WHITE_A, WHITE_D, WHITE_S, SPECULAR_EXPONENT);
-} // KeyboardKeys::makeWhiteKeyR(int, Shader*, Transform, std::string)
+    for(unsigned int i = 0; i < m_keyGroups.size(); i++)
+    {
+        KeyGroup& group = m_keyGroups[i];
+        for(unsigned int j = 0; j < group.keys.size(); j++)
+        {
+            glm::vec3 boundsMin;
+            glm::vec3 boundsMax;
+            group.keys[j]->getWorldBounds(boundsMin, boundsMax);
+            boundsMin.y -= group.keys[j]->getKeypressDepth();
+            if(j == 0)
+            {
+                group.boundsMin = boundsMin;
+                group.boundsMax = boundsMax;
+            } // if
+            else
+            {
+                group.boundsMin = glm::min(group.boundsMin, boundsMin);
+                group.boundsMax = glm::max(group.boundsMax, boundsMax);
+            } // else
+        } // for
+        m_boundsMin = (i == 0) ? group.boundsMin : glm::min(m_boundsMin, group.boundsMin);
+        m_boundsMax = (i == 0) ? group.boundsMax : glm::max(m_boundsMax, group.boundsMax);
+    } // for
+} // KeyboardKeys::finishKeyGroups()
 
+// HELPER METHODS to create each type of key
 //--------------------------------------------------------------------------
 /**
- Creates a white key with left notch.
+ Copies the mesh of a kind of key (built while compiling) so
+ that the keys of that kind can be made from it.
  
- @param keysFilled Index of the whiteKeys array to add
- the key.
- @param shader Pointer to the shader, used to update the
- material property uniforms in the shader.
- @param transform The model matrix for the key.
- @param keyName the name of the key, used for getting the
- audio file for the key.
- */
-void KeyboardKeys::makeWhiteKeyL(int keysFilled, Shader* shader, Transform transform, std::string keyName)
+ @param variant Which kind of key the mesh is for.
+ @param vertices The vertices of the mesh.
+ @param numVertices The number of vertices.
+ @param indices The indices of the mesh's triangles.
+ @param numIndices The number of indices.
+*/
+void KeyboardKeys::useKeyMesh(unsigned int variant, const KeyVertex* vertices, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices)
 {
-    std::string organSoundPath = resFolder + ORGAN_FOLDER + keyName + SOUND_EXTENSION;
-    std::string pianoSoundPath = resFolder + PIANO_FOLDER + keyName + SOUND_EXTENSION;
-    whiteKeys[keysFilled] = new OneKeyboardKey(whiteVertices, sizeof(whiteVertices)/sizeof(whiteVertices[0]), whiteKeyIndicesL, sizeof(whiteKeyIndicesL)/sizeof(whiteKeyIndicesL[0]), shader, transform, organSoundPath, pianoSoundPath);
-    whiteKeys[keysFilled]->setMaterialProperties(WHITE_A, WHITE_D, WHITE_S, SPECULAR_EXPONENT);
-} // KeyboardKeys::makeWhiteKeyL(int, Shader*, Transform, std::string)
+    m_variantVertices[variant].clear();
+    for(unsigned int i = 0; i < numVertices; i++)
+    {
+        const KeyPoint& position = vertices[i].position;
+        const KeyPoint& normal = vertices[i].normal;
+        m_variantVertices[variant].push_back(Vertex(glm::vec3(position.x, position.y, position.z), glm::vec3(normal.x, normal.y, normal.z)));
+    } // for
+    m_variantIndices[variant].assign(indices, indices + numIndices);
+} // KeyboardKeys::useKeyMesh(unsigned int, const KeyVertex*, unsigned int, const unsigned int*, unsigned int)
 
 //--------------------------------------------------------------------------
 /**
- Creates a white key with both a left and right notch.
+ Creates a key, with the mesh, material and sounds of the
+ kind of key the layout says it is.
  
- @param keysFilled Index of the whiteKeys array to add
- the key.
+ @param key The key in the layout.
  @param shader Pointer to the shader, used to update the
  material property uniforms in the shader.
  @param transform The model matrix for the key.
- @param keyName the name of the key, used for getting the
- audio file for the key.
  */
-void KeyboardKeys::makeWhiteKeyLR(int keysFilled, Shader* shader, Transform transform, std::string keyName)
+void KeyboardKeys::makeKey(const KeyboardLayout::Key& key, Shader* shader, Transform transform)
 {
-    std::string organSoundPath = resFolder + ORGAN_FOLDER + keyName + SOUND_EXTENSION;
-    std::string pianoSoundPath = resFolder + PIANO_FOLDER + keyName + SOUND_EXTENSION;
-    whiteKeys[keysFilled] = new OneKeyboardKey(whiteVertices, sizeof(whiteVertices)/sizeof(whiteVertices[0]), whiteKeyIndicesLR, sizeof(whiteKeyIndicesLR)/sizeof(whiteKeyIndicesLR[0]), shader, transform, organSoundPath, pianoSoundPath);
-    whiteKeys[keysFilled]->setMaterialProperties(WHITE_A, WHITE_D, WHITE_S, SPECULAR_EXPONENT);
-} // KeyboardKeys::makeWhiteKeyLR(int, Shader*, Transform, std::string)
+    std::string organSoundPath = resFolder + ORGAN_FOLDER + key.sampleName + SOUND_EXTENSION;
+    std::string pianoSoundPath = resFolder + PIANO_FOLDER + key.sampleName + SOUND_EXTENSION;
+    std::vector<Vertex>& vertices = m_variantVertices[key.variant];
+    std::vector<unsigned int>& indices = m_variantIndices[key.variant];
+    OneKeyboardKey* newKey = new OneKeyboardKey(&vertices[0], (unsigned int)vertices.size(), &indices[0], (unsigned int)indices.size(), shader, transform, organSoundPath, pianoSoundPath);
+    addKeyToGroup(newKey, key.variant);
+    if(key.isBlack)
+        newKey->setMaterialProperties(BLACK_A, BLACK_D, BLACK_S, SPECULAR_EXPONENT);
+    else
+        newKey->setMaterialProperties(WHITE_A, WHITE_D, WHITE_S, SPECULAR_EXPONENT);
+    m_keys.push_back(newKey);
+} // KeyboardKeys::makeKey(const KeyboardLayout::Key&, Shader*, Transform)
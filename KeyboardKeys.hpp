@@ -16,17 +16,30 @@
 
 #include "OneKeyboardKey.hpp"
 #include "Shader.hpp"
+#include "ShaderLibrary.hpp"
 #include "Camera.hpp"
+#include "Frustum.hpp"
+#include "KeyBatch.hpp"
+#include "RenderQueue.hpp"
+#include "ShadowMap.hpp"
+#include "LightBaker.hpp"
+#include "MeshOptimizer.hpp"
+#include "KeyGeometry.hpp"
+#include "KeyboardLayout.hpp"
 #include <glm/glm.hpp>
+#include <ostream>
 #include <string>
+#include <vector>
 
 class KeyboardKeys
 {
 public:
-    KeyboardKeys(Shader* shader, std::string resourceFolder); // Constructor
+    KeyboardKeys(ShaderLibrary* shaders, std::string resourceFolder, const KeyboardLayout& layout); // Constructor
     virtual ~KeyboardKeys(); // Destructor
     
     void nextSoundSetting(); // Set whether use piano or organ sound
+    void setSoundSetting(unsigned int sound);
+    void setEnvelope(unsigned int sound, const EnvelopeShape& shape);
     void draw(Camera* camera);
     bool aKeyIsGoingDown();
     bool keyIsDown(int key);
@@ -34,24 +47,97 @@ public:
     int getSelectedKey(glm::vec3 position);
     void keyDown(int key);
     void keyUp(int key);
+    void useBatchRendering();
+    void setNumKeyboards(unsigned int numKeyboards);
+    void updateShadows(ShadowMap* shadowMap);
+    void bakeLighting(Light* lights, unsigned int numLights);
+    void reportGeometry(std::ostream& out);
+    void getSoundPaths(std::vector<std::string>& paths);
+    void setOfflineMixer(OfflineMixer* mixer);
+    bool advanceClock(float ms);
+    void pressKeyAt(const glm::vec3& position);
+    void getKeyLevels(signed char* levels);
+    void setDrawnLevels(const signed char* levels);
+    
+    /**
+     Gets how many keys there are (white and black).
+     */
+    inline unsigned int getNumKeys() { return m_layout.getNumKeys(); }
+    /**
+     Gets which sound the keys play (OneKeyboardKey::ORGAN_SOUND
+     or OneKeyboardKey::PIANO_SOUND).
+     */
+    inline unsigned int getSoundSetting() { return m_soundToUse; }
+    
+    /**
+     Gets how many keys were drawn in the last call to draw().
+     */
+    inline unsigned int getNumKeysDrawn() { return m_numKeysDrawn; }
+    /**
+     Gets how many keys were culled in the last call to draw().
+     */
+    inline unsigned int getNumKeysCulled() { return m_numKeysCulled; }
+    /**
+     Gets how many whole key groups (octaves) were culled in
+     the last call to draw().
+     */
+    inline unsigned int getNumGroupsCulled() { return m_numGroupsCulled; }
+    /**
+     Gets how many whole keyboards were culled in the last call
+     to draw().
+     */
+    inline unsigned int getNumKeyboardsCulled() { return m_numKeyboardsCulled; }
+    /**
+     Gets how many copies of the keyboard are drawn (on a grid).
+     */
+    inline unsigned int getNumKeyboards() { return (unsigned int)m_keyboardOffsets.size(); }
+    /**
+     Gets how wide the grid of keyboards is.
+     */
+    inline float getGridWidth() { return m_numColumns * m_columnSpacing; }
+    /**
+     Gets how many OpenGL state changes were skipped in the
+     last call to draw() because the state was already set.
+     */
+    inline unsigned int getNumStateChangesAvoided() { return m_renderQueue.getNumStateChangesAvoided(); }
 private:
-    // Helper methods to create new white keys
-    void makeBlackKey(int keysFilled, Shader* shader, Transform transform, std::string keyName);
-    void makeWhiteKey(int keysFilled, Shader* shader, Transform transform, std::string keyName);
-    void makeWhiteKeyR(int keysFilled, Shader* shader, Transform transform, std::string keyName);
-    void makeWhiteKeyL(int keysFilled, Shader* shader, Transform transform, std::string keyName);
-    void makeWhiteKeyLR(int keysFilled, Shader* shader, Transform transform, std::string keyName);
+    // A group of keys (usually one octave) with a bounding box
+    // around all of them, so that the whole group can be culled
+    // at once when it is outside of the camera's view.
+    struct KeyGroup
+    {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        std::vector<OneKeyboardKey*> keys;
+        std::vector<unsigned int> variants; // Which kind of key each one is
+    }; // KeyGroup
+    
+    // The materials used when drawing in a batch
+    enum {
+        WHITE_MATERIAL,
+        BLACK_MATERIAL
+    }; // enum
+    
+    // Helper methods to group keys for culling
+    void startKeyGroup();
+    void addKeyToGroup(OneKeyboardKey* key, unsigned int variant);
+    void finishKeyGroups();
+    
+    unsigned int getBatchFeatures();
+    
+    // Helper methods to create new keys
+    void useKeyMesh(unsigned int variant, const KeyVertex* vertices, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices);
+    void makeKey(const KeyboardLayout::Key& key, Shader* shader, Transform transform);
     
     // Constants
-    const static unsigned int NUM_WHITE_KEYS = 52; // Number of white keys on keyboard
-    const static unsigned int NUM_BLACK_KEYS = 36; // Number of black keys on keyboard
-    const static unsigned int NUM_OCTAVES = 7; // Number of complete octaves on keyboard
-    const static unsigned int NUM_KEYS_IN_OCTAVE = 7; // Number of WHITE keys in octave
-    const static unsigned int NUM_WHITE_VERTICES = 92; // Number of WHITE vertices specified
-    const static unsigned int NUM_BLACK_VERTICES = 30; // Number of BLACK vertices specified
-    const double X_DIFF_BETWEEN_WHITE_KEYS = 2.4; // How far apart white keys are
-    const int DELAY = 10; // Milliseconds between movements of pushing down a key
+    const int DELAY = 10; // Milliseconds (of simulation time) between movements of a key
     const int KEY_UP_DELAY = 8; // Milliseconds between movements of pulling up a key
+    const float KEYBOARD_GAP = 5.0f; // Between keyboards side by side on the grid
+    const float ROW_SPACING = 25.0f; // Between the fronts of rows of keyboards on the grid
+    
+    // Default volume envelopes (attack ms, decay ms, sustain level, release ms)
+    const EnvelopeShape ORGAN_ENVELOPE = { 5.0f, 0.0f, 1.0f, 150.0f }; // Pipes stop quickly
+    const EnvelopeShape PIANO_ENVELOPE = { 2.0f, 0.0f, 1.0f, 1000.0f }; // The damper takes a while
     
     // Material properties
     const float SPECULAR_EXPONENT = 1000; // Shininess of a key
@@ -68,339 +154,58 @@ private:
     const std::string PIANO_FOLDER = "/piano_sounds/";
     std::string resFolder;
     
-    // Holds an array of all the white and black keys
-    OneKeyboardKey** whiteKeys;
-    OneKeyboardKey** blackKeys;
+    // Where the keys get their shaders from
+    ShaderLibrary* m_shaders;
     
-    // Index of the key that is currently down
-    int m_curKeyDown;
+    // Where each key goes, what it looks like and sounds like
+    KeyboardLayout m_layout;
     
-    // Hold which sound to use
-    unsigned int m_soundToUse; // 0 for organ, 1 for piano.
+    // Holds all the keys, from the lowest note up (as in the layout)
+    std::vector<OneKeyboardKey*> m_keys;
     
-    // Holds all the white vertices
-    Vertex whiteVertices[NUM_WHITE_VERTICES] =
-    {
-        //----------------------------------
-        // Vertices: Front to back
-        //----------------------------------
-        // z = 0.2
-        Vertex(glm::vec3(0.0, 1.7, 0.2), glm::vec3(0, 0, 1)), // 0
-        Vertex(glm::vec3(0.1, 1.9, 0.2), glm::vec3(0, 0, 1)), // 1
-        Vertex(glm::vec3(2.1, 1.9, 0.2), glm::vec3(0, 0, 1)), // 2
-        Vertex(glm::vec3(2.2, 1.7, 0.2), glm::vec3(0, 0, 1)), // 3
-        // z = 0.0
-        Vertex(glm::vec3(0.0, 0.0, 0.0), glm::vec3(0, 0, 1)), // 4
-        Vertex(glm::vec3(0.0, 1.7, 0.0), glm::vec3(0, 0, 1)), // 5
-        Vertex(glm::vec3(2.2, 1.7, 0.0), glm::vec3(0, 0, 1)), // 6
-        Vertex(glm::vec3(2.2, 0.0, 0.0), glm::vec3(0, 0, 1)), // 7
-        // z = -5.0
-        Vertex(glm::vec3(0.0, 0.0, -5.0), glm::vec3(0, 0, -1)), // 8
-        Vertex(glm::vec3(0.0, 1.7, -5.0), glm::vec3(0, 0, -1)), // 9
-        Vertex(glm::vec3(0.1, 1.9, -5.0), glm::vec3(0, 0, -1)), // 10
-        Vertex(glm::vec3(0.7, 1.9, -5.0), glm::vec3(0, 0, -1)), // 11
-        Vertex(glm::vec3(1.5, 1.9, -5.0), glm::vec3(0, 0, -1)), // 12
-        Vertex(glm::vec3(2.1, 1.9, -5.0), glm::vec3(0, 0, -1)), // 13
-        Vertex(glm::vec3(2.2, 1.7, -5.0), glm::vec3(0, 0, -1)), // 14
-        Vertex(glm::vec3(2.2, 0.0, -5.0), glm::vec3(0, 0, -1)), // 15
-        Vertex(glm::vec3(1.5, 0.0, -5.0), glm::vec3(0, 0, -1)), // 16
-        Vertex(glm::vec3(0.7, 0.0, -5.0), glm::vec3(0, 0, -1)), // 17
-        // z = -15.0
-        Vertex(glm::vec3(0.0, 0.0, -15.0), glm::vec3(0, 0, -1)), // 18
-        Vertex(glm::vec3(0.0, 1.7, -15.0), glm::vec3(0, 0, -1)), // 19
-        Vertex(glm::vec3(0.1, 1.9, -15.0), glm::vec3(0, 0, -1)), // 20
-        Vertex(glm::vec3(0.7, 1.9, -15.0), glm::vec3(0, 0, -1)), // 21
-        Vertex(glm::vec3(1.5, 1.9, -15.0), glm::vec3(0, 0, -1)), // 22
-        Vertex(glm::vec3(2.1, 1.9, -15.0), glm::vec3(0, 0, -1)), // 23
-        Vertex(glm::vec3(2.2, 1.7, -15.0), glm::vec3(0, 0, -1)), // 24
-        Vertex(glm::vec3(2.2, 0.0, -15.0), glm::vec3(0, 0, -1)), // 25
-        Vertex(glm::vec3(1.5, 0.0, -15.0), glm::vec3(0, 0, -1)), // 26
-        Vertex(glm::vec3(0.7, 0.0, -15.0), glm::vec3(0, 0, -1)), // 27
-        //----------------------------------
-        // Vertices: Left to Right
-        //----------------------------------
-        // x = 0.0
-        Vertex(glm::vec3(0.0, 0.0, -15.0), glm::vec3(-1, 0, 0)), // 28
-        Vertex(glm::vec3(0.0, 1.7, -15.0), glm::vec3(-1, 0, 0)), // 29
-        Vertex(glm::vec3(0.0, 1.7, -5.0), glm::vec3(-1, 0, 0)), // 30
-        Vertex(glm::vec3(0.0, 1.7, 0.0), glm::vec3(-1, 0, 0)), // 31
-        Vertex(glm::vec3(0.0, 1.7, 0.2), glm::vec3(-1, 0, 0)), // 32 (not used, but for legacy purposes...)
-        Vertex(glm::vec3(0.0, 0.0, 0.0), glm::vec3(-1, 0, 0)), // 33
-        Vertex(glm::vec3(0.0, 0.0, -5.0), glm::vec3(-1, 0, 0)), // 34
-        // x = 0.1
-        Vertex(glm::vec3(0.1, 1.9, -15.0), glm::vec3(-1, 0, 0)), // 35 (not used, but for legacy purposes...)
-        Vertex(glm::vec3(0.1, 1.9, -5.0), glm::vec3(-1, 0, 0)), // 36 (not used, but for legacy purposes...)
-        Vertex(glm::vec3(0.1, 1.9, 0.2), glm::vec3(-1, 0, 0)), // 37 (not used, but for legacy purposes...)
-        // x = 0.7
-        Vertex(glm::vec3(0.7, 0.0, -15.0), glm::vec3(-1, 0, 0)), // 38
-        Vertex(glm::vec3(0.7, 1.9, -15.0), glm::vec3(-1, 0, 0)), // 39
-        Vertex(glm::vec3(0.7, 1.9, -5.0), glm::vec3(-1, 0, 0)), // 40
-        Vertex(glm::vec3(0.7, 0.0, -5.0), glm::vec3(-1, 0, 0)), // 41
-        // x = 1.5
-        Vertex(glm::vec3(1.5, 0.0, -15.0), glm::vec3(1, 0, 0)), // 42
-        Vertex(glm::vec3(1.5, 1.9, -15.0), glm::vec3(1, 0, 0)), // 43
-        Vertex(glm::vec3(1.5, 1.9, -5.0), glm::vec3(1, 0, 0)), // 44
-        Vertex(glm::vec3(1.5, 0.0, -5.0), glm::vec3(1, 0, 0)), // 45
-        // x = 2.1
-        Vertex(glm::vec3(2.1, 1.9, -15.0), glm::vec3(1, 0, 0)), // 46 (not used, but for legacy purposes...)
-        Vertex(glm::vec3(2.1, 1.9, -5.0), glm::vec3(1, 0, 0)), // 47 (not used, but for legacy purposes...)
-        Vertex(glm::vec3(2.1, 1.9, 0.2), glm::vec3(1, 0, 0)), // 48 (not used, but for legacy purposes...)
-        // x = 2.2
-        Vertex(glm::vec3(2.2, 0.0, -15.0), glm::vec3(1, 0, 0)), // 49
-        Vertex(glm::vec3(2.2, 1.7, -15.0), glm::vec3(1, 0, 0)), // 50
-        Vertex(glm::vec3(2.2, 1.7, -5.0), glm::vec3(1, 0, 0)), // 51
-        Vertex(glm::vec3(2.2, 1.7, 0.0), glm::vec3(1, 0, 0)), // 52
-        Vertex(glm::vec3(2.2, 1.7, 0.2), glm::vec3(1, 0, 0)), // 53 (not used, but for legacy purposes...)
-        Vertex(glm::vec3(2.2, 0.0, 0.0), glm::vec3(1, 0, 0)), // 54
-        Vertex(glm::vec3(2.2, 0.0, -5.0), glm::vec3(1, 0, 0)), // 55
-        //----------------------------------
-        // Vertices: Top to Bottom
-        //----------------------------------
-        // y = 1.9
-        Vertex(glm::vec3(0.1, 1.9, 0.2), glm::vec3(0, 1, 0)), // 56
-        Vertex(glm::vec3(0.1, 1.9, -5.0), glm::vec3(0, 1, 0)), // 57
-        Vertex(glm::vec3(0.1, 1.9, -15.0), glm::vec3(0, 1, 0)), // 58
-        Vertex(glm::vec3(0.7, 1.9, -15.0), glm::vec3(0, 1, 0)), // 59
-        Vertex(glm::vec3(1.5, 1.9, -15.0), glm::vec3(0, 1, 0)), // 60
-        Vertex(glm::vec3(2.1, 1.9, -15.0), glm::vec3(0, 1, 0)), // 61
-        Vertex(glm::vec3(2.1, 1.9, -5.0), glm::vec3(0, 1, 0)), // 62
-        Vertex(glm::vec3(2.1, 1.9, 0.2), glm::vec3(0, 1, 0)), // 63
-        Vertex(glm::vec3(0.7, 1.9, -5.0), glm::vec3(0, 1, 0)), // 64
-        Vertex(glm::vec3(1.5, 1.9, -5.0), glm::vec3(0, 1, 0)), // 65
-        // y = 0.0
-        Vertex(glm::vec3(0.0, 0.0, 0.0), glm::vec3(0, -1, 0)), // 66
-        Vertex(glm::vec3(0.0, 0.0, -5.0), glm::vec3(0, -1, 0)), // 67
-        Vertex(glm::vec3(0.0, 0.0, -15.0), glm::vec3(0, -1, 0)), // 68
-        Vertex(glm::vec3(0.7, 0.0, -15.0), glm::vec3(0, -1, 0)), // 69
-        Vertex(glm::vec3(1.5, 0.0, -15.0), glm::vec3(0, -1, 0)), // 70
-        Vertex(glm::vec3(2.2, 0.0, -15.0), glm::vec3(0, -1, 0)), // 71
-        Vertex(glm::vec3(2.2, 0.0, -5.0), glm::vec3(0, -1, 0)), // 72
-        Vertex(glm::vec3(2.2, 0.0, 0.0), glm::vec3(0, -1, 0)), // 73
-        Vertex(glm::vec3(0.7, 0.0, -5.0), glm::vec3(0, -1, 0)), // 74
-        Vertex(glm::vec3(1.5, 0.0, -5.0), glm::vec3(0, -1, 0)), // 75
-        //----------------------------------
-        // Vertices: Sides
-        //----------------------------------
-        // Left Side
-        Vertex(glm::vec3(0.0, 1.7, 0.2), glm::vec3(-2.0/3.0, 1.0/3.0, 0)), // 76
-        Vertex(glm::vec3(0.0, 1.7, -5.0), glm::vec3(-2.0/3.0, 1.0/3.0, 0)), // 77
-        Vertex(glm::vec3(0.0, 1.7, -15.0), glm::vec3(-2.0/3.0, 1.0/3.0, 0)), // 78
-        Vertex(glm::vec3(0.1, 1.9, -15.0), glm::vec3(-2.0/3.0, 1.0/3.0, 0)), // 79
-        Vertex(glm::vec3(0.1, 1.9, -5.0), glm::vec3(-2.0/3.0, 1.0/3.0, 0)), // 80
-        Vertex(glm::vec3(0.1, 1.9, 0.2), glm::vec3(-2.0/3.0, 1.0/3.0, 0)), // 81
-        // Right side
-        Vertex(glm::vec3(2.1, 1.9, 0.2), glm::vec3(2.0/3.0, 1.0/3.0, 0)), // 82
-        Vertex(glm::vec3(2.1, 1.9, -5.0), glm::vec3(2.0/3.0, 1.0/3.0, 0)), // 83
-        Vertex(glm::vec3(2.1, 1.9, -15.0), glm::vec3(2.0/3.0, 1.0/3.0, 0)), // 84
-        Vertex(glm::vec3(2.2, 1.7, -15.0), glm::vec3(2.0/3.0, 1.0/3.0, 0)), // 85
-        Vertex(glm::vec3(2.2, 1.7, -5.0), glm::vec3(2.0/3.0, 1.0/3.0, 0)), // 86
-        Vertex(glm::vec3(2.2, 1.7, 0.2), glm::vec3(2.0/3.0, 1.0/3.0, 0)), // 87
-        //----------------------------------
-        // Forgotten vertices: Top to Bottom y = 1.7
-        //----------------------------------
-        Vertex(glm::vec3(0.0, 1.7, 0.0), glm::vec3(0, -1, 0)), // 88
-        Vertex(glm::vec3(2.2, 1.7, 0.0), glm::vec3(0, -1, 0)), // 89
-        Vertex(glm::vec3(2.2, 1.7, 0.2), glm::vec3(0, -1, 0)), // 90
-        Vertex(glm::vec3(0.0, 1.7, 0.2), glm::vec3(0, -1, 0)), // 91
-    };
+    // Groups of keys for culling, and the frustum to cull against
+    std::vector<KeyGroup> m_keyGroups;
+    Frustum m_frustum;
     
-    // Indices for the typical white key
-    unsigned int whiteKeyIndices[66] =
-    {
-        // Front I
-        0, 3, 2, 0, 2, 1,
-        // Front II
-        4, 7, 6, 4, 6, 5,
-        // Front III N/A
-        // Front IV
-        25, 18, 19, 25, 19, 20,
-        25, 20, 23, 25, 23, 24,
-        // Left I
-        28, 33, 31, 28, 31, 29,
-        // Left II, III, IV, V N/A
-        // Left VI
-        54, 49, 50, 54, 50, 52,
-        // Top I
-        56, 63, 61, 56, 61, 58,
-        // Top II
-        91, 88, 89, 91, 89, 90,
-        // Top III
-        66, 68, 71, 66, 71, 73,
-        // SIDE L
-        78, 76, 81, 78, 81, 79,
-        // SIDE R
-        82, 87, 85, 82, 85, 84,
-    };
+    // Where each copy of the keyboard is drawn from the first one,
+    // in rows going back from the first, and a box around one keyboard
+    // (all the copies share the keys, so they are pressed together)
+    std::vector<glm::vec3> m_keyboardOffsets;
+    unsigned int m_numColumns;
+    float m_columnSpacing;
+    glm::vec3 m_boundsMin;
+    glm::vec3 m_boundsMax;
     
-    // Indices for the white key with a notch in the left side
-    unsigned int whiteKeyIndicesL[90] =
-    {
-        // Front I
-        0, 3, 2, 0, 2, 1,
-        // Front II
-        4, 7, 6, 4, 6, 5,
-        // Front III
-        8, 9, 17, 17, 9, 10,
-        17, 10, 11,
-        // Front IV
-        27, 21, 23, 27, 23, 24,
-        27, 24, 25,
-        // Left I
-        34, 33, 31, 34, 31, 30,
-        // Left II N/A
-        // Left III
-        38, 41, 40, 38, 40, 39,
-        // Left IV, V N/A
-        // Left VI
-        54, 49, 50, 54, 50, 52,
-        // Top I
-        56, 63, 62, 56, 62, 57,
-        64, 62, 61, 64, 61, 59,
-        // Top II
-        91, 88, 89, 91, 89, 90,
-        // Top III
-        66, 67, 72, 66, 72, 73,
-        74, 69, 71, 75, 71, 72,
-        // SIDE L
-        77, 76, 81, 77, 81, 80,
-        // SIDE R
-        82, 87, 85, 82, 85, 84,
-    };
+    // Sorts the keys by state before they are drawn
+    RenderQueue m_renderQueue;
     
-    // Indices for the white key with a notch in the right side
-    unsigned int whiteKeyIndicesR[90] =
-    {
-        // Front I
-        0, 3, 2, 0, 2, 1,
-        // Front II
-        4, 7, 6, 4, 6, 5,
-        // Front III
-        16, 12, 13, 16, 13, 14,
-        16, 14, 15,
-        // Front IV
-        18, 19, 20, 18, 20, 22,
-        18, 22, 26,
-        // Left I
-        28, 33, 31, 28, 31, 29,
-        // Left II, III N/A
-        // Left IV
-        42, 43, 44, 42, 44, 45,
-        // Left V N/A
-        // Left VI
-        55, 51, 52, 55, 52, 54,
-        // Top I
-        56, 63, 62, 56, 62, 57,
-        57, 65, 60, 57, 60, 58,
-        // Top II
-        91, 88, 89, 91, 89, 90,
-        // Top III
-        66, 67, 72, 66, 72, 73,
-        67, 68, 70, 67, 70, 75,
-        // SIDE L
-        78, 76, 81, 78, 81, 79,
-        // SIDE R
-        82, 87, 86, 82, 86, 83,
-    };
+    // Draws all the keys at once when supported (NULL otherwise)
+    KeyBatch* m_keyBatch;
     
-    // Indices for the white key with a notch in both the left and right sides
-    unsigned int whiteKeyIndicesLR[102] =
-    {
-        // Front I
-        0, 3, 2, 0, 2, 1,
-        // Front II
-        4, 7, 6, 4, 6, 5,
-        // Front III
-        16, 12, 13, 16, 13, 14,
-        16, 14, 15, 8, 11, 17,
-        8, 9, 10, 8, 10, 11,
-        // Front IV
-        27, 21, 22, 27, 22, 26,
-        // Left I
-        34, 33, 31, 34, 31, 30,
-        // Left II N/A
-        // Left III
-        38, 41, 40, 38, 40, 39,
-        // Left IV
-        42, 43, 44, 42, 44, 45,
-        // Left V N/A
-        // Left VI
-        55, 51, 52, 55, 52, 54,
-        // Top I
-        56, 63, 62, 56, 62, 57,
-        64, 65, 60, 64, 60, 59,
-        // Top II
-        91, 88, 89, 91, 89, 90,
-        // Top III
-        66, 67, 72, 66, 72, 73,
-        74, 69, 70, 74, 70, 75,
-        // SIDE L
-        77, 76, 81, 77, 81, 80,
-        // SIDE R
-        82, 87, 86, 82, 86, 83,
-    };
+    // Reorders the triangles of each kind of key (and keeps the results)
+    MeshOptimizer m_meshOptimizer;
     
-    // All the vertices for a black key
-    Vertex blackVertices[NUM_BLACK_VERTICES] =
-    {
-        // Front I
-        Vertex(glm::vec3(1.7, 1.9, -5.2), glm::vec3(0, 0, 1)), // 0
-        Vertex(glm::vec3(1.7, 0.0, -5.2), glm::vec3(0, 0, 1)), // 1
-        Vertex(glm::vec3(2.9, 0.0, -5.2), glm::vec3(0, 0, 1)), // 2
-        Vertex(glm::vec3(2.9, 1.9, -5.2), glm::vec3(0, 0, 1)), // 3
-        // Front II
-        Vertex(glm::vec3(1.7, 0.0, -15), glm::vec3(0, 0, -1)), // 4
-        Vertex(glm::vec3(2.9, 0.0, -15), glm::vec3(0, 0, -1)), // 5
-        Vertex(glm::vec3(2.9, 3.0, -15), glm::vec3(0, 0, -1)), // 6
-        Vertex(glm::vec3(1.7, 3.0, -15), glm::vec3(0, 0, -1)), // 7
-        // Left I
-        Vertex(glm::vec3(1.7, 0.0, -15), glm::vec3(-1, 0, 0)), // 8
-        Vertex(glm::vec3(1.7, 0.0, -5.2), glm::vec3(-1, 0, 0)), // 9
-        Vertex(glm::vec3(1.7, 1.9, -5.2), glm::vec3(-1, 0, 0)), // 10
-        Vertex(glm::vec3(1.7, 3.0, -5.9), glm::vec3(-1, 0, 0)), // 11
-        Vertex(glm::vec3(1.7, 3.0, -15), glm::vec3(-1, 0, 0)), // 12
-        // Left II
-        Vertex(glm::vec3(2.9, 0.0, -15), glm::vec3(1, 0, 0)), // 13
-        Vertex(glm::vec3(2.9, 0.0, -5.2), glm::vec3(1, 0, 0)), // 14
-        Vertex(glm::vec3(2.9, 1.9, -5.2), glm::vec3(1, 0, 0)), // 15
-        Vertex(glm::vec3(2.9, 3.0, -5.9), glm::vec3(1, 0, 0)), // 16
-        Vertex(glm::vec3(2.9, 3.0, -15), glm::vec3(1, 0, 0)), // 17
-        // Top I
-        Vertex(glm::vec3(1.7, 3.0, -5.9), glm::vec3(0, 1, 0)), // 18
-        Vertex(glm::vec3(2.9, 3.0, -5.9), glm::vec3(0, 1, 0)), // 19
-        Vertex(glm::vec3(2.9, 3.0, -15), glm::vec3(0, 1, 0)), // 20
-        Vertex(glm::vec3(1.7, 3.0, -15), glm::vec3(0, 1, 0)), // 21
-        // Top II
-        Vertex(glm::vec3(1.7, 0.0, -5.2), glm::vec3(0, -1, 0)), // 22
-        Vertex(glm::vec3(2.9, 0.0, -5.2), glm::vec3(0, -1, 0)), // 23
-        Vertex(glm::vec3(2.9, 0.0, -15), glm::vec3(0, -1, 0)), // 24
-        Vertex(glm::vec3(1.7, 0.0, -15), glm::vec3(0, -1, 0)), // 25
-        // Slant
-        Vertex(glm::vec3(1.7, 1.9, -5.2), glm::vec3(0.0, 0.7, 1.1)), // 26
-        Vertex(glm::vec3(2.9, 1.9, -5.2), glm::vec3(0.0, 0.7, 1.1)), // 27
-        Vertex(glm::vec3(2.9, 3.0, -5.9), glm::vec3(0.0, 0.7, 1.1)), // 28
-        Vertex(glm::vec3(1.7, 3.0, -5.9), glm::vec3(0.0, 0.7, 1.1)), // 29
-    };
+    // Keys split by whether they are at rest, for the shadow map (reused)
+    std::vector<Mesh*> m_restingKeys;
+    std::vector<Mesh*> m_movingKeys;
     
-    // Indices for a black key
-    unsigned int blackKeyIndices[48] =
-    {
-        // Front I
-        0, 1, 2, 0, 2, 3,
-        // Front II
-        4, 7, 6, 4, 6, 5,
-        // Left I
-        8, 9, 10, 8, 10, 11,
-        8, 11, 12,
-        // Left II
-        13, 17, 16, 13, 16, 15,
-        13, 15, 14,
-        // Top I
-        18, 19, 20, 18, 20, 21,
-        // Top II
-        22, 25, 24, 22, 24, 23,
-        // Slant
-        26, 27, 28, 26, 28, 29,
-    };
+    // Culling results for the last frame drawn
+    unsigned int m_numKeysDrawn;
+    unsigned int m_numKeysCulled;
+    unsigned int m_numGroupsCulled;
+    unsigned int m_numKeyboardsCulled;
+    
+    // Index of the key that is currently down
+    int m_curKeyDown;
+    
+    // Hold which sound to use
+    unsigned int m_soundToUse; // 0 for organ, 1 for piano.
+    EnvelopeShape m_envelopes[OneKeyboardKey::NUM_SOUNDS]; // Shapes the notes of each sound
+    
+    // The mesh of each kind of key, built by KeyGeometry when
+    // compiling (copied so that its triangles can be reordered)
+    std::vector<Vertex> m_variantVertices[KeyboardLayout::NUM_KEY_VARIANTS];
+    std::vector<unsigned int> m_variantIndices[KeyboardLayout::NUM_KEY_VARIANTS];
 }; // KeyboardKeys
 
 #endif /* KeyboardKeys_hpp */
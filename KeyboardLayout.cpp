@@ -0,0 +1,164 @@
+/**
+ KeyboardLayout.cpp
+ Virtual Keyboard
+ Implementation of KeyboardLayout.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 5/1/2018
+ */
+
+#include "KeyboardLayout.hpp"
+#include <sstream>
+
+//--------------------------------------------------------------------------
+/**
+ Lays out the keys from one note to another. A keyboard starts
+ and ends with white keys, so a range starting or ending on a
+ black key is widened to the white key beside it.
+ 
+ @param lowestNote The MIDI note of the lowest key.
+ @param highestNote The MIDI note of the highest key.
+ @param whiteSpacing How far apart the white keys are.
+ */
+KeyboardLayout::KeyboardLayout(unsigned int lowestNote, unsigned int highestNote, float whiteSpacing)
+{
+    if(highestNote >= MAX_KEYS)
+        highestNote = MAX_KEYS - 1;
+    if(lowestNote > highestNote)
+        lowestNote = highestNote;
+    // The lowest and highest MIDI notes (C and G) are white, so this stays in range
+    if(isBlackNote(lowestNote))
+        lowestNote--;
+    if(isBlackNote(highestNote))
+        highestNote++;
+    
+    m_whiteSpacing = whiteSpacing;
+    m_slotsPerUnit = HIT_SLOTS_PER_WHITE_KEY / whiteSpacing;
+    m_numWhiteKeys = 0;
+    
+    const char* NOTE_NAMES[12] = { "c", "db", "d", "eb", "e", "f", "gb", "g", "ab", "a", "bb", "b" };
+    for(unsigned int note = lowestNote; note <= highestNote; note++)
+    {
+        Key key;
+        key.note = note;
+        key.isBlack = isBlackNote(note);
+        
+        // A white key is notched where a black key sits beside it
+        bool hasLeftNotch = note > lowestNote && isBlackNote(note - 1);
+        bool hasRightNotch = note < highestNote && isBlackNote(note + 1);
+        if(key.isBlack)
+            key.variant = BLACK_VARIANT;
+        else if(hasLeftNotch)
+            key.variant = hasRightNotch ? WHITE_LR_VARIANT : WHITE_L_VARIANT;
+        else
+            key.variant = hasRightNotch ? WHITE_R_VARIANT : WHITE_VARIANT;
+        
+        // A black key is placed with the white key below it (the last one counted)
+        key.x = (key.isBlack ? m_numWhiteKeys - 1 : m_numWhiteKeys) * whiteSpacing;
+        key.startsGroup = note == lowestNote || note % 12 == 0;
+        key.sampleName = std::to_string((int)note / 12 - 1) + NOTE_NAMES[note % 12];
+        if(!key.isBlack)
+            m_numWhiteKeys++;
+        m_keys.push_back(key);
+    } // for
+    
+    // Each white key is split into quarters. A black key covers the
+    // last quarter of the white key below it and the first quarter
+    // of the one above it, and each white key covers the rest of its own
+    m_hitKeys.assign(m_numWhiteKeys * HIT_SLOTS_PER_WHITE_KEY, -1);
+    unsigned int whiteKeysFilled = 0;
+    for(unsigned int i = 0; i < m_keys.size(); i++)
+    {
+        unsigned int slot = whiteKeysFilled * HIT_SLOTS_PER_WHITE_KEY;
+        if(m_keys[i].isBlack)
+        {
+            m_hitKeys[slot - 1] = i;
+            m_hitKeys[slot] = i;
+        } // if
+        else
+        {
+            for(unsigned int j = slot; j < slot + HIT_SLOTS_PER_WHITE_KEY; j++)
+            {
+                if(m_hitKeys[j] == -1)
+                    m_hitKeys[j] = i;
+            } // for
+            whiteKeysFilled++;
+        } // else
+    } // for
+} // KeyboardLayout::KeyboardLayout(unsigned int, unsigned int, float)
+
+//--------------------------------------------------------------------------
+/**
+ Gets the key under an x-position (the keyboard starts at 0 and
+ goes right). This is one lookup in the table made with the layout.
+ 
+ @param x The x-position, usually the camera's.
+ @return The index of the key, or -1 if the position is past
+ either end of the keyboard.
+ */
+int KeyboardLayout::getKeyAt(float x) const
+{
+    // Checked as a float first (a negative or huge slot cannot be cast)
+    float slot = x * m_slotsPerUnit;
+    if(!(slot >= 0.0f && slot < m_hitKeys.size()))
+        return -1;
+    return m_hitKeys[(unsigned int)slot];
+} // KeyboardLayout::getKeyAt(float)
+
+//--------------------------------------------------------------------------
+/**
+ Reads a range of keys, either as a common size of keyboard
+ ("25", "49", "61", "76" or "88" keys) or as the MIDI notes of
+ the lowest and highest keys ("36-96").
+ 
+ @param range The text to read.
+ @param lowestNote Set to the MIDI note of the lowest key.
+ @param highestNote Set to the MIDI note of the highest key.
+ @return False if the text is not a range (the notes are left as they were).
+ */
+bool KeyboardLayout::parseRange(const std::string& range, unsigned int& lowestNote, unsigned int& highestNote)
+{
+    // Number of keys, lowest note, highest note
+    const unsigned int NUM_SIZES = 5;
+    const unsigned int SIZES[NUM_SIZES][3] = { { 25, 48, 72 }, { 49, 36, 84 }, { 61, 36, 96 }, { 76, 28, 103 }, { 88, 21, 108 } };
+    
+    std::istringstream fields(range);
+    unsigned int low;
+    unsigned int high;
+    char dash;
+    if(!(fields >> low))
+        return false;
+    if(fields >> dash)
+    {
+        if(dash != '-' || !(fields >> high) || low > high || high >= MAX_KEYS)
+            return false;
+        lowestNote = low;
+        highestNote = high;
+        return true;
+    } // if
+    
+    for(unsigned int i = 0; i < NUM_SIZES; i++)
+    {
+        if(SIZES[i][0] == low)
+        {
+            lowestNote = SIZES[i][1];
+            highestNote = SIZES[i][2];
+            return true;
+        } // if
+    } // for
+    return false;
+} // KeyboardLayout::parseRange(const std::string&, unsigned int&, unsigned int&)
+
+//--------------------------------------------------------------------------
+/**
+ Checks if a MIDI note is played on a black key.
+ 
+ @param note The MIDI note.
+ @return True for the sharps and flats.
+ */
+bool KeyboardLayout::isBlackNote(unsigned int note)
+{
+    // C# D# F# G# A#
+    const bool IS_BLACK[12] = { false, true, false, true, false, false, true, false, true, false, true, false };
+    return IS_BLACK[note % 12];
+} // KeyboardLayout::isBlackNote(unsigned int)
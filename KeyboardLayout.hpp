@@ -0,0 +1,93 @@
+/**
+ KeyboardLayout.hpp
+ Virtual Keyboard
+ Class which lays out the keys of a keyboard covering any
+ contiguous range of MIDI notes. Everything that depends on
+ the range is worked out once, when the layout is made: where
+ each key goes, which kind of key it is (which notches it has),
+ the name of its sound files, where the groups used for culling
+ start, and a table of which key is under each quarter of a
+ white key (so finding the key under the camera is a lookup).
+ Keys are numbered from the lowest note up.
+ 
+ @author Graeme Zinck
+ @version 1.0 5/1/2018
+ */
+
+#ifndef KeyboardLayout_hpp
+#define KeyboardLayout_hpp
+
+#include "KeyGeometry.hpp"
+#include <string>
+#include <vector>
+
+class KeyboardLayout
+{
+public:
+    // The kinds of keys (each has its own set of indices)
+    enum {
+        WHITE_VARIANT,
+        WHITE_L_VARIANT, // Notch in the left side
+        WHITE_R_VARIANT, // Notch in the right side
+        WHITE_LR_VARIANT,
+        BLACK_VARIANT,
+        
+        NUM_KEY_VARIANTS
+    }; // enum
+    
+    // One key of the layout
+    struct Key
+    {
+        unsigned int note; // MIDI note number
+        bool isBlack;
+        unsigned int variant;
+        float x; // Where the key's mesh starts (a black key starts with the white key to its left)
+        bool startsGroup; // True for the first key and every C
+        std::string sampleName; // Name of its sound files, e.g. "4db"
+    }; // Key
+    
+    KeyboardLayout(unsigned int lowestNote = LOWEST_PIANO_NOTE, unsigned int highestNote = HIGHEST_PIANO_NOTE, float whiteSpacing = STANDARD_KEYBOARD_SHAPE.whiteSpacing);
+    
+    static bool parseRange(const std::string& range, unsigned int& lowestNote, unsigned int& highestNote);
+    static bool isBlackNote(unsigned int note);
+    int getKeyAt(float x) const;
+    
+    /**
+     Gets a key, numbered from the lowest note up.
+     */
+    inline const Key& getKey(unsigned int key) const { return m_keys[key]; }
+    /**
+     Gets how many keys there are (white and black).
+     */
+    inline unsigned int getNumKeys() const { return (unsigned int)m_keys.size(); }
+    /**
+     Gets how many white keys there are.
+     */
+    inline unsigned int getNumWhiteKeys() const { return m_numWhiteKeys; }
+    /**
+     Gets how far it is from the left of the first white key to
+     the right of the last one.
+     */
+    inline float getLength() const { return m_numWhiteKeys * m_whiteSpacing; }
+    /**
+     Gets the MIDI note of the lowest key.
+     */
+    inline unsigned int getLowestNote() const { return m_keys.front().note; }
+    /**
+     Gets the MIDI note of the highest key.
+     */
+    inline unsigned int getHighestNote() const { return m_keys.back().note; }
+    
+    const static unsigned int LOWEST_PIANO_NOTE = 21; // A0
+    const static unsigned int HIGHEST_PIANO_NOTE = 108; // C8
+    const static unsigned int MAX_KEYS = 128; // Every MIDI note
+    const static unsigned int HIT_SLOTS_PER_WHITE_KEY = 4; // A black key covers a quarter of each white key beside it
+private:
+    std::vector<Key> m_keys;
+    std::vector<int> m_hitKeys; // The key under each slot, from left to right
+    unsigned int m_numWhiteKeys;
+    float m_whiteSpacing;
+    float m_slotsPerUnit; // Hit slots per unit of x
+}; // KeyboardLayout
+
+#endif /* KeyboardLayout_hpp */
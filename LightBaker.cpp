@@ -0,0 +1,80 @@
+/**
+ LightBaker.cpp
+ Virtual Keyboard
+ Implementation of LightBaker.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/21/2018
+ */
+
+#include "LightBaker.hpp"
+
+//--------------------------------------------------------------------------
+/**
+ Creates a baker for a set of lights which never move.
+ 
+ @param lights An array of lights (the same lights the
+ shaders are lit with, in the same order).
+ @param numLights The number of lights in the array.
+ */
+LightBaker::LightBaker(Light* lights, unsigned int numLights)
+{
+    m_lights = lights;
+    m_numLights = numLights;
+} // LightBaker::LightBaker(Light*, unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Works out the light a vertex gets that does not depend on the
+ camera, in the same way the fragment shader does. The first
+ light's diffuse light is not added in; only how much of it
+ reaches the vertex is kept, so that the shader can still
+ darken it with a shadow map.
+ 
+ @param position Position of the vertex in world coordinates.
+ @param normal Normal of the vertex in world coordinates (normalized).
+ @param ambient Amount the material reflects ambient R, G, and B light.
+ @param diffuse Amount the material reflects diffuse R, G, and B light.
+ @return The ambient and diffuse light of the vertex in xyz, and
+ how much of the first light's diffuse light reaches it in w.
+ */
+glm::vec4 LightBaker::bakeVertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec3& ambient, const glm::vec3& diffuse) const
+{
+    glm::vec3 light(0.0f, 0.0f, 0.0f);
+    float firstLightDiffuse = 0.0f;
+    for(unsigned int i = 0; i < m_numLights; i++)
+    {
+        // Ambient light is never attenuated
+        light += m_lights[i].getAmbientCoefficient() * m_lights[i].getIntensities() * ambient;
+        
+        float diffuseCoefficient = getDiffuseCoefficient(m_lights[i], position, normal);
+        if(i == 0)
+            firstLightDiffuse = diffuseCoefficient;
+        else
+            light += diffuseCoefficient * m_lights[i].getIntensities() * diffuse;
+    } // for
+    return glm::vec4(light, firstLightDiffuse);
+} // LightBaker::bakeVertex(const glm::vec3&, const glm::vec3&, const glm::vec3&, const glm::vec3&)
+
+//--------------------------------------------------------------------------
+/**
+ Gets how much of a light's diffuse light reaches a vertex
+ (cos theta, clamped to [0, 1], times the attenuation).
+ 
+ @param light The light.
+ @param position Position of the vertex in world coordinates.
+ @param normal Normal of the vertex in world coordinates.
+ @return The diffuse coefficient.
+ */
+float LightBaker::getDiffuseCoefficient(Light& light, const glm::vec3& position, const glm::vec3& normal) const
+{
+    glm::vec3 surfaceToLight = light.getPos() - position;
+    float distanceToLight = glm::length(surfaceToLight);
+    if(distanceToLight <= 0.0f)
+        return 0.0f;
+    
+    float cosTheta = glm::clamp(glm::dot(normal, surfaceToLight / distanceToLight), 0.0f, 1.0f);
+    glm::vec3 factor = light.getAttenuationFactor();
+    float attenuation = 1.0f / (factor.x * distanceToLight * distanceToLight + factor.y * distanceToLight + factor.z);
+    return cosTheta * attenuation;
+} // LightBaker::getDiffuseCoefficient(Light&, const glm::vec3&, const glm::vec3&)
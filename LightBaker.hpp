@@ -0,0 +1,32 @@
+/**
+ LightBaker.hpp
+ Virtual Keyboard
+ Class which works out the lighting that does not depend on
+ where the camera is (ambient and diffuse light, with
+ attenuation) for vertices that do not move, so that the
+ fragment shader only has to add the specular highlights.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/21/2018
+ */
+
+#ifndef LightBaker_hpp
+#define LightBaker_hpp
+
+#include <glm/glm.hpp>
+#include "Light.hpp"
+
+class LightBaker
+{
+public:
+    LightBaker(Light* lights, unsigned int numLights);
+    
+    glm::vec4 bakeVertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec3& ambient, const glm::vec3& diffuse) const;
+private:
+    float getDiffuseCoefficient(Light& light, const glm::vec3& position, const glm::vec3& normal) const;
+    
+    Light* m_lights; // The first light's diffuse light is kept apart (it may be shadowed)
+    unsigned int m_numLights;
+}; // LightBaker
+
+#endif /* LightBaker_hpp */
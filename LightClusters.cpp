@@ -0,0 +1,286 @@
+/**
+ LightClusters.cpp
+ Virtual Keyboard
+ Implementation of LightClusters.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/19/2018
+ */
+
+#include "LightClusters.hpp"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+//--------------------------------------------------------------------------
+/**
+ Creates the buffers and the texture buffers that view them.
+ There are no lights until setLights() is called.
+ */
+LightClusters::LightClusters()
+{
+    m_ambientLight = glm::vec3(0.0f, 0.0f, 0.0f);
+    m_tileScale = glm::vec2(0.0f, 0.0f);
+    m_depthParameters = glm::vec3(1.0f, 1.0f, 0.0f);
+    
+    glGenBuffers(NUM_BUFFERS, m_buffers);
+    glGenTextures(NUM_BUFFERS, m_textures);
+    
+    const GLenum formats[NUM_BUFFERS] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+    const float empty[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for(unsigned int i = 0; i < NUM_BUFFERS; i++)
+    {
+        // Every buffer holds something, even with no lights
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(empty), empty, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_buffers[i]);
+    } // for
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+} // LightClusters::LightClusters()
+
+//--------------------------------------------------------------------------
+/**
+ Destroys the buffers and their textures.
+ */
+LightClusters::~LightClusters()
+{
+    glDeleteTextures(NUM_BUFFERS, m_textures);
+    glDeleteBuffers(NUM_BUFFERS, m_buffers);
+} // LightClusters::~LightClusters()
+
+//--------------------------------------------------------------------------
+/**
+ Sets the lights (which are copied), works out how far each
+ one reaches, and sends them to the GPU.
+ 
+ @param lights An array of lights.
+ @param numLights The number of lights in the array (at most
+ 65536, since clusters refer to lights with 16-bit indices).
+ */
+void LightClusters::setLights(Light* lights, unsigned int numLights)
+{
+    numLights = std::min(numLights, 65536u);
+    m_lights.assign(lights, lights + numLights);
+    m_radii.resize(numLights);
+    m_ambientLight = glm::vec3(0.0f, 0.0f, 0.0f);
+    
+    std::vector<glm::vec4> data(numLights * TEXELS_PER_LIGHT);
+    for(unsigned int i = 0; i < numLights; i++)
+    {
+        Light& light = m_lights[i];
+        glm::vec3 intensities = light.getIntensities();
+        glm::vec3 attenuation = light.getAttenuationFactor();
+        m_ambientLight = m_ambientLight + intensities * light.getAmbientCoefficient();
+        
+        // Solve a*d^2 + b*d + c = brightest / MIN_BRIGHTNESS for the
+        // distance d where the light becomes too dim to matter
+        float brightest = std::max(intensities.x, std::max(intensities.y, intensities.z));
+        float k = brightest / MIN_BRIGHTNESS - attenuation.z;
+        if(k <= 0.0f)
+            m_radii[i] = 0.0f;
+        else if(attenuation.x > 0.0f)
+            m_radii[i] = (-attenuation.y + sqrtf(attenuation.y * attenuation.y + 4.0f * attenuation.x * k)) / (2.0f * attenuation.x);
+        else if(attenuation.y > 0.0f)
+            m_radii[i] = k / attenuation.y;
+        else
+            m_radii[i] = -1.0f; // Never fades
+        
+        data[i * TEXELS_PER_LIGHT] = glm::vec4(light.getPos(), 0.0f);
+        data[i * TEXELS_PER_LIGHT + 1] = glm::vec4(intensities, 0.0f);
+        data[i * TEXELS_PER_LIGHT + 2] = glm::vec4(attenuation, 0.0f);
+    } // for
+    
+    if(!data.empty())
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[LIGHT_DATA_B]);
+        glBufferData(GL_TEXTURE_BUFFER, data.size() * sizeof(glm::vec4), &data[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    } // if
+} // LightClusters::setLights(Light*, unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Sorts the lights into the clusters of the camera's view and
+ sends the grid and the lists of lights to the GPU. This is
+ a counting sort: the first pass counts how many lights each
+ cluster gets, and the second pass fills in the lists.
+ 
+ @param camera The camera that the scene is about to be drawn with.
+ */
+void LightClusters::update(Camera* camera)
+{
+    // The clusters split the viewport into tiles
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    m_tileScale = glm::vec2((float)CLUSTERS_X / std::max(viewport[2], 1), (float)CLUSTERS_Y / std::max(viewport[3], 1));
+    
+    // Depth slices get thicker further away (logarithmic), like the
+    // precision of the depth buffer
+    float zNear = camera->getZNear();
+    float zFar = camera->getZFar();
+    m_depthParameters = glm::vec3(zNear, zFar, CLUSTERS_Z / logf(zFar / zNear));
+    
+    glm::mat4 view = camera->getView();
+    const glm::mat4& projection = camera->getProjection();
+    
+    // Count the lights in each cluster
+    m_grid.assign(NUM_CLUSTERS * 2, 0);
+    m_ranges.resize(m_lights.size());
+    m_lightsInRange.clear();
+    for(unsigned int i = 0; i < m_lights.size(); i++)
+    {
+        ClusterRange& range = m_ranges[i];
+        if(!findClusterRange(i, view, projection, &range))
+            continue;
+        m_lightsInRange.push_back(i);
+        for(int z = range.minZ; z <= range.maxZ; z++)
+            for(int y = range.minY; y <= range.maxY; y++)
+                for(int x = range.minX; x <= range.maxX; x++)
+                    m_grid[((z * CLUSTERS_Y + y) * CLUSTERS_X + x) * 2 + 1]++;
+    } // for
+    
+    // Each cluster's list starts where the one before it ends
+    uint32_t total = 0;
+    for(int i = 0; i < NUM_CLUSTERS; i++)
+    {
+        m_grid[i * 2] = total;
+        total += m_grid[i * 2 + 1];
+        m_grid[i * 2 + 1] = 0; // Counted again while filling in
+    } // for
+    
+    // Fill in the lists
+    m_clusterLights.resize(std::max(total, 1u));
+    for(unsigned int i = 0; i < m_lightsInRange.size(); i++)
+    {
+        int light = m_lightsInRange[i];
+        ClusterRange& range = m_ranges[light];
+        for(int z = range.minZ; z <= range.maxZ; z++)
+        {
+            for(int y = range.minY; y <= range.maxY; y++)
+            {
+                for(int x = range.minX; x <= range.maxX; x++)
+                {
+                    uint32_t* cluster = &m_grid[((z * CLUSTERS_Y + y) * CLUSTERS_X + x) * 2];
+                    m_clusterLights[cluster[0] + cluster[1]] = (uint16_t)light;
+                    cluster[1]++;
+                } // for
+            } // for
+        } // for
+    } // for
+    
+    // Replace the old data (orphaning it, so the GPU can keep using it)
+    glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[CLUSTER_GRID_B]);
+    glBufferData(GL_TEXTURE_BUFFER, m_grid.size() * sizeof(uint32_t), &m_grid[0], GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[CLUSTER_LIGHTS_B]);
+    glBufferData(GL_TEXTURE_BUFFER, m_clusterLights.size() * sizeof(uint16_t), &m_clusterLights[0], GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+} // LightClusters::update(Camera*)
+
+//--------------------------------------------------------------------------
+/**
+ Binds the texture buffers to their texture units, where the
+ shaders read them from.
+ */
+void LightClusters::bindTextures()
+{
+    const int units[NUM_BUFFERS] = { LIGHT_DATA_UNIT, CLUSTER_GRID_UNIT, CLUSTER_LIGHTS_UNIT };
+    for(unsigned int i = 0; i < NUM_BUFFERS; i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + units[i]);
+        glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+    } // for
+    glActiveTexture(GL_TEXTURE0);
+} // LightClusters::bindTextures()
+
+//--------------------------------------------------------------------------
+/**
+ Gets the defines that give the shaders the size of the grid.
+ 
+ @return The lines to add to the top of the shaders.
+ */
+std::string LightClusters::getShaderDefines()
+{
+    return "#define CLUSTERS_X " + std::to_string(CLUSTERS_X) + "\n"
+           "#define CLUSTERS_Y " + std::to_string(CLUSTERS_Y) + "\n"
+           "#define CLUSTERS_Z " + std::to_string(CLUSTERS_Z) + "\n";
+} // LightClusters::getShaderDefines()
+
+//--------------------------------------------------------------------------
+/**
+ Finds the clusters that a light's sphere of influence
+ touches. Across the screen, the box around the sphere is
+ projected (which covers a little more than the sphere).
+ 
+ @param light The index of the light.
+ @param view The camera's view matrix.
+ @param projection The camera's projection matrix.
+ @param range Set to the clusters the light touches.
+ @return False if the light touches no clusters at all.
+ */
+bool LightClusters::findClusterRange(unsigned int light, const glm::mat4& view, const glm::mat4& projection, ClusterRange* range)
+{
+    range->minX = 0;
+    range->maxX = CLUSTERS_X - 1;
+    range->minY = 0;
+    range->maxY = CLUSTERS_Y - 1;
+    range->minZ = 0;
+    range->maxZ = CLUSTERS_Z - 1;
+    
+    float radius = m_radii[light];
+    if(radius < 0.0f)
+        return true; // Reaches every cluster
+    
+    // The camera looks down the negative z-axis
+    glm::vec4 center = view * glm::vec4(m_lights[light].getPos(), 1.0f);
+    float nearDepth = -center.z - radius;
+    float farDepth = -center.z + radius;
+    float zNear = m_depthParameters.x;
+    float zFar = m_depthParameters.y;
+    if(farDepth < zNear || nearDepth > zFar)
+        return false;
+    range->minZ = getSlice(std::max(nearDepth, zNear));
+    range->maxZ = getSlice(std::min(farDepth, zFar));
+    
+    // A sphere around the camera can cover any part of the screen
+    if(nearDepth <= zNear)
+        return true;
+    
+    glm::vec2 minCorner(FLT_MAX);
+    glm::vec2 maxCorner(-FLT_MAX);
+    for(int corner = 0; corner < 8; corner++)
+    {
+        glm::vec4 point(center.x + ((corner & 1) ? radius : -radius),
+                        center.y + ((corner & 2) ? radius : -radius),
+                        center.z + ((corner & 4) ? radius : -radius), 1.0f);
+        glm::vec4 clip = projection * point;
+        float x = clip.x / clip.w;
+        float y = clip.y / clip.w;
+        minCorner = glm::vec2(std::min(minCorner.x, x), std::min(minCorner.y, y));
+        maxCorner = glm::vec2(std::max(maxCorner.x, x), std::max(maxCorner.y, y));
+    } // for
+    if(maxCorner.x < -1.0f || minCorner.x > 1.0f || maxCorner.y < -1.0f || minCorner.y > 1.0f)
+        return false;
+    
+    // From -1 to 1 across the screen, to clusters
+    range->minX = std::max(0, (int)((minCorner.x * 0.5f + 0.5f) * CLUSTERS_X));
+    range->maxX = std::min(CLUSTERS_X - 1, (int)((maxCorner.x * 0.5f + 0.5f) * CLUSTERS_X));
+    range->minY = std::max(0, (int)((minCorner.y * 0.5f + 0.5f) * CLUSTERS_Y));
+    range->maxY = std::min(CLUSTERS_Y - 1, (int)((maxCorner.y * 0.5f + 0.5f) * CLUSTERS_Y));
+    return true;
+} // LightClusters::findClusterRange(unsigned int, const glm::mat4&, const glm::mat4&, ClusterRange*)
+
+//--------------------------------------------------------------------------
+/**
+ Gets the depth slice that a distance from the camera is in
+ (the same way the fragment shader does).
+ 
+ @param depth Distance in front of the camera.
+ @return The slice, from 0 to CLUSTERS_Z - 1.
+ */
+int LightClusters::getSlice(float depth)
+{
+    int slice = (int)(logf(depth / m_depthParameters.x) * m_depthParameters.z);
+    return std::min(std::max(slice, 0), CLUSTERS_Z - 1);
+} // LightClusters::getSlice(float)
@@ -0,0 +1,117 @@
+/**
+ LightClusters.hpp
+ Virtual Keyboard
+ Class which holds a list of many point lights and, every frame,
+ sorts them into a 3D grid of clusters over the camera's view
+ (tiles across the screen, slices along the depth). Each fragment
+ only shades with the lights in its own cluster, so adding lights
+ elsewhere in the scene does not make it any slower. The lights,
+ the grid, and the lists of lights in each cluster are sent to
+ the shaders in texture buffers.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/19/2018
+ */
+
+#ifndef LightClusters_hpp
+#define LightClusters_hpp
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "Light.hpp"
+#include "Camera.hpp"
+
+class LightClusters
+{
+public:
+    LightClusters();
+    virtual ~LightClusters();
+    
+    void setLights(Light* lights, unsigned int numLights);
+    void update(Camera* camera);
+    void bindTextures();
+    static std::string getShaderDefines();
+    
+    /**
+     Gets the ambient light of all the lights added together
+     (ambient light is not attenuated, so it reaches everywhere).
+     */
+    inline const glm::vec3& getAmbientLight() { return m_ambientLight; }
+    /**
+     Gets the number of clusters per pixel across and down the screen.
+     */
+    inline const glm::vec2& getTileScale() { return m_tileScale; }
+    /**
+     Gets the near plane, far plane, and depth slice scale (the
+     values the shader needs to find a fragment's depth slice).
+     */
+    inline const glm::vec3& getDepthParameters() { return m_depthParameters; }
+    /**
+     Gets how many light references were put in clusters in the
+     last update.
+     */
+    inline unsigned int getNumLightReferences() { return (unsigned int)m_clusterLights.size(); }
+    
+    // Texture units the buffers are bound to
+    static const int LIGHT_DATA_UNIT = 1;
+    static const int CLUSTER_GRID_UNIT = 2;
+    static const int CLUSTER_LIGHTS_UNIT = 3;
+private:
+    // The clusters a light touches (inclusive)
+    struct ClusterRange
+    {
+        int minX, maxX;
+        int minY, maxY;
+        int minZ, maxZ;
+    }; // ClusterRange
+    
+    bool findClusterRange(unsigned int light, const glm::mat4& view, const glm::mat4& projection, ClusterRange* range);
+    int getSlice(float depth);
+    
+    // Size of the grid
+    static const int CLUSTERS_X = 16;
+    static const int CLUSTERS_Y = 9;
+    static const int CLUSTERS_Z = 24;
+    static const int NUM_CLUSTERS = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+    
+    // Texels of light data per light (position, intensities, attenuation)
+    static const int TEXELS_PER_LIGHT = 3;
+    
+    // Lights are ignored where they are dimmer than this
+    const float MIN_BRIGHTNESS = 1.0f / 256.0f;
+    
+    // An enumerated type for the buffers (and their textures)
+    enum {
+        LIGHT_DATA_B,
+        CLUSTER_GRID_B,
+        CLUSTER_LIGHTS_B,
+        
+        NUM_BUFFERS
+    }; // enum
+    
+    GLuint m_buffers[NUM_BUFFERS];
+    GLuint m_textures[NUM_BUFFERS];
+    
+    // The lights and how far each one reaches (negative if forever)
+    std::vector<Light> m_lights;
+    std::vector<float> m_radii;
+    glm::vec3 m_ambientLight;
+    
+    // Built every update: offset and count of each cluster's
+    // lights, and the list of lights in all the clusters
+    std::vector<uint32_t> m_grid;
+    std::vector<uint16_t> m_clusterLights;
+    std::vector<ClusterRange> m_ranges;
+    std::vector<int> m_lightsInRange; // Lights with a cluster range this update
+    
+    // Values for the shaders
+    glm::vec2 m_tileScale;
+    glm::vec3 m_depthParameters;
+}; // LightClusters
+
+#endif /* LightClusters_hpp */
@@ -22,14 +22,22 @@ Mesh::Mesh(Vertex* vertices, unsigned int numVertices, unsigned int* indices, un
     m_shader = shader;
     m_transform = transform;
     m_specularExponent = 1; // Default
+    m_materialKey = 0;
+    m_bakedShader = NULL;
     
     // Put everything into a model (this makes it easy to put into
     // vertex buffers later).
     Model model;
+    m_boundsMin = *vertices[0].getPos();
+    m_boundsMax = *vertices[0].getPos();
     for(unsigned int i = 0; i < numVertices; i++)
     {
         model.positions.push_back(*vertices[i].getPos());
-        model.normals.push_back(*vertices[i].getNormal());
+        model.normals.push_back(glm::normalize(*vertices[i].getNormal())); // So the shader doesn't have to
+        
+        // Grow the bounding box to fit the vertex
+        m_boundsMin = glm::min(m_boundsMin, *vertices[i].getPos());
+        m_boundsMax = glm::max(m_boundsMax, *vertices[i].getPos());
     } // for
     
     for(unsigned int i = 0; i < numIndices; i++)
@@ -42,7 +50,9 @@ Mesh::Mesh(Vertex* vertices, unsigned int numVertices, unsigned int* indices, un
 /**
  Uses a model to finish creating the mesh.
  Allocates space on the GPU for all of the elements, and
- binds the buffers.
+ binds the buffers. The positions and normals are packed
+ and interleaved, and the indices use the smallest type
+ that fits (see PackedVertices).
  
  @param model A model with positions, normals, and indices
  for the mesh.
@@ -50,34 +60,25 @@ Mesh::Mesh(Vertex* vertices, unsigned int numVertices, unsigned int* indices, un
 void Mesh::initMesh(const Model& model)
 {
     m_drawCount = model.indices.size();
+    m_positions = model.positions;
+    m_normals = model.normals;
     
+    RenderState* renderState = m_shader->getRenderState();
     glGenVertexArrays(1, &m_vertexArrayObject);
-    glBindVertexArray(m_vertexArrayObject);
+    renderState->bindVertexArray(m_vertexArrayObject);
     
     m_vertexArrayBuffers = new GLuint[NUM_BUFFERS]; // Needed to avoid having EXC_BAD_ACCESS error
     glGenBuffers(NUM_BUFFERS, m_vertexArrayBuffers);
     
-    // BUFFER 1: for the vector positions
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexArrayBuffers[POSITION_VB]);
-    glBufferData(GL_ARRAY_BUFFER, model.positions.size() * sizeof(model.positions[0]), &model.positions[0], GL_STATIC_DRAW); // STATIC_DRAW means the data will not be changed
+    // BUFFERS 1 and 2: for the interleaved vertices and the indices
+    PackedVertices packed(model.positions, model.normals, model.indices);
+    packed.upload(m_vertexArrayBuffers[VERTEX_VB], m_vertexArrayBuffers[INDEX_VB]);
+    m_indexType = packed.getIndexType();
+    m_numBytes = packed.getNumBytes();
+    m_numUnpackedBytes = packed.getNumUnpackedBytes();
+    m_vertexSize = packed.getVertexSize();
     
-    GLint posAttrib = glGetAttribLocation(m_shader->getShaderProgram(), "position");
-    glEnableVertexAttribArray(posAttrib);
-    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    
-    // BUFFER 2: for the normals of the vertices
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexArrayBuffers[NORMAL_VB]);
-    glBufferData(GL_ARRAY_BUFFER, model.normals.size() * sizeof(model.normals[0]), &model.normals[0], GL_STATIC_DRAW); // STATIC_DRAW means the data will not be changed; it's the draw hint
-    
-    GLint normAttrib = glGetAttribLocation(m_shader->getShaderProgram(), "normal");
-    glEnableVertexAttribArray(normAttrib);
-    glVertexAttribPointer(normAttrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    
-    // BUFFER 3: for the indices of the vertices
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_vertexArrayBuffers[INDEX_VB]); // Array, but references the data of other arrays
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, model.indices.size() * sizeof(model.indices[0]), &model.indices[0], GL_STATIC_DRAW);
-    
-    glBindVertexArray(0);
+    renderState->bindVertexArray(0);
 } // Mesh::initMesh(const Model&)
 
 //--------------------------------------------------------------------------
@@ -92,20 +93,140 @@ Mesh::~Mesh()
 
 //--------------------------------------------------------------------------
 /**
- Draws the mesh.
+ Draws the mesh. All the state goes through the shader's
+ state tracker, so anything already set by the previous
+ draw (such as the same vertex array or material) is not
+ sent to OpenGL again. The vertex array is left bound.
  
  @param camera The camera to use when drawing the key.
+ @param offset How far from its transform to draw the mesh, so
+ that one mesh can be drawn in several places (its baked lighting
+ is only right where it was baked, so copies should not be baked).
 */
-void Mesh::draw(Camera* camera)
+void Mesh::draw(Camera* camera, const glm::vec3& offset)
 {
-    glBindVertexArray(m_vertexArrayObject);
+    Shader* shader = getShader();
+    shader->use();
+    shader->getRenderState()->bindVertexArray(m_vertexArrayObject);
+    
+    shader->setMaterial(m_ambient, m_diffuse, m_specular, m_specularExponent);
+    if(offset == glm::vec3(0.0f))
+        shader->update(m_transform, camera);
+    else
+    {
+        Transform transform = m_transform;
+        transform.setPos(m_transform.getPos() + offset);
+        shader->update(transform, camera);
+    } // else
+    glDrawElements(GL_TRIANGLES, m_drawCount, m_indexType, 0);
+    shader->getRenderState()->countDrawCall();
+} // Mesh::draw(Camera*, const glm::vec3&)
+
+//--------------------------------------------------------------------------
+/**
+ Draws only the depth of the mesh (such as into a shadow map)
+ with a different shader, which must use the same attribute
+ locations as the mesh's own shader.
+ 
+ @param depthShader The shader to draw the mesh with.
+ @param viewProjection Where to draw the mesh from.
+*/
+void Mesh::drawDepth(Shader* depthShader, const glm::mat4& viewProjection)
+{
+    depthShader->use();
+    depthShader->getRenderState()->bindVertexArray(m_vertexArrayObject);
+    depthShader->update(m_transform, viewProjection);
+    glDrawElements(GL_TRIANGLES, m_drawCount, m_indexType, 0);
+    depthShader->getRenderState()->countDrawCall();
+} // Mesh::drawDepth(Shader*, const glm::mat4&)
+
+//--------------------------------------------------------------------------
+/**
+ Works out the ambient and diffuse light of every vertex where
+ the mesh is now, and puts it in a vertex buffer. While the
+ mesh stays there, it is drawn with the baked shader, which
+ only adds the specular light; once it moves, it goes back to
+ its own shader until it returns. Set the material first.
+ 
+ @param baker The lights to bake.
+ @param bakedShader A version of the mesh's shader with the
+ ShaderLibrary::BAKED_LIGHTING_F feature.
+*/
+void Mesh::bakeLighting(const LightBaker& baker, Shader* bakedShader)
+{
+    m_bakedShader = bakedShader;
+    m_bakedModel = m_transform.getModel();
+    const glm::mat3& normalMatrix = m_transform.getNormalMatrix();
+    
+    std::vector<glm::vec4> bakedLight;
+    for(unsigned int i = 0; i < m_positions.size(); i++)
+    {
+        glm::vec3 position = glm::vec3(m_bakedModel * glm::vec4(m_positions[i], 1.0f));
+        glm::vec3 normal = glm::normalize(normalMatrix * m_normals[i]);
+        bakedLight.push_back(baker.bakeVertex(position, normal, m_ambient, m_diffuse));
+    } // for
     
-    m_shader->setMaterial(m_ambient, m_diffuse, m_specular, m_specularExponent);
-    m_shader->update(m_transform, camera);
-    glDrawElements(GL_TRIANGLES, m_drawCount, GL_UNSIGNED_INT, 0);
+    // BUFFER 3: for the baked lighting (only read by the baked shader)
+    RenderState* renderState = m_shader->getRenderState();
+    renderState->bindVertexArray(m_vertexArrayObject);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexArrayBuffers[BAKED_LIGHT_VB]);
+    glBufferData(GL_ARRAY_BUFFER, bakedLight.size() * sizeof(bakedLight[0]), &bakedLight[0], GL_STATIC_DRAW);
     
-    glBindVertexArray(0);
-} // Mesh::draw()
+    GLint bakedAttrib = Shader::BAKED_LIGHT_A;
+    glEnableVertexAttribArray(bakedAttrib);
+    glVertexAttribPointer(bakedAttrib, 4, GL_FLOAT, GL_FALSE, 0, 0);
+} // Mesh::bakeLighting(const LightBaker&, Shader*)
+
+//--------------------------------------------------------------------------
+/**
+ Checks if the baked lighting can be used (the lighting was
+ baked and the mesh has not moved since).
+ 
+ @return True if the mesh is lit by its baked lighting.
+*/
+bool Mesh::isLightingBaked()
+{
+    return m_bakedShader && m_transform.getModel() == m_bakedModel;
+} // Mesh::isLightingBaked()
+
+//--------------------------------------------------------------------------
+/**
+ Gets the shader the mesh is drawn with now: the baked shader
+ while the baked lighting is right, and its own shader otherwise.
+ 
+ @return The shader.
+*/
+Shader* Mesh::getShader()
+{
+    return isLightingBaked() ? m_bakedShader : m_shader;
+} // Mesh::getShader()
+
+//--------------------------------------------------------------------------
+/**
+ Gets the axis-aligned bounding box of the mesh in world
+ coordinates by transforming the model-space box with the
+ mesh's model matrix (Arvo's method, which avoids having
+ to transform all eight corners).
+ 
+ @param boundsMin Set to the minimum corner of the box.
+ @param boundsMax Set to the maximum corner of the box.
+*/
+void Mesh::getWorldBounds(glm::vec3& boundsMin, glm::vec3& boundsMax)
+{
+    const glm::mat4& model = m_transform.getModel();
+    boundsMin = glm::vec3(model[3]);
+    boundsMax = glm::vec3(model[3]);
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            float a = model[j][i] * m_boundsMin[j];
+            float b = model[j][i] * m_boundsMax[j];
+            boundsMin[i] += (a < b) ? a : b;
+            boundsMax[i] += (a < b) ? b : a;
+        } // for
+    } // for
+} // Mesh::getWorldBounds(glm::vec3&, glm::vec3&)
 
 //--------------------------------------------------------------------------
 /**
@@ -122,4 +243,12 @@ void Mesh::setMaterialProperties(glm::vec3 ambient, glm::vec3 diffuse, glm::vec3
     m_diffuse = diffuse;
     m_specular = specular;
     m_specularExponent = specularExponent;
+    
+    // Hash the material (FNV-1a) so that meshes with the same
+    // material can be sorted next to each other
+    const float values[10] = { ambient.x, ambient.y, ambient.z, diffuse.x, diffuse.y, diffuse.z, specular.x, specular.y, specular.z, specularExponent };
+    const unsigned char* bytes = (const unsigned char*)values;
+    m_materialKey = 2166136261u;
+    for(unsigned int i = 0; i < sizeof(values); i++)
+        m_materialKey = (m_materialKey ^ bytes[i]) * 16777619u;
 } // Mesh::setMaterialProperties(glm::vec3, glm::vec3, glm::vec3, float)
@@ -20,6 +20,8 @@
 #include "Shader.hpp"
 #include "Camera.hpp"
 #include "Transform.hpp"
+#include "LightBaker.hpp"
+#include "PackedVertices.hpp"
 
 //--------------------------------------------------------------------------
 /**
@@ -68,18 +70,43 @@ public:
     virtual ~Mesh();
     
     // Methods
-    void draw(Camera* camera);
+    void draw(Camera* camera, const glm::vec3& offset = glm::vec3(0.0f));
+    void drawDepth(Shader* depthShader, const glm::mat4& viewProjection);
     void setMaterialProperties(glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float specularExponent);
+    void bakeLighting(const LightBaker& baker, Shader* bakedShader);
+    bool isLightingBaked();
+    Shader* getShader();
+    void getWorldBounds(glm::vec3& boundsMin, glm::vec3& boundsMax);
     inline Transform* getTransform() { return &m_transform; };
+    inline GLuint getVertexArrayObject() { return m_vertexArrayObject; };
+    inline unsigned int getMaterialKey() { return m_materialKey; };
+    /**
+     Gets how many bytes of vertices and indices are on the GPU
+     (not counting the baked lighting).
+     */
+    inline unsigned int getNumBytes() { return m_numBytes; };
+    /**
+     Gets how many bytes the mesh would take with float positions
+     and normals in separate buffers and 32-bit indices.
+     */
+    inline unsigned int getNumUnpackedBytes() { return m_numUnpackedBytes; };
+    /**
+     Gets how many bytes are fetched for each vertex drawn.
+     */
+    inline unsigned int getVertexSize() { return m_vertexSize; };
+    /**
+     Gets how many indices are drawn.
+     */
+    inline unsigned int getDrawCount() { return m_drawCount; };
     
 protected:
     void initMesh(const Model& model);
     
     // An enumerated type for the vertex buffers which go in the m_vertexArrayBuffers array.
     enum {
-        POSITION_VB,
-        NORMAL_VB,
+        VERTEX_VB, // Positions and normals, interleaved
         INDEX_VB,
+        BAKED_LIGHT_VB,
         
         NUM_BUFFERS
     }; // enum
@@ -87,6 +114,12 @@ protected:
     GLuint m_vertexArrayObject; // Big object with all the vertices (or, a pointer to it)
     GLuint* m_vertexArrayBuffers; // Array of all the buffer locations
     unsigned int m_drawCount; // How much of the object we want to draw (how big is m_vertexArrayObject that we want to use?)
+    GLenum m_indexType; // GL_UNSIGNED_BYTE, _SHORT or _INT, whichever fits
+    
+    // Sizes of the packed buffers (reported at startup)
+    unsigned int m_numBytes;
+    unsigned int m_numUnpackedBytes;
+    unsigned int m_vertexSize;
     
     // The shader pointer is stored in the mesh because it is
     // permanently associated with the shader (due to how the
@@ -94,11 +127,25 @@ protected:
     Shader* m_shader; // Stores the shader so that we can query which attributes to use
     Transform m_transform; // Object for the transformations of the mesh
     
+    // Lighting worked out on the CPU, which is only right while the
+    // mesh is where it was baked (m_bakedShader is NULL if not baked)
+    Shader* m_bakedShader;
+    glm::mat4 m_bakedModel;
+    
+    // The vertices in model coordinates, kept for baking the lighting
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::vec3> m_normals;
+    
+    // Axis-aligned bounding box of the vertices in model coordinates
+    glm::vec3 m_boundsMin;
+    glm::vec3 m_boundsMax;
+    
     // Store properties of the material:
     float m_specularExponent;
     glm::vec3 m_ambient;
     glm::vec3 m_diffuse;
     glm::vec3 m_specular;
+    unsigned int m_materialKey; // Hash of the material, equal for meshes with equal materials
 }; // Mesh
 
 #endif /* Mesh_hpp */
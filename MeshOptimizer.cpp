@@ -0,0 +1,410 @@
+/**
+ MeshOptimizer.cpp
+ Virtual Keyboard
+ Implementation of MeshOptimizer.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/29/2018
+ */
+
+#include "MeshOptimizer.hpp"
+#include <algorithm>
+#include <float.h>
+#include <iomanip>
+#include <utility>
+
+//--------------------------------------------------------------------------
+/**
+ Reorders the triangles of a mesh in place, first for the vertex
+ cache and then for overdraw, and saves its ACMR and overdraw
+ from before and after for report(). Each triangle keeps its
+ vertices in the same order, so its winding does not change.
+ 
+ @param name What to call the mesh in the report.
+ @param vertices The vertices of the mesh.
+ @param numVertices The number of vertices.
+ @param indices The indices of the triangles (reordered).
+ @param numIndices The number of indices (three per triangle).
+ */
+void MeshOptimizer::optimize(const std::string& name, Vertex* vertices, unsigned int numVertices, unsigned int* indices, unsigned int numIndices)
+{
+    std::vector<glm::vec3> positions;
+    for(unsigned int i = 0; i < numVertices; i++)
+        positions.push_back(*vertices[i].getPos());
+    
+    MeshStats stats;
+    stats.name = name;
+    stats.numTriangles = numIndices / 3;
+    stats.acmrBefore = getAcmr(indices, numIndices, numVertices);
+    std::vector<bool> isUsed(numVertices, false);
+    unsigned int numUsed = 0;
+    for(unsigned int i = 0; i < numIndices; i++)
+    {
+        numUsed += isUsed[indices[i]] ? 0 : 1;
+        isUsed[indices[i]] = true;
+    } // for
+    stats.acmrBest = stats.numTriangles > 0 ? (float)numUsed / stats.numTriangles : 0.0f;
+    stats.overdrawBefore = getOverdraw(positions, indices, numIndices);
+    
+    std::vector<unsigned int> order;
+    std::vector<unsigned int> clusterStarts;
+    orderForCache(indices, numIndices, numVertices, order, clusterStarts);
+    orderForOverdraw(positions, indices, order, clusterStarts);
+    
+    std::vector<unsigned int> reordered;
+    for(unsigned int i = 0; i < order.size(); i++)
+        for(unsigned int k = 0; k < 3; k++)
+            reordered.push_back(indices[3 * order[i] + k]);
+    std::copy(reordered.begin(), reordered.end(), indices);
+    
+    stats.acmrAfter = getAcmr(indices, numIndices, numVertices);
+    stats.overdrawAfter = getOverdraw(positions, indices, numIndices);
+    m_stats.push_back(stats);
+} // MeshOptimizer::optimize(const std::string&, Vertex*, unsigned int, unsigned int*, unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Writes the ACMR and overdraw of every mesh optimized, before
+ and after, one mesh per line. The best ACMR a mesh can have is
+ its number of vertices over its number of triangles (each
+ vertex shaded once), which a mesh with flat faces reaches
+ easily, since its faces share no vertices.
+ 
+ @param out Where to write the report.
+ */
+void MeshOptimizer::report(std::ostream& out)
+{
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2);
+    for(unsigned int i = 0; i < m_stats.size(); i++)
+    {
+        out << "Mesh " << m_stats[i].name << ": " << m_stats[i].numTriangles << " triangles, ACMR (cache of " << CACHE_SIZE << ") "
+            << m_stats[i].acmrBefore << " -> " << m_stats[i].acmrAfter << " (at best " << m_stats[i].acmrBest << "), overdraw "
+            << m_stats[i].overdrawBefore << " -> " << m_stats[i].overdrawAfter << std::endl;
+    } // for
+    out.flags(flags);
+    out.precision(precision);
+} // MeshOptimizer::report(std::ostream&)
+
+//--------------------------------------------------------------------------
+/**
+ Works out the average cache miss ratio of a mesh: how many
+ vertices are shaded per triangle with a FIFO cache of
+ CACHE_SIZE vertices. It is 0.5 at best (for a huge regular
+ grid), and 3 at worst.
+ 
+ @param indices The indices of the triangles.
+ @param numIndices The number of indices.
+ @param numVertices The number of vertices.
+ @return The ACMR (0 for a mesh without triangles).
+ */
+float MeshOptimizer::getAcmr(const unsigned int* indices, unsigned int numIndices, unsigned int numVertices)
+{
+    if(numIndices < 3)
+        return 0.0f;
+    
+    // A vertex is in the cache if fewer than CACHE_SIZE misses
+    // happened since it was put in
+    std::vector<unsigned int> insertTime(numVertices, 0);
+    unsigned int time = CACHE_SIZE + 1;
+    unsigned int numMisses = 0;
+    for(unsigned int i = 0; i < numIndices; i++)
+    {
+        if(time - insertTime[indices[i]] > CACHE_SIZE)
+        {
+            insertTime[indices[i]] = time++;
+            numMisses++;
+        } // if
+    } // for
+    return (float)numMisses / (numIndices / 3);
+} // MeshOptimizer::getAcmr(const unsigned int*, unsigned int, unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Works out the overdraw of a mesh: how many fragments pass the
+ depth test (and so are shaded) for every pixel covered, when
+ the triangles are drawn in order with back faces culled. The
+ mesh is looked at from both sides along each axis, and 1 is
+ the best it can be.
+ 
+ @param positions The positions of the vertices.
+ @param indices The indices of the triangles.
+ @param numIndices The number of indices.
+ @return The overdraw (1 for a mesh which covers nothing).
+ */
+float MeshOptimizer::getOverdraw(const std::vector<glm::vec3>& positions, const unsigned int* indices, unsigned int numIndices)
+{
+    unsigned int numShaded = 0;
+    unsigned int numCovered = 0;
+    for(int axis = 0; axis < 3; axis++)
+    {
+        countFragments(positions, indices, numIndices, axis, 1.0f, numShaded, numCovered);
+        countFragments(positions, indices, numIndices, axis, -1.0f, numShaded, numCovered);
+    } // for
+    return numCovered > 0 ? (float)numShaded / numCovered : 1.0f;
+} // MeshOptimizer::getOverdraw(const std::vector<glm::vec3>&, const unsigned int*, unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Orders the triangles for the vertex cache with Tipsify (Sander,
+ Nehab and Barczak, 2007): the triangles around one vertex are
+ drawn together, and the next vertex to draw around is one whose
+ triangles were just drawn and which will still be in the cache
+ once its own are drawn. Where no such vertex is left (a dead
+ end), the cache starts over, and a new cluster of triangles
+ begins.
+ 
+ @param indices The indices of the triangles.
+ @param numIndices The number of indices.
+ @param numVertices The number of vertices.
+ @param order Set to the triangles in the order to draw them.
+ @param clusterStarts Set to where each cluster starts in order.
+ */
+void MeshOptimizer::orderForCache(const unsigned int* indices, unsigned int numIndices, unsigned int numVertices, std::vector<unsigned int>& order, std::vector<unsigned int>& clusterStarts)
+{
+    unsigned int numTriangles = numIndices / 3;
+    
+    // The triangles using each vertex, and how many are not drawn yet
+    std::vector<std::vector<unsigned int> > adjacency(numVertices);
+    for(unsigned int t = 0; t < numTriangles; t++)
+        for(unsigned int k = 0; k < 3; k++)
+            adjacency[indices[3 * t + k]].push_back(t);
+    std::vector<unsigned int> numLive(numVertices);
+    for(unsigned int v = 0; v < numVertices; v++)
+        numLive[v] = (unsigned int)adjacency[v].size();
+    
+    std::vector<unsigned int> cacheTime(numVertices, 0);
+    unsigned int time = CACHE_SIZE + 1;
+    std::vector<bool> isDrawn(numTriangles, false);
+    std::vector<unsigned int> deadEnds; // Vertices used lately, newest last
+    std::vector<unsigned int> candidates;
+    unsigned int cursor = 0;
+    int fanVertex = -1;
+    
+    order.clear();
+    clusterStarts.clear();
+    while(true)
+    {
+        // At a dead end, go back to the newest vertex used which
+        // still has triangles, or else to the next one in order
+        if(fanVertex < 0)
+        {
+            while(fanVertex < 0 && !deadEnds.empty())
+            {
+                if(numLive[deadEnds.back()] > 0)
+                    fanVertex = deadEnds.back();
+                deadEnds.pop_back();
+            } // while
+            while(fanVertex < 0 && cursor < numVertices)
+            {
+                if(numLive[cursor] > 0)
+                    fanVertex = cursor;
+                cursor++;
+            } // while
+            if(fanVertex < 0)
+                break;
+            if(time - cacheTime[fanVertex] > CACHE_SIZE)
+                clusterStarts.push_back((unsigned int)order.size());
+        } // if
+        
+        // Draw every triangle around the vertex
+        candidates.clear();
+        for(unsigned int i = 0; i < adjacency[fanVertex].size(); i++)
+        {
+            unsigned int t = adjacency[fanVertex][i];
+            if(isDrawn[t])
+                continue;
+            isDrawn[t] = true;
+            order.push_back(t);
+            for(unsigned int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[3 * t + k];
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                numLive[v]--;
+                if(time - cacheTime[v] > CACHE_SIZE)
+                    cacheTime[v] = time++;
+            } // for
+        } // for
+        
+        // Go on with the vertex which has been in the cache longest
+        // but will still be in it after its triangles are drawn
+        fanVertex = -1;
+        int bestPriority = -1;
+        for(unsigned int i = 0; i < candidates.size(); i++)
+        {
+            unsigned int v = candidates[i];
+            if(numLive[v] == 0)
+                continue;
+            int priority = 0;
+            if(time - cacheTime[v] + 2 * numLive[v] <= CACHE_SIZE)
+                priority = time - cacheTime[v];
+            if(priority > bestPriority)
+            {
+                bestPriority = priority;
+                fanVertex = v;
+            } // if
+        } // for
+    } // while
+} // MeshOptimizer::orderForCache(const unsigned int*, unsigned int, unsigned int, std::vector<unsigned int>&, std::vector<unsigned int>&)
+
+//--------------------------------------------------------------------------
+/**
+ Sorts the clusters from orderForCache() so that the ones facing
+ out from the middle of the mesh the most are drawn first: those
+ are the least likely to be hidden behind other triangles, and
+ the most likely to hide them. The order inside each cluster
+ (and so most of the cache order) is kept.
+ 
+ @param positions The positions of the vertices.
+ @param indices The indices of the triangles.
+ @param order The triangles in the order to draw them (sorted).
+ @param clusterStarts Where each cluster starts in order.
+ */
+void MeshOptimizer::orderForOverdraw(const std::vector<glm::vec3>& positions, const unsigned int* indices, std::vector<unsigned int>& order, const std::vector<unsigned int>& clusterStarts)
+{
+    // The middle of the mesh, weighting each triangle by its area
+    std::vector<glm::vec3> centres(order.size());
+    std::vector<glm::vec3> normals(order.size()); // Twice the area long
+    glm::vec3 meshCentre(0.0f);
+    float meshArea = 0.0f;
+    for(unsigned int i = 0; i < order.size(); i++)
+    {
+        const glm::vec3& p0 = positions[indices[3 * order[i]]];
+        const glm::vec3& p1 = positions[indices[3 * order[i] + 1]];
+        const glm::vec3& p2 = positions[indices[3 * order[i] + 2]];
+        centres[i] = (p0 + p1 + p2) / 3.0f;
+        normals[i] = glm::cross(p1 - p0, p2 - p0);
+        meshCentre += centres[i] * glm::length(normals[i]);
+        meshArea += glm::length(normals[i]);
+    } // for
+    if(meshArea > 0.0f)
+        meshCentre /= meshArea;
+    
+    // How far out each cluster faces (negated, to sort the most first)
+    std::vector<std::pair<float, unsigned int> > sortKeys;
+    for(unsigned int c = 0; c < clusterStarts.size(); c++)
+    {
+        unsigned int end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : (unsigned int)order.size();
+        glm::vec3 centre(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+        for(unsigned int i = clusterStarts[c]; i < end; i++)
+        {
+            centre += centres[i] * glm::length(normals[i]);
+            normal += normals[i];
+            area += glm::length(normals[i]);
+        } // for
+        float facing = 0.0f;
+        if(area > 0.0f && glm::length(normal) > 0.0f)
+            facing = glm::dot(centre / area - meshCentre, glm::normalize(normal));
+        sortKeys.push_back(std::make_pair(-facing, c));
+    } // for
+    std::sort(sortKeys.begin(), sortKeys.end()); // Ties stay in cache order
+    
+    std::vector<unsigned int> sorted;
+    for(unsigned int i = 0; i < sortKeys.size(); i++)
+    {
+        unsigned int c = sortKeys[i].second;
+        unsigned int end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : (unsigned int)order.size();
+        sorted.insert(sorted.end(), order.begin() + clusterStarts[c], order.begin() + end);
+    } // for
+    order = sorted;
+} // MeshOptimizer::orderForOverdraw(const std::vector<glm::vec3>&, const unsigned int*, std::vector<unsigned int>&, const std::vector<unsigned int>&)
+
+//--------------------------------------------------------------------------
+/**
+ Draws a mesh with a small software rasterizer, looking along
+ one axis, and counts the fragments which pass the depth test
+ and the pixels covered. Pixels on an edge shared by two
+ triangles belong to only one of them, as on a GPU.
+ 
+ @param positions The positions of the vertices.
+ @param indices The indices of the triangles.
+ @param numIndices The number of indices.
+ @param axis The axis to look along (0 to 2 for x to z).
+ @param side 1 to look from the positive side of the axis, -1
+ to look from the negative side.
+ @param numShaded Increased by the fragments which pass.
+ @param numCovered Increased by the pixels covered.
+ */
+void MeshOptimizer::countFragments(const std::vector<glm::vec3>& positions, const unsigned int* indices, unsigned int numIndices, int axis, float side, unsigned int& numShaded, unsigned int& numCovered)
+{
+    if(numIndices < 3)
+        return;
+    int uAxis = (axis + 1) % 3;
+    int vAxis = (axis + 2) % 3;
+    
+    // Fit the mesh into the grid, keeping its proportions
+    glm::vec3 boundsMin(FLT_MAX);
+    glm::vec3 boundsMax(-FLT_MAX);
+    for(unsigned int i = 0; i < numIndices; i++)
+    {
+        boundsMin = glm::min(boundsMin, positions[indices[i]]);
+        boundsMax = glm::max(boundsMax, positions[indices[i]]);
+    } // for
+    float extent = std::max(boundsMax[uAxis] - boundsMin[uAxis], boundsMax[vAxis] - boundsMin[vAxis]);
+    if(extent <= 0.0f)
+        return;
+    float scale = (OVERDRAW_GRID_SIZE - 1) / extent;
+    
+    std::vector<float> depths(OVERDRAW_GRID_SIZE * OVERDRAW_GRID_SIZE, FLT_MAX);
+    for(unsigned int t = 0; t + 2 < numIndices; t += 3)
+    {
+        glm::vec3 p[3] = { positions[indices[t]], positions[indices[t + 1]], positions[indices[t + 2]] };
+        
+        // Cull triangles facing away from the viewer
+        if(glm::cross(p[1] - p[0], p[2] - p[0])[axis] * side <= 0.0f)
+            continue;
+        
+        // Nearer is smaller, as with GL_LESS
+        glm::vec3 s[3];
+        for(int k = 0; k < 3; k++)
+            s[k] = glm::vec3((p[k][uAxis] - boundsMin[uAxis]) * scale + 0.5f, (p[k][vAxis] - boundsMin[vAxis]) * scale + 0.5f, -side * p[k][axis]);
+        float area = (s[1].x - s[0].x) * (s[2].y - s[0].y) - (s[1].y - s[0].y) * (s[2].x - s[0].x);
+        if(area < 0.0f)
+        {
+            std::swap(s[1], s[2]);
+            area = -area;
+        } // if
+        if(area == 0.0f)
+            continue;
+        
+        int minX = std::max(0, (int)std::min(s[0].x, std::min(s[1].x, s[2].x)));
+        int maxX = std::min((int)OVERDRAW_GRID_SIZE - 1, (int)std::max(s[0].x, std::max(s[1].x, s[2].x)));
+        int minY = std::max(0, (int)std::min(s[0].y, std::min(s[1].y, s[2].y)));
+        int maxY = std::min((int)OVERDRAW_GRID_SIZE - 1, (int)std::max(s[0].y, std::max(s[1].y, s[2].y)));
+        for(int y = minY; y <= maxY; y++)
+        {
+            for(int x = minX; x <= maxX; x++)
+            {
+                // Edge k is opposite vertex k; a pixel centre exactly
+                // on an edge only counts for one side of it
+                float weights[3];
+                bool isInside = true;
+                for(int k = 0; k < 3 && isInside; k++)
+                {
+                    const glm::vec3& a = s[(k + 1) % 3];
+                    const glm::vec3& b = s[(k + 2) % 3];
+                    weights[k] = (b.x - a.x) * (y + 0.5f - a.y) - (b.y - a.y) * (x + 0.5f - a.x);
+                    if(weights[k] < 0.0f || (weights[k] == 0.0f && !(b.y > a.y || (b.y == a.y && b.x < a.x))))
+                        isInside = false;
+                } // for
+                if(!isInside)
+                    continue;
+                float depth = (weights[0] * s[0].z + weights[1] * s[1].z + weights[2] * s[2].z) / area;
+                float& stored = depths[y * OVERDRAW_GRID_SIZE + x];
+                if(depth < stored)
+                {
+                    stored = depth;
+                    numShaded++;
+                } // if
+            } // for
+        } // for
+    } // for
+    
+    for(unsigned int i = 0; i < depths.size(); i++)
+        if(depths[i] < FLT_MAX)
+            numCovered++;
+} // MeshOptimizer::countFragments(const std::vector<glm::vec3>&, const unsigned int*, unsigned int, int, float, unsigned int&, unsigned int&)
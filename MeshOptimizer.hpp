@@ -0,0 +1,59 @@
+/**
+ MeshOptimizer.hpp
+ Virtual Keyboard
+ Class which reorders the triangles of a mesh so that it is
+ drawn faster: first for the post-transform vertex cache (with
+ Tipsify, so that a vertex is usually still in the cache the
+ next time it is used), then for overdraw (clusters of triangles
+ facing out from the middle of the mesh are drawn first, so the
+ triangles behind them fail the depth test instead of being
+ shaded). It measures the average cache miss ratio (ACMR: vertices
+ shaded per triangle) and the overdraw (fragments shaded per pixel
+ covered, looking at the mesh along each axis) before and after,
+ so that they can be reported.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/29/2018
+ */
+
+#ifndef MeshOptimizer_hpp
+#define MeshOptimizer_hpp
+
+#include <glm/glm.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Mesh.hpp"
+
+class MeshOptimizer
+{
+public:
+    void optimize(const std::string& name, Vertex* vertices, unsigned int numVertices, unsigned int* indices, unsigned int numIndices);
+    void report(std::ostream& out);
+    
+    static float getAcmr(const unsigned int* indices, unsigned int numIndices, unsigned int numVertices);
+    static float getOverdraw(const std::vector<glm::vec3>& positions, const unsigned int* indices, unsigned int numIndices);
+    
+    const static unsigned int CACHE_SIZE = 16; // Vertices in the (FIFO) cache optimized for and measured
+    const static unsigned int OVERDRAW_GRID_SIZE = 128; // Pixels across each view when measuring overdraw
+private:
+    // What was measured for one mesh
+    struct MeshStats
+    {
+        std::string name;
+        unsigned int numTriangles;
+        float acmrBest; // Every vertex used shaded once
+        float acmrBefore;
+        float acmrAfter;
+        float overdrawBefore;
+        float overdrawAfter;
+    }; // MeshStats
+    
+    static void orderForCache(const unsigned int* indices, unsigned int numIndices, unsigned int numVertices, std::vector<unsigned int>& order, std::vector<unsigned int>& clusterStarts);
+    static void orderForOverdraw(const std::vector<glm::vec3>& positions, const unsigned int* indices, std::vector<unsigned int>& order, const std::vector<unsigned int>& clusterStarts);
+    static void countFragments(const std::vector<glm::vec3>& positions, const unsigned int* indices, unsigned int numIndices, int axis, float side, unsigned int& numShaded, unsigned int& numCovered);
+    
+    std::vector<MeshStats> m_stats;
+}; // MeshOptimizer
+
+#endif /* MeshOptimizer_hpp */
@@ -0,0 +1,70 @@
+/**
+ MetricRing.cpp
+ Virtual Keyboard
+ Implementation of MetricRing.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/23/2018
+ */
+
+#include "MetricRing.hpp"
+
+//--------------------------------------------------------------------------
+/**
+ Creates an empty ring.
+ */
+MetricRing::MetricRing()
+{
+    for(unsigned int i = 0; i < SIZE; i++)
+        m_values[i].store(0.0f, std::memory_order_relaxed);
+    m_numPushed.store(0, std::memory_order_relaxed);
+} // MetricRing::MetricRing()
+
+//--------------------------------------------------------------------------
+/**
+ Adds a value, replacing the oldest one. Only one thread may
+ push to a ring.
+ 
+ @param value The value to add.
+ */
+void MetricRing::push(float value)
+{
+    unsigned int index = m_numPushed.load(std::memory_order_relaxed);
+    m_values[index & (SIZE - 1)].store(value, std::memory_order_relaxed);
+    m_numPushed.store(index + 1, std::memory_order_release); // Publishes the value
+} // MetricRing::push(float)
+
+//--------------------------------------------------------------------------
+/**
+ Copies the latest values, oldest first.
+ 
+ @param values Where to copy the values.
+ @param maxValues How many values fit (at most MAX_READ are read).
+ @return How many values were copied.
+ */
+unsigned int MetricRing::read(float* values, unsigned int maxValues)
+{
+    unsigned int numPushed = m_numPushed.load(std::memory_order_acquire);
+    unsigned int count = maxValues < MAX_READ ? maxValues : MAX_READ;
+    if(numPushed < count)
+        count = numPushed;
+    
+    unsigned int first = numPushed - count;
+    for(unsigned int i = 0; i < count; i++)
+        values[i] = m_values[(first + i) & (SIZE - 1)].load(std::memory_order_relaxed);
+    return count;
+} // MetricRing::read(float*, unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Gets the latest value.
+ 
+ @return The latest value (0 if nothing was pushed yet).
+ */
+float MetricRing::getLatest()
+{
+    unsigned int numPushed = m_numPushed.load(std::memory_order_acquire);
+    if(numPushed == 0)
+        return 0.0f;
+    return m_values[(numPushed - 1) & (SIZE - 1)].load(std::memory_order_relaxed);
+} // MetricRing::getLatest()
@@ -0,0 +1,36 @@
+/**
+ MetricRing.hpp
+ Virtual Keyboard
+ Class for a ring of the latest values of one metric, written
+ by one thread (such as the audio thread) and read by another
+ (the render thread) without any locks. The writer never
+ waits; the reader gets the latest values it can see.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/23/2018
+ */
+
+#ifndef MetricRing_hpp
+#define MetricRing_hpp
+
+#include <atomic>
+
+class MetricRing
+{
+public:
+    MetricRing();
+    
+    void push(float value);
+    unsigned int read(float* values, unsigned int maxValues);
+    float getLatest();
+    
+    static const unsigned int SIZE = 256; // Values kept (a power of two)
+    static const unsigned int MAX_READ = SIZE / 2; // Values read at once, so the writer cannot catch up
+private:
+    // Each value is atomic so that reading one while it is
+    // overwritten is not a data race
+    std::atomic<float> m_values[SIZE];
+    std::atomic<unsigned int> m_numPushed; // Only ever increases (wrapping is fine)
+}; // MetricRing
+
+#endif /* MetricRing_hpp */
@@ -0,0 +1,148 @@
+/**
+ OfflineMixer.cpp
+ Virtual Keyboard
+ Implementation of OfflineMixer.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/25/2018
+ */
+
+#include "OfflineMixer.hpp"
+#include <iostream>
+
+//--------------------------------------------------------------------------
+/**
+ Creates a mixer with the same format as the audio device that
+ SDL Mixer opened (which the chunks were converted to when they
+ were loaded). Only 16-bit samples are mixed; with any other
+ format, the mixer stays silent.
+ 
+ @param numVoices How many sounds can play at once.
+ */
+OfflineMixer::OfflineMixer(int numVoices)
+{
+    Uint16 format = 0;
+    m_frequency = 0;
+    m_numChannels = 0;
+    m_isSupported = (Mix_QuerySpec(&m_frequency, &format, &m_numChannels) != 0 && format == AUDIO_S16SYS);
+    if(!m_isSupported)
+    {
+        std::cout << "The offline mixer needs 16-bit audio, so the rendered sound will be silent." << std::endl;
+        if(m_frequency <= 0 || m_numChannels <= 0)
+        {
+            m_frequency = 44100;
+            m_numChannels = 2;
+        } // if
+    } // if
+    
+    Voice freeVoice = { NULL, 0, 0, MIX_MAX_VOLUME, Envelope() };
+    m_voices.assign(numVoices, freeVoice);
+} // OfflineMixer::OfflineMixer(int)
+
+//--------------------------------------------------------------------------
+/**
+ Starts playing a chunk on the first free voice.
+ 
+ @param chunk The chunk to play.
+ @param shape The shape of the voice's envelope.
+ @return The voice it plays on, or -1 if every voice is
+ busy (or the chunk could not be played).
+ */
+int OfflineMixer::play(Mix_Chunk* chunk, const EnvelopeShape& shape)
+{
+    if(!chunk || !m_isSupported)
+        return -1;
+    for(unsigned int i = 0; i < m_voices.size(); i++)
+    {
+        if(m_voices[i].samples)
+            continue;
+        Voice& voice = m_voices[i];
+        voice.samples = (const Sint16*)chunk->abuf;
+        voice.numFrames = chunk->alen / (sizeof(Sint16) * m_numChannels);
+        voice.position = 0;
+        voice.volume = chunk->volume;
+        voice.envelope.noteOn(shape, m_frequency);
+        return (int)i;
+    } // for
+    return -1;
+} // OfflineMixer::play(Mix_Chunk*, const EnvelopeShape&)
+
+//--------------------------------------------------------------------------
+/**
+ Starts the release of a voice's envelope (the voice is freed
+ once the release is over).
+ 
+ @param voice The voice to release.
+ */
+void OfflineMixer::release(int voice)
+{
+    if(voice < 0 || voice >= (int)m_voices.size() || !m_voices[voice].samples)
+        return;
+    m_voices[voice].envelope.noteOff();
+} // OfflineMixer::release(int)
+
+//--------------------------------------------------------------------------
+/**
+ Mixes the next sample frames of every voice that is playing,
+ clipping the sum to 16 bits. Each voice's block is shaped by
+ its envelope before its volume is applied (as SDL Mixer runs
+ effects before mixing a channel in).
+ 
+ @param samples Where to put the mixed samples (numFrames
+ times the number of channels, interleaved).
+ @param numFrames How many sample frames to mix.
+ */
+void OfflineMixer::mix(Sint16* samples, unsigned int numFrames)
+{
+    unsigned int numSamples = numFrames * m_numChannels;
+    m_mixed.assign(numSamples, 0);
+    for(unsigned int i = 0; i < m_voices.size(); i++)
+    {
+        Voice& voice = m_voices[i];
+        if(!voice.samples)
+            continue;
+        if(voice.position >= voice.numFrames)
+        {
+            voice.samples = NULL; // Finished playing
+            continue;
+        } // if
+        unsigned int blockFrames = voice.numFrames - voice.position;
+        if(blockFrames > numFrames)
+            blockFrames = numFrames;
+        const Sint16* in = voice.samples + voice.position * m_numChannels;
+        m_block.assign(in, in + blockFrames * m_numChannels);
+        unsigned int numShaped = voice.envelope.apply(&m_block[0], blockFrames, m_numChannels);
+        for(unsigned int j = 0; j < numShaped * m_numChannels; j++)
+            m_mixed[j] += m_block[j] * voice.volume / MIX_MAX_VOLUME;
+        voice.position += numShaped;
+        if(numShaped < blockFrames || voice.position >= voice.numFrames)
+            voice.samples = NULL; // Silent or finished playing
+    } // for
+    
+    for(unsigned int i = 0; i < numSamples; i++)
+    {
+        int sample = m_mixed[i];
+        if(sample > 32767)
+            sample = 32767;
+        else if(sample < -32768)
+            sample = -32768;
+        samples[i] = (Sint16)sample;
+    } // for
+} // OfflineMixer::mix(Sint16*, unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Gets how many voices are playing.
+ 
+ @return The number of voices in use.
+ */
+unsigned int OfflineMixer::getNumPlaying()
+{
+    unsigned int numPlaying = 0;
+    for(unsigned int i = 0; i < m_voices.size(); i++)
+    {
+        if(m_voices[i].samples)
+            numPlaying++;
+    } // for
+    return numPlaying;
+} // OfflineMixer::getNumPlaying()
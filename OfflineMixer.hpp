@@ -0,0 +1,60 @@
+/**
+ OfflineMixer.hpp
+ Virtual Keyboard
+ Class which mixes the keys' sounds itself instead of playing
+ them through SDL Mixer, so that a session can be rendered
+ faster (or slower) than real time. It copies how SDL Mixer
+ plays a chunk on a channel shaped by an envelope, but only
+ mixes when asked for a number of samples, so the audio always
+ lines up exactly with the frames rendered.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/25/2018
+ */
+
+#ifndef OfflineMixer_hpp
+#define OfflineMixer_hpp
+
+#include "Envelope.hpp"
+#include <SDL2/SDL.h>
+#include <SDL2_mixer/SDL_mixer.h>
+#include <vector>
+
+class OfflineMixer
+{
+public:
+    OfflineMixer(int numVoices);
+    
+    int play(Mix_Chunk* chunk, const EnvelopeShape& shape);
+    void release(int voice);
+    void mix(Sint16* samples, unsigned int numFrames);
+    unsigned int getNumPlaying();
+    
+    /**
+     Gets how many samples per second are mixed (per channel).
+     */
+    inline int getFrequency() { return m_frequency; }
+    /**
+     Gets how many channels each sample frame has.
+     */
+    inline int getNumChannels() { return m_numChannels; }
+private:
+    // One sound being played (like one SDL Mixer channel)
+    struct Voice
+    {
+        const Sint16* samples; // NULL if the voice is free
+        unsigned int numFrames;
+        unsigned int position; // Next frame to mix
+        int volume; // 0 to MIX_MAX_VOLUME
+        Envelope envelope; // The voice is freed once it is silent
+    }; // Voice
+    
+    std::vector<Voice> m_voices;
+    std::vector<int> m_mixed; // Scratch space for one call to mix()
+    std::vector<Sint16> m_block; // One voice's samples, shaped by its envelope
+    int m_frequency;
+    int m_numChannels;
+    bool m_isSupported; // False if the chunks are not 16-bit samples
+}; // OfflineMixer
+
+#endif /* OfflineMixer_hpp */
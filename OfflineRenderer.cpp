@@ -0,0 +1,207 @@
+/**
+ OfflineRenderer.cpp
+ Virtual Keyboard
+ Implementation of OfflineRenderer.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/25/2018
+ */
+
+#include "OfflineRenderer.hpp"
+#include <chrono>
+#include <iostream>
+#include <math.h>
+#include <vector>
+#include <sys/stat.h>
+
+//--------------------------------------------------------------------------
+/**
+ Adds a number to a buffer in little-endian order (as WAV
+ files store them).
+ 
+ @param buffer The buffer to add to.
+ @param value The number to add.
+ @param numBytes How many bytes the number takes up.
+ */
+static void appendLittleEndian(std::vector<unsigned char>& buffer, unsigned int value, int numBytes)
+{
+    for(int i = 0; i < numBytes; i++)
+        buffer.push_back((unsigned char)(value >> (8 * i)));
+} // appendLittleEndian(std::vector<unsigned char>&, unsigned int, int)
+
+//--------------------------------------------------------------------------
+/**
+ Creates a renderer with an offscreen framebuffer of the given
+ size, and switches the keys' sounds over to the offline
+ mixer (so this is only made when rendering offline).
+ 
+ @param display The display which draws the frames.
+ @param camera The camera the session moves.
+ @param keys The keys, which are pressed as in the session.
+ @param width The width of the frames in pixels.
+ @param height The height of the frames in pixels.
+ */
+OfflineRenderer::OfflineRenderer(Display* display, Camera* camera, KeyboardKeys* keys, int width, int height)
+: m_mixer(NUM_VOICES)
+{
+    m_display = display;
+    m_camera = camera;
+    m_keys = keys;
+    m_width = width;
+    m_height = height;
+    m_keys->setOfflineMixer(&m_mixer);
+    m_camera->updateAspectRatio((float)width / (float)height);
+    
+    // Store sRGB colours if the window would have (so the shaders are the same)
+    glGenRenderbuffers(NUM_RENDERBUFFERS, m_renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[COLOR_RB]);
+    glRenderbufferStorage(GL_RENDERBUFFER, display->hasSrgbFramebuffer() ? GL_SRGB8_ALPHA8 : GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[DEPTH_RB]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_renderbuffers[COLOR_RB]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_renderbuffers[DEPTH_RB]);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cerr << "The offscreen framebuffer is not complete." << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+} // OfflineRenderer::OfflineRenderer(Display*, Camera*, KeyboardKeys*, int, int)
+
+//--------------------------------------------------------------------------
+/**
+ Destroys the offscreen framebuffer.
+ */
+OfflineRenderer::~OfflineRenderer()
+{
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteRenderbuffers(NUM_RENDERBUFFERS, m_renderbuffers);
+} // OfflineRenderer::~OfflineRenderer()
+
+//--------------------------------------------------------------------------
+/**
+ Renders a session from start to finish (plus a little time
+ for the last note to fade). Every frame is saved as one frame
+ of a recording, and the sound is saved as a 16-bit WAV file.
+ Each frame covers exactly 1/60 of a second of sound, with any
+ note it presses starting at the beginning of that sound.
+ 
+ @param session The session to render.
+ @param frameCapture The capturer which saves the frames.
+ @param wavPath The path of the WAV file to write.
+ @return True if the WAV file was written.
+ */
+bool OfflineRenderer::render(Session* session, FrameCapture* frameCapture, const std::string& wavPath)
+{
+    std::string::size_type slash = wavPath.rfind('/');
+    if(slash != std::string::npos)
+        mkdir(wavPath.substr(0, slash).c_str(), 0755); // Fails harmlessly if it is already there
+    FILE* wavFile = fopen(wavPath.c_str(), "wb");
+    if(!wavFile || !writeWavHeader(wavFile, 0)) // Sizes are filled in at the end
+    {
+        std::cerr << "Could not write " << wavPath << std::endl;
+        if(wavFile)
+            fclose(wavFile);
+        return false;
+    } // if
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glViewport(0, 0, m_width, m_height);
+    frameCapture->setLossless(true);
+    frameCapture->startRecording();
+    
+    FrameTimer* frameTimer = m_display->getFrameTimer();
+    const float FRAME_MS = 1000.0f / FRAMES_PER_SECOND;
+    unsigned int numFrames = (unsigned int)ceil((session->getDurationMs() + TAIL_MS) / FRAME_MS);
+    unsigned long long numSampleFrames = 0; // Mixed so far
+    unsigned int numDataBytes = 0;
+    bool isWritten = true;
+    std::vector<Sint16> samples;
+    std::vector<unsigned char> bytes;
+    FrameSnapshot snapshot;
+    for(unsigned int frame = 0; frame < numFrames; frame++)
+    {
+        // Move everything to the start of this frame on the virtual clock
+        session->apply(frame * (1000.0 / FRAMES_PER_SECOND), m_camera, m_keys);
+        if(frame > 0)
+            m_keys->advanceClock(FRAME_MS);
+        m_keys->pressKeyAt(m_camera->getPos());
+        
+        frameTimer->beginFrame();
+        m_display->takeSnapshot(snapshot);
+        m_display->drawScene(snapshot);
+        frameCapture->capture(m_width, m_height);
+        frameTimer->beginSwap();
+        frameTimer->endFrame();
+        
+        // Mix exactly the samples up to the start of the next frame
+        unsigned long long endSampleFrame = (unsigned long long)(frame + 1) * m_mixer.getFrequency() / FRAMES_PER_SECOND;
+        unsigned int frameSamples = (unsigned int)(endSampleFrame - numSampleFrames);
+        if(frameSamples > 0)
+        {
+            samples.resize(frameSamples * m_mixer.getNumChannels());
+            m_mixer.mix(&samples[0], frameSamples);
+            bytes.clear();
+            for(unsigned int i = 0; i < samples.size(); i++)
+                appendLittleEndian(bytes, (Uint16)samples[i], 2);
+            isWritten = isWritten && fwrite(&bytes[0], 1, bytes.size(), wavFile) == bytes.size();
+            numDataBytes += (unsigned int)bytes.size();
+        } // if
+        numSampleFrames = endSampleFrame;
+        
+        if((frame + 1) % (FRAMES_PER_SECOND * 10) == 0)
+            std::cout << "Rendered " << frame + 1 << " of " << numFrames << " frames." << std::endl;
+    } // for
+    
+    frameCapture->stopRecording();
+    frameCapture->finish();
+    frameCapture->setLossless(false);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    
+    fseek(wavFile, 0, SEEK_SET);
+    isWritten = writeWavHeader(wavFile, numDataBytes) && isWritten;
+    isWritten = (fclose(wavFile) == 0) && isWritten;
+    
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    float videoSeconds = (float)numFrames / FRAMES_PER_SECOND;
+    std::cout << "Rendered " << numFrames << " frames (" << videoSeconds << " s at " << FRAMES_PER_SECOND
+              << " fps) in " << seconds << " s, " << (seconds > 0.0f ? videoSeconds / seconds : 0.0f)
+              << "x real time." << std::endl;
+    frameCapture->report(std::cout);
+    frameTimer->report(std::cout);
+    return isWritten;
+} // OfflineRenderer::render(Session*, FrameCapture*, const std::string&)
+
+//--------------------------------------------------------------------------
+/**
+ Writes the 44-byte header of a 16-bit PCM WAV file.
+ 
+ @param file The file, at its start.
+ @param numDataBytes How many bytes of samples follow.
+ @return True if the header was written.
+ */
+bool OfflineRenderer::writeWavHeader(FILE* file, unsigned int numDataBytes)
+{
+    unsigned int numChannels = (unsigned int)m_mixer.getNumChannels();
+    unsigned int frequency = (unsigned int)m_mixer.getFrequency();
+    std::vector<unsigned char> header;
+    header.insert(header.end(), "RIFF", "RIFF" + 4);
+    appendLittleEndian(header, 36 + numDataBytes, 4);
+    header.insert(header.end(), "WAVE", "WAVE" + 4);
+    header.insert(header.end(), "fmt ", "fmt " + 4);
+    appendLittleEndian(header, 16, 4); // Size of the format
+    appendLittleEndian(header, 1, 2); // PCM
+    appendLittleEndian(header, numChannels, 2);
+    appendLittleEndian(header, frequency, 4);
+    appendLittleEndian(header, frequency * numChannels * 2, 4); // Bytes per second
+    appendLittleEndian(header, numChannels * 2, 2); // Bytes per sample frame
+    appendLittleEndian(header, 16, 2); // Bits per sample
+    header.insert(header.end(), "data", "data" + 4);
+    appendLittleEndian(header, numDataBytes, 4);
+    return fwrite(&header[0], 1, header.size(), file) == header.size();
+} // OfflineRenderer::writeWavHeader(FILE*, unsigned int)
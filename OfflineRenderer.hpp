@@ -0,0 +1,66 @@
+/**
+ OfflineRenderer.hpp
+ Virtual Keyboard
+ Class which renders a recorded session at a fixed frame rate,
+ however fast (or slow) the computer is. The camera, the keys'
+ movement and the sound all follow a virtual clock which moves
+ forward exactly one frame at a time. Frames are drawn into an
+ offscreen framebuffer and saved without dropping any, and the
+ sound of each frame is mixed into a WAV file right after it,
+ so the picture and the sound always line up.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/25/2018
+ */
+
+#ifndef OfflineRenderer_hpp
+#define OfflineRenderer_hpp
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <stdio.h>
+#include <string>
+#include "Display.hpp"
+#include "Camera.hpp"
+#include "KeyboardKeys.hpp"
+#include "FrameCapture.hpp"
+#include "OfflineMixer.hpp"
+#include "Session.hpp"
+
+class OfflineRenderer
+{
+public:
+    OfflineRenderer(Display* display, Camera* camera, KeyboardKeys* keys, int width, int height);
+    virtual ~OfflineRenderer();
+    
+    bool render(Session* session, FrameCapture* frameCapture, const std::string& wavPath);
+    
+    static const unsigned int FRAMES_PER_SECOND = 60;
+private:
+    // An enumerated type for the buffers which go in the m_renderbuffers array.
+    enum {
+        COLOR_RB,
+        DEPTH_RB,
+        
+        NUM_RENDERBUFFERS
+    }; // enum
+    
+    bool writeWavHeader(FILE* file, unsigned int numDataBytes);
+    
+    static const unsigned int TAIL_MS = 2000; // Rendered after the last sample so the last note can fade
+    static const int NUM_VOICES = 64; // As many as SDL Mixer has channels
+    
+    Display* m_display;
+    Camera* m_camera;
+    KeyboardKeys* m_keys;
+    OfflineMixer m_mixer;
+    
+    // Offscreen framebuffer the frames are drawn into
+    GLuint m_framebuffer;
+    GLuint m_renderbuffers[NUM_RENDERBUFFERS];
+    int m_width;
+    int m_height;
+}; // OfflineRenderer
+
+#endif /* OfflineRenderer_hpp */
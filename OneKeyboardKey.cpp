@@ -13,59 +13,77 @@
 //--------------------------------------------------------------------------
 /**
  Creates a KeyboardKey, which is a Mesh with some added features
- including a sound and keypress depth
+ including a sound and keypress depth. The sounds come from the
+ sample pool, so keys (on any keyboard) with the same sound
+ files share one copy of them.
  */
 OneKeyboardKey::OneKeyboardKey(Vertex* vertices, unsigned int numVertices, unsigned int* indices, unsigned int numIndices, Shader* shader, Transform transform, std::string organSoundPath, std::string pianoSoundPath)
 : Mesh(vertices, numVertices, indices, numIndices, shader, transform)
 {
-    m_soundEffect = new Mix_Chunk*[NUM_SOUNDS];
-    
     m_keyLevel = 0;
-    m_soundEffect[ORGAN_SOUND] = Mix_LoadWAV(organSoundPath.c_str());
-    m_soundEffect[PIANO_SOUND] = Mix_LoadWAV(pianoSoundPath.c_str());
-    if(!m_soundEffect[ORGAN_SOUND])
+    m_drawnLevel = 0;
+    m_restPosition = m_transform.getPos();
+    m_direction = 0;
+    m_msToNextStep = 0.0f;
+    m_soundChannel = -1;
+    m_offlineMixer = NULL;
+    m_soundEffect[ORGAN_SOUND] = SamplePool::load(organSoundPath);
+    m_soundEffect[PIANO_SOUND] = SamplePool::load(pianoSoundPath);
+    if(!m_soundEffect[ORGAN_SOUND].getChunk())
         std::cout << "Problem with Mix_LoadWAV for the organ sound at key " << organSoundPath << "\n" << Mix_GetError();
-    if(!m_soundEffect[PIANO_SOUND])
+    if(!m_soundEffect[PIANO_SOUND].getChunk())
         std::cout << "Problem with Mix_LoadWAV for the piano sound at key " << pianoSoundPath << "\n" << Mix_GetError();
 } // OneKeyboardKey::OneKeyboardKey(Vertex*, unsigned int, unsigned int*, unsigned int, Shader*, Transform, std::string, std::string)
 
 //--------------------------------------------------------------------------
 /**
- Destroys the KeyboardKey and stops the sound effect.
+ Destroys the KeyboardKey (its sound effects are given back
+ to the sample pool, which frees them once no key uses them).
  */
 OneKeyboardKey::~OneKeyboardKey()
 {
-    for(int i = 0; i < NUM_SOUNDS; i++)
-    {
-        Mix_FreeChunk(m_soundEffect[i]);
-    } // for
-    delete[] m_soundEffect;
     delete[] m_vertexArrayBuffers;
     glDeleteVertexArrays(1, &m_vertexArrayObject);
 } // Mesh::~Mesh()
 
 //--------------------------------------------------------------------------
 /**
- Presses the key down by one keyLevel by moving
- the model matrix down in the y axis.
+ Presses the key down by one keyLevel. It is drawn there
+ once the level is passed to setDrawnLevel().
  */
 void OneKeyboardKey::keyDown()
 {
     m_keyLevel -= 1;
-    m_transform.moveDown(INCREMENTAL_DEPTH);
 } // OneKeyboardKey::keyDown()
 
 //--------------------------------------------------------------------------
 /**
- Pulls the key up by one keyLevel by moving the model
- matrix up in the y-axis.
+ Pulls the key up by one keyLevel. It is drawn there
+ once the level is passed to setDrawnLevel().
  */
 void OneKeyboardKey::keyUp()
 {
     m_keyLevel += 1;
-    m_transform.moveUp(INCREMENTAL_DEPTH);
 } // OneKeyboardKey::keyUp()
 
+//--------------------------------------------------------------------------
+/**
+ Moves the model matrix down in the y axis to a key
+ level. The key is drawn at its own level, which the
+ render thread copies from a snapshot of the simulation,
+ so the simulation never touches what is being drawn.
+ 
+ @param level The key level to draw the key at (0 at
+ rest, down to -NUM_INTERVALS).
+ */
+void OneKeyboardKey::setDrawnLevel(int level)
+{
+    if(level == m_drawnLevel)
+        return;
+    m_drawnLevel = level;
+    m_transform.setPos(m_restPosition + glm::vec3(0.0f, level * INCREMENTAL_DEPTH, 0.0f));
+} // OneKeyboardKey::setDrawnLevel(int)
+
 //--------------------------------------------------------------------------
 /**
  Detects if the key is currently moving (that is,
@@ -90,19 +108,92 @@ bool OneKeyboardKey::keyIsMoving()
  @param soundToPlay The index of the sound the user
  wants played, starting at index 0. In this case,
  0 is the organ and 1 is the piano.
+ @param envelope The shape of the sound's volume envelope.
  */
-void OneKeyboardKey::playSound(int soundToPlay)
+void OneKeyboardKey::playSound(int soundToPlay, const EnvelopeShape& envelope)
 {
-    m_soundChannel = Mix_PlayChannel(-1, m_soundEffect[soundToPlay], 0);
+    if(m_offlineMixer)
+    {
+        m_soundChannel = m_offlineMixer->play(m_soundEffect[soundToPlay].getChunk(), envelope);
+        return;
+    } // if
+    m_soundChannel = Envelope::playChannel(m_soundEffect[soundToPlay].getChunk(), envelope);
     if(m_soundChannel == -1)
         std::cout << "Mix_PlayChannel error: \n" << Mix_GetError() << "\n";
-} // OneKeyboardKey::playSound()
+} // OneKeyboardKey::playSound(int, const EnvelopeShape&)
 
 //--------------------------------------------------------------------------
 /**
- Stops the keyboard key's sound and frees the channel.
+ Releases the keyboard key's sound (the channel is freed once
+ its envelope has faded to silence).
  */
 void OneKeyboardKey::stopSound()
 {
-    Mix_FadeOutChannel(m_soundChannel, DELAY_BEFORE_STOP_SOUND);
+    if(m_offlineMixer)
+        m_offlineMixer->release(m_soundChannel);
+    else
+        Envelope::releaseChannel(m_soundChannel);
 } // OneKeyboardKey::stopSound()
+
+//--------------------------------------------------------------------------
+/**
+ Makes the key play its sounds through an offline mixer
+ instead of SDL Mixer.
+ 
+ @param mixer The mixer to use (NULL for SDL Mixer).
+ */
+void OneKeyboardKey::setOfflineMixer(OfflineMixer* mixer)
+{
+    m_offlineMixer = mixer;
+} // OneKeyboardKey::setOfflineMixer(OfflineMixer*)
+
+//--------------------------------------------------------------------------
+/**
+ Starts moving the key on the simulation's clock (the first
+ step is taken one step's time from now).
+ 
+ @param direction -1 to press the key down, 1 to lift it up.
+ */
+void OneKeyboardKey::startMoving(int direction)
+{
+    if(m_direction != direction)
+        m_msToNextStep = 0.0f;
+    m_direction = direction;
+} // OneKeyboardKey::startMoving(int)
+
+//--------------------------------------------------------------------------
+/**
+ Moves the key by as many steps as fit in the time passed on
+ the simulation's clock, until it is at the bottom (or top).
+ 
+ @param ms Milliseconds passed on the simulation's clock.
+ @param stepMs Milliseconds between steps.
+ @return True if the key moved.
+ */
+bool OneKeyboardKey::advanceClock(float ms, float stepMs)
+{
+    if(m_direction == 0)
+        return false;
+    bool isMoved = false;
+    if(m_msToNextStep <= 0.0f)
+        m_msToNextStep = stepMs;
+    m_msToNextStep -= ms;
+    while(m_msToNextStep <= 0.0f && m_direction != 0)
+    {
+        if(m_direction < 0 && !isAtBottom())
+        {
+            keyDown();
+            isMoved = true;
+        } // if
+        else if(m_direction > 0 && !isAtTop())
+        {
+            keyUp();
+            isMoved = true;
+        } // else if
+        if((m_direction < 0 && isAtBottom()) || (m_direction > 0 && isAtTop()))
+            m_direction = 0;
+        else
+            m_msToNextStep += stepMs;
+    } // while
+    return isMoved;
+} // OneKeyboardKey::advanceClock(float, float)
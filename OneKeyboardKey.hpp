@@ -14,6 +14,9 @@
 #define OneKeyboardKey_hpp
 
 #include "Mesh.hpp"
+#include "OfflineMixer.hpp"
+#include "SamplePool.hpp"
+#include "Envelope.hpp"
 #include <iostream>
 #include <SDL2_mixer/SDL_mixer.h>
 #include <string>
@@ -29,10 +32,20 @@ public:
     void keyDown();
     void keyUp();
     bool keyIsMoving();
-    void playSound(int soundToPlay);
+    void playSound(int soundToPlay, const EnvelopeShape& envelope);
     void stopSound();
+    void setOfflineMixer(OfflineMixer* mixer);
+    void startMoving(int direction);
+    bool advanceClock(float ms, float stepMs);
+    void setDrawnLevel(int level);
     inline bool isAtBottom() { return m_keyLevel == -NUM_INTERVALS; }
     inline bool isAtTop() { return m_keyLevel >= 0; }
+    inline int getKeyLevel() { return m_keyLevel; }
+    /**
+     Gets whether the key is drawn at rest (all the way up).
+     */
+    inline bool isDrawnAtRest() { return m_drawnLevel >= 0; }
+    inline float getKeypressDepth() { return KEYPRESS_DEPTH; }
     
     // Public enum for which index the organ and piano sounds
     // are.
@@ -42,18 +55,25 @@ public:
         NUM_SOUNDS
     };
 private:
-    inline float getKeyLevel() { return m_keyLevel; };
     int m_keyLevel; // Stores what level the key is at (if it is being pressed)
     
+    // Where the key is drawn (only changed by the render thread)
+    int m_drawnLevel;
+    glm::vec3 m_restPosition; // Position of the transform at level 0
+    
+    // Movement on the simulation's clock
+    int m_direction; // -1 going down, 1 going up, 0 not moving
+    float m_msToNextStep;
+    
     // Sound information
-    Mix_Chunk** m_soundEffect; // Stores the sound effect for the key
+    SampleHandle m_soundEffect[NUM_SOUNDS]; // The key's sound effects (shared with any other key using the same files)
     int m_soundChannel; // Stores the channel the sound is playing on
+    OfflineMixer* m_offlineMixer; // Plays the sounds instead of SDL Mixer (NULL if not used)
     
     // Constants
     const int NUM_INTERVALS = 5; // How many different levels the key can go down to
     const int KEYPRESS_DEPTH = 1; // How far down a key goes down
     const float INCREMENTAL_DEPTH = (float)KEYPRESS_DEPTH / (float)NUM_INTERVALS; // How much to go down each time
-    const int DELAY_BEFORE_STOP_SOUND = 1000; // How long note lasts after keyUp
     
 }; // OneKeyboardKey
 
@@ -0,0 +1,137 @@
+/**
+ PackedVertices.cpp
+ Virtual Keyboard
+ Implementation of PackedVertices.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/28/2018
+ */
+
+#include "PackedVertices.hpp"
+#include "Shader.hpp"
+#include <glm/gtc/packing.hpp>
+#include <string.h>
+
+bool PackedVertices::m_useHalfPositions = false;
+
+//--------------------------------------------------------------------------
+/**
+ Packs a model. The OpenGL context must be current (to check
+ which formats the driver has).
+ 
+ @param positions The positions of the vertices.
+ @param normals The normals of the vertices (unit length).
+ @param indices The indices of the triangles.
+ */
+PackedVertices::PackedVertices(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals, const std::vector<unsigned int>& indices)
+{
+    m_numVertices = (unsigned int)positions.size();
+    m_numIndices = (unsigned int)indices.size();
+    m_hasHalfPositions = m_useHalfPositions;
+    m_hasPackedNormals = usesPackedNormals();
+    
+    // Half positions are padded to 8 bytes so the normal stays aligned
+    m_normalOffset = m_hasHalfPositions ? 4 * sizeof(GLushort) : 3 * sizeof(GLfloat);
+    m_vertexSize = m_normalOffset + sizeof(GLuint);
+    m_vertices.assign(m_numVertices * m_vertexSize, 0);
+    for(unsigned int i = 0; i < m_numVertices; i++)
+    {
+        unsigned char* vertex = &m_vertices[i * m_vertexSize];
+        if(m_hasHalfPositions)
+        {
+            GLushort half[4] = { glm::packHalf1x16(positions[i].x), glm::packHalf1x16(positions[i].y), glm::packHalf1x16(positions[i].z), glm::packHalf1x16(1.0f) };
+            memcpy(vertex, half, sizeof(half));
+        } // if
+        else
+            memcpy(vertex, &positions[i], 3 * sizeof(GLfloat));
+        glm::vec4 normal(normals[i], 0.0f);
+        GLuint packed = m_hasPackedNormals ? glm::packSnorm3x10_1x2(normal) : glm::packSnorm4x8(normal);
+        memcpy(vertex + m_normalOffset, &packed, sizeof(packed));
+    } // for
+    
+    // The smallest index type that holds the largest index
+    unsigned int maxIndex = 0;
+    for(unsigned int i = 0; i < m_numIndices; i++)
+        maxIndex = indices[i] > maxIndex ? indices[i] : maxIndex;
+    unsigned int indexSize;
+    if(maxIndex <= 0xFF)
+    {
+        m_indexType = GL_UNSIGNED_BYTE;
+        indexSize = sizeof(GLubyte);
+    } // if
+    else if(maxIndex <= 0xFFFF)
+    {
+        m_indexType = GL_UNSIGNED_SHORT;
+        indexSize = sizeof(GLushort);
+    } // else if
+    else
+    {
+        m_indexType = GL_UNSIGNED_INT;
+        indexSize = sizeof(GLuint);
+    } // else
+    m_indices.assign(m_numIndices * indexSize, 0);
+    for(unsigned int i = 0; i < m_numIndices; i++)
+    {
+        if(m_indexType == GL_UNSIGNED_BYTE)
+            m_indices[i] = (GLubyte)indices[i];
+        else if(m_indexType == GL_UNSIGNED_SHORT)
+        {
+            GLushort index = (GLushort)indices[i];
+            memcpy(&m_indices[i * indexSize], &index, indexSize);
+        } // else if
+        else
+            memcpy(&m_indices[i * indexSize], &indices[i], indexSize);
+    } // for
+} // PackedVertices::PackedVertices(const std::vector<glm::vec3>&, const std::vector<glm::vec3>&, const std::vector<unsigned int>&)
+
+//--------------------------------------------------------------------------
+/**
+ Puts the vertices and indices into buffers and points the
+ position and normal attributes at them. The vertex array they
+ belong to must be bound.
+ 
+ @param vertexBuffer The buffer for the interleaved vertices.
+ @param indexBuffer The buffer for the indices.
+ */
+void PackedVertices::upload(GLuint vertexBuffer, GLuint indexBuffer)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_vertices.size(), &m_vertices[0], GL_STATIC_DRAW);
+    
+    GLint posAttrib = Shader::POSITION_A;
+    glEnableVertexAttribArray(posAttrib);
+    glVertexAttribPointer(posAttrib, 3, m_hasHalfPositions ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE, m_vertexSize, 0);
+    
+    // Normalized, so the shader still sees a vec3 from -1 to 1
+    GLint normAttrib = Shader::NORMAL_A;
+    glEnableVertexAttribArray(normAttrib);
+    glVertexAttribPointer(normAttrib, 4, m_hasPackedNormals ? GL_INT_2_10_10_10_REV : GL_BYTE, GL_TRUE, m_vertexSize, (void*)(size_t)m_normalOffset);
+    
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size(), &m_indices[0], GL_STATIC_DRAW);
+} // PackedVertices::upload(GLuint, GLuint)
+
+//--------------------------------------------------------------------------
+/**
+ Sets whether models packed from now on have half float
+ positions (8 bytes instead of 12, precise to about 0.008 at
+ the far end of a key).
+ 
+ @param useHalf True for half float positions.
+ */
+void PackedVertices::useHalfPositions(bool useHalf)
+{
+    m_useHalfPositions = useHalf;
+} // PackedVertices::useHalfPositions(bool)
+
+//--------------------------------------------------------------------------
+/**
+ Checks if normals can be packed as GL_INT_2_10_10_10_REV
+ (core in OpenGL 3.3, and an extension before that).
+ 
+ @return True if the driver reads that format.
+ */
+bool PackedVertices::usesPackedNormals()
+{
+    return GLEW_VERSION_3_3 || GLEW_ARB_vertex_type_2_10_10_10_rev;
+} // PackedVertices::usesPackedNormals()
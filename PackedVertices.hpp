@@ -0,0 +1,68 @@
+/**
+ PackedVertices.hpp
+ Virtual Keyboard
+ Class which packs the positions, normals, and indices of a
+ model into as few bytes as will draw it the same: positions
+ and normals are interleaved in one buffer (so each vertex is
+ fetched from one place), normals are packed into 32 bits
+ (GL_INT_2_10_10_10_REV, or four signed bytes if the driver
+ does not have it), positions can be half floats, and indices
+ are 8, 16 or 32 bits depending on the largest one.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/28/2018
+ */
+
+#ifndef PackedVertices_hpp
+#define PackedVertices_hpp
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <vector>
+
+class PackedVertices
+{
+public:
+    PackedVertices(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals, const std::vector<unsigned int>& indices);
+    
+    void upload(GLuint vertexBuffer, GLuint indexBuffer);
+    static void useHalfPositions(bool useHalf);
+    
+    /**
+     Gets the type of the indices (GL_UNSIGNED_BYTE, _SHORT or _INT).
+     */
+    inline GLenum getIndexType() { return m_indexType; }
+    /**
+     Gets how many bytes are fetched for each vertex.
+     */
+    inline unsigned int getVertexSize() { return m_vertexSize; }
+    /**
+     Gets how many bytes of vertices and indices are uploaded.
+     */
+    inline unsigned int getNumBytes() { return (unsigned int)(m_vertices.size() + m_indices.size()); }
+    /**
+     Gets how many bytes the same model takes with float positions
+     and normals in separate buffers and 32-bit indices.
+     */
+    inline unsigned int getNumUnpackedBytes() { return m_numVertices * UNPACKED_VERTEX_SIZE + m_numIndices * sizeof(GLuint); }
+    
+    static const unsigned int UNPACKED_VERTEX_SIZE = 2 * sizeof(glm::vec3); // Float position and normal
+private:
+    static bool usesPackedNormals();
+    
+    std::vector<unsigned char> m_vertices; // Interleaved
+    std::vector<unsigned char> m_indices;
+    unsigned int m_numVertices;
+    unsigned int m_numIndices;
+    unsigned int m_vertexSize; // Stride between vertices in bytes
+    unsigned int m_normalOffset; // Where the normal is in a vertex
+    bool m_hasHalfPositions;
+    bool m_hasPackedNormals; // False if the normals are four signed bytes
+    GLenum m_indexType;
+    
+    static bool m_useHalfPositions; // Setting for models packed from now on
+}; // PackedVertices
+
+#endif /* PackedVertices_hpp */
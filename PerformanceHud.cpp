@@ -0,0 +1,441 @@
+/**
+ PerformanceHud.cpp
+ Virtual Keyboard
+ Implementation of PerformanceHud.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/23/2018
+ */
+
+#include "PerformanceHud.hpp"
+#include <SDL2_mixer/SDL_mixer.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <ctype.h>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+// One glyph of the font: '#' is lit, '.' is not
+struct Glyph
+{
+    char character;
+    const char* rows[5];
+}; // Glyph
+
+// The font (upper case only, since lower case is drawn as upper case)
+static const Glyph GLYPHS[] =
+{
+    { ' ', { "...", "...", "...", "...", "..." } },
+    { '0', { "###", "#.#", "#.#", "#.#", "###" } },
+    { '1', { ".#.", "##.", ".#.", ".#.", "###" } },
+    { '2', { "###", "..#", "###", "#..", "###" } },
+    { '3', { "###", "..#", ".##", "..#", "###" } },
+    { '4', { "#.#", "#.#", "###", "..#", "..#" } },
+    { '5', { "###", "#..", "###", "..#", "###" } },
+    { '6', { "###", "#..", "###", "#.#", "###" } },
+    { '7', { "###", "..#", ".#.", ".#.", ".#." } },
+    { '8', { "###", "#.#", "###", "#.#", "###" } },
+    { '9', { "###", "#.#", "###", "..#", "###" } },
+    { '.', { "...", "...", "...", "...", ".#." } },
+    { ':', { "...", ".#.", "...", ".#.", "..." } },
+    { '%', { "#.#", "..#", ".#.", "#..", "#.#" } },
+    { '/', { "..#", "..#", ".#.", "#..", "#.." } },
+    { '-', { "...", "...", "###", "...", "..." } },
+    { '(', { ".#.", "#..", "#..", "#..", ".#." } },
+    { ')', { ".#.", "..#", "..#", "..#", ".#." } },
+    { 'A', { ".#.", "#.#", "###", "#.#", "#.#" } },
+    { 'B', { "##.", "#.#", "##.", "#.#", "##." } },
+    { 'C', { ".##", "#..", "#..", "#..", ".##" } },
+    { 'D', { "##.", "#.#", "#.#", "#.#", "##." } },
+    { 'E', { "###", "#..", "##.", "#..", "###" } },
+    { 'F', { "###", "#..", "##.", "#..", "#.." } },
+    { 'G', { ".##", "#..", "#.#", "#.#", ".##" } },
+    { 'H', { "#.#", "#.#", "###", "#.#", "#.#" } },
+    { 'I', { "###", ".#.", ".#.", ".#.", "###" } },
+    { 'J', { "..#", "..#", "..#", "#.#", ".#." } },
+    { 'K', { "#.#", "#.#", "##.", "#.#", "#.#" } },
+    { 'L', { "#..", "#..", "#..", "#..", "###" } },
+    { 'M', { "#.#", "###", "###", "#.#", "#.#" } },
+    { 'N', { "##.", "#.#", "#.#", "#.#", "#.#" } },
+    { 'O', { ".#.", "#.#", "#.#", "#.#", ".#." } },
+    { 'P', { "##.", "#.#", "##.", "#..", "#.." } },
+    { 'Q', { ".#.", "#.#", "#.#", "##.", ".##" } },
+    { 'R', { "##.", "#.#", "##.", "#.#", "#.#" } },
+    { 'S', { ".##", "#..", ".#.", "..#", "##." } },
+    { 'T', { "###", ".#.", ".#.", ".#.", ".#." } },
+    { 'U', { "#.#", "#.#", "#.#", "#.#", "###" } },
+    { 'V', { "#.#", "#.#", "#.#", "#.#", ".#." } },
+    { 'W', { "#.#", "#.#", "###", "###", "#.#" } },
+    { 'X', { "#.#", "#.#", ".#.", "#.#", "#.#" } },
+    { 'Y', { "#.#", "#.#", ".#.", ".#.", ".#." } },
+    { 'Z', { "###", "..#", ".#.", "#..", "###" } },
+};
+static const int NUM_GLYPHS = sizeof(GLYPHS) / sizeof(GLYPHS[0]);
+
+//--------------------------------------------------------------------------
+/**
+ Creates a hidden overlay: its shader, its glyph atlas, and
+ its vertex buffer. The OpenGL context must be current.
+ 
+ @param shaderFileName The full path of the overlay's shaders
+ WITHOUT their extension.
+ @param renderState The state tracker to draw through (its
+ draw calls are shown).
+ @param cache A cache of linked programs (or NULL).
+ */
+PerformanceHud::PerformanceHud(const std::string& shaderFileName, RenderState* renderState, ProgramCache* cache)
+{
+    m_renderState = renderState;
+    m_shader = new Shader(shaderFileName, renderState, "", cache);
+    m_isVisible = false;
+    m_numFrames = 0;
+    m_memoryMb = 0.0f;
+    m_pixelSize = glm::vec2(0.0f, 0.0f);
+    
+    makeAtlas();
+    
+    // Interleaved position, texture coordinates, and colour
+    glGenVertexArrays(1, &m_vertexArrayObject);
+    renderState->bindVertexArray(m_vertexArrayObject);
+    glGenBuffers(1, &m_vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glEnableVertexAttribArray(Shader::POSITION_A);
+    glVertexAttribPointer(Shader::POSITION_A, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void*)offsetof(HudVertex, position));
+    glEnableVertexAttribArray(Shader::TEX_COORD_A);
+    glVertexAttribPointer(Shader::TEX_COORD_A, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void*)offsetof(HudVertex, texCoord));
+    glEnableVertexAttribArray(Shader::COLOR_A);
+    glVertexAttribPointer(Shader::COLOR_A, 4, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void*)offsetof(HudVertex, color));
+    renderState->bindVertexArray(0);
+} // PerformanceHud::PerformanceHud(const std::string&, RenderState*, ProgramCache*)
+
+//--------------------------------------------------------------------------
+/**
+ Destroys the overlay (and stops measuring the audio thread).
+ */
+PerformanceHud::~PerformanceHud()
+{
+    setVisible(false);
+    glDeleteBuffers(1, &m_vertexBuffer);
+    glDeleteVertexArrays(1, &m_vertexArrayObject);
+    glDeleteTextures(1, &m_atlas);
+    delete m_shader;
+} // PerformanceHud::~PerformanceHud()
+
+//--------------------------------------------------------------------------
+/**
+ Puts every glyph of the font side by side in a one-channel
+ texture. The first cell is solid, so that graphs and the
+ panel can be drawn from the same texture as the text.
+ */
+void PerformanceHud::makeAtlas()
+{
+    for(int i = 0; i < 128; i++)
+        m_glyphCells[i] = -1;
+    
+    int numCells = NUM_GLYPHS + 1;
+    m_atlasWidth = numCells * CELL_WIDTH;
+    std::vector<unsigned char> pixels(m_atlasWidth * GLYPH_HEIGHT, 0);
+    for(int y = 0; y < GLYPH_HEIGHT; y++)
+    {
+        for(int x = 0; x < CELL_WIDTH; x++)
+            pixels[y * m_atlasWidth + SOLID_GLYPH * CELL_WIDTH + x] = 255;
+    } // for
+    for(int i = 0; i < NUM_GLYPHS; i++)
+    {
+        int cell = i + 1;
+        m_glyphCells[(int)GLYPHS[i].character] = cell;
+        for(int y = 0; y < GLYPH_HEIGHT; y++)
+        {
+            for(int x = 0; x < GLYPH_WIDTH; x++)
+            {
+                if(GLYPHS[i].rows[y][x] == '#')
+                    pixels[y * m_atlasWidth + cell * CELL_WIDTH + x] = 255;
+            } // for
+        } // for
+    } // for
+    
+    glGenTextures(1, &m_atlas);
+    glBindTexture(GL_TEXTURE_2D, m_atlas);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, m_atlasWidth, GLYPH_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, &pixels[0]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+} // PerformanceHud::makeAtlas()
+
+//--------------------------------------------------------------------------
+/**
+ Shows or hides the overlay. The audio thread is only timed
+ while the overlay is shown.
+ 
+ @param visible True to show the overlay.
+ */
+void PerformanceHud::setVisible(bool visible)
+{
+    if(visible == m_isVisible)
+        return;
+    m_isVisible = visible;
+    
+    // SDL_mixer mixes the music hook before the channels, and the
+    // post-mix callback after them, so the time between the two
+    // is how long mixing took
+    if(visible)
+    {
+        Mix_HookMusic(beginAudio, this);
+        Mix_SetPostMix(endAudio, this);
+    } // if
+    else
+    {
+        Mix_HookMusic(NULL, NULL);
+        Mix_SetPostMix(NULL, NULL);
+    } // else
+} // PerformanceHud::setVisible(bool)
+
+//--------------------------------------------------------------------------
+/**
+ Called on the audio thread before the channels are mixed.
+ The keyboard plays no music, so nothing is added to the stream.
+ 
+ @param hud The overlay.
+ */
+void PerformanceHud::beginAudio(void* hud, Uint8*, int)
+{
+    ((PerformanceHud*)hud)->m_audioStart = std::chrono::steady_clock::now();
+} // PerformanceHud::beginAudio(void*, Uint8*, int)
+
+//--------------------------------------------------------------------------
+/**
+ Called on the audio thread after the channels are mixed.
+ Records how much of the time the stream lasts was spent
+ mixing it.
+ 
+ @param hud The overlay.
+ @param length Bytes in the stream.
+ */
+void PerformanceHud::endAudio(void* hud, Uint8*, int length)
+{
+    PerformanceHud* self = (PerformanceHud*)hud;
+    float mixMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - self->m_audioStart).count();
+    
+    int frequency;
+    Uint16 format;
+    int channels;
+    if(!Mix_QuerySpec(&frequency, &format, &channels))
+        return;
+    float streamMs = 1000.0f * length / (SDL_AUDIO_BITSIZE(format) / 8 * channels) / frequency;
+    self->m_rings[AUDIO_LOAD_R].push(100.0f * mixMs / streamMs);
+} // PerformanceHud::endAudio(void*, Uint8*, int)
+
+//--------------------------------------------------------------------------
+/**
+ Gets how much memory the process is using.
+ 
+ @return Resident memory in megabytes (0 if it cannot be found).
+ */
+float PerformanceHud::getMemoryInUse()
+{
+#if defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+        return 0.0f;
+    return info.resident_size / (1024.0f * 1024.0f);
+#elif defined(__linux__)
+    FILE* file = fopen("/proc/self/statm", "r");
+    if(!file)
+        return 0.0f;
+    unsigned long totalPages = 0;
+    unsigned long residentPages = 0;
+    if(fscanf(file, "%lu %lu", &totalPages, &residentPages) != 2)
+        residentPages = 0;
+    fclose(file);
+    return residentPages * (float)sysconf(_SC_PAGESIZE) / (1024.0f * 1024.0f);
+#else
+    return 0.0f;
+#endif
+} // PerformanceHud::getMemoryInUse()
+
+//--------------------------------------------------------------------------
+/**
+ Records this frame's values and draws the overlay over
+ whatever was drawn so far, in one draw call. Does nothing
+ while the overlay is hidden.
+ 
+ @param frameTimer The timer with the latest frame times.
+ */
+void PerformanceHud::draw(FrameTimer* frameTimer)
+{
+    if(!m_isVisible)
+        return;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    
+    // Values from the render thread
+    if(m_numFrames++ % MEMORY_FRAMES == 0)
+        m_memoryMb = getMemoryInUse();
+    m_rings[FRAME_R].push(frameTimer->getLatest(FrameTimer::CPU_FRAME_M));
+    m_rings[GPU_R].push(frameTimer->getLatest(FrameTimer::GPU_FRAME_M));
+    m_rings[DRAW_CALLS_R].push((float)m_renderState->getNumDrawCalls());
+    m_rings[VOICES_R].push((float)Mix_Playing(-1));
+    m_rings[MEMORY_R].push(m_memoryMb);
+    
+    // Build the text and graphs, in pixels of the viewport
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    m_pixelSize = glm::vec2(2.0f / viewport[2], 2.0f / viewport[3]);
+    m_vertices.clear();
+    const char* FORMATS[NUM_ROWS] = { "FRAME  %6.2f MS", "GPU    %6.2f MS", "DRAWS  %6.0f", "VOICES %6.0f",
+                                      "AUDIO  %6.1f %%", "MEMORY %6.1f MB", "HUD    %6.3f MS" };
+    const glm::vec4 PANEL_COLOR(0.0f, 0.0f, 0.0f, 0.6f);
+    const glm::vec4 TEXT_COLOR(1.0f, 1.0f, 1.0f, 1.0f);
+    const glm::vec4 GRAPH_COLOR(0.3f, 0.9f, 0.4f, 0.9f);
+    float graphX = MARGIN + LABEL_COLUMNS * CELL_WIDTH * GLYPH_SCALE;
+    addSolid(MARGIN / 2, MARGIN / 2, graphX + GRAPH_VALUES * GRAPH_BAR_WIDTH + MARGIN / 2, MARGIN + NUM_ROWS * ROW_HEIGHT, PANEL_COLOR);
+    for(int i = 0; i < NUM_ROWS; i++)
+    {
+        char text[32];
+        snprintf(text, sizeof(text), FORMATS[i], m_rings[i].getLatest());
+        float y = MARGIN + i * ROW_HEIGHT;
+        addText(text, MARGIN, y, TEXT_COLOR);
+        addGraph(m_rings[i], graphX, y, GRAPH_COLOR);
+    } // for
+    
+    // Draw everything at once, on top of the scene
+    m_shader->use();
+    m_renderState->bindVertexArray(m_vertexArrayObject);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_atlas);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(HudVertex), NULL, GL_STREAM_DRAW); // Orphan last frame's vertices
+    glBufferSubData(GL_ARRAY_BUFFER, 0, m_vertices.size() * sizeof(HudVertex), &m_vertices[0]);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)m_vertices.size());
+    glDisable(GL_BLEND);
+    glEnable(GL_CULL_FACE);
+    glEnable(GL_DEPTH_TEST);
+    
+    m_rings[HUD_R].push(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+} // PerformanceHud::draw(FrameTimer*)
+
+//--------------------------------------------------------------------------
+/**
+ Adds a rectangle (two triangles) to the vertices.
+ 
+ @param x0 Left edge in pixels.
+ @param y0 Top edge in pixels.
+ @param x1 Right edge in pixels.
+ @param y1 Bottom edge in pixels.
+ @param u0 Left edge in the atlas.
+ @param v0 Top edge in the atlas.
+ @param u1 Right edge in the atlas.
+ @param v1 Bottom edge in the atlas.
+ @param color Colour (and opacity) of the rectangle.
+ */
+void PerformanceHud::addQuad(float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, const glm::vec4& color)
+{
+    // Pixels start at the top left; normalized device coordinates at the bottom left
+    float left = x0 * m_pixelSize.x - 1.0f;
+    float right = x1 * m_pixelSize.x - 1.0f;
+    float top = 1.0f - y0 * m_pixelSize.y;
+    float bottom = 1.0f - y1 * m_pixelSize.y;
+    
+    HudVertex corners[4] =
+    {
+        { glm::vec2(left, top), glm::vec2(u0, v0), color },
+        { glm::vec2(left, bottom), glm::vec2(u0, v1), color },
+        { glm::vec2(right, bottom), glm::vec2(u1, v1), color },
+        { glm::vec2(right, top), glm::vec2(u1, v0), color }
+    };
+    const int ORDER[6] = { 0, 1, 2, 0, 2, 3 };
+    for(int i = 0; i < 6; i++)
+        m_vertices.push_back(corners[ORDER[i]]);
+} // PerformanceHud::addQuad(float, float, float, float, float, float, float, float, const glm::vec4&)
+
+//--------------------------------------------------------------------------
+/**
+ Adds a rectangle of one colour (from the solid cell of the atlas).
+ 
+ @param x0 Left edge in pixels.
+ @param y0 Top edge in pixels.
+ @param x1 Right edge in pixels.
+ @param y1 Bottom edge in pixels.
+ @param color Colour (and opacity) of the rectangle.
+ */
+void PerformanceHud::addSolid(float x0, float y0, float x1, float y1, const glm::vec4& color)
+{
+    // The middle of the solid cell, away from its edges
+    float u = (SOLID_GLYPH * CELL_WIDTH + 0.5f * CELL_WIDTH) / m_atlasWidth;
+    float v = 0.5f;
+    addQuad(x0, y0, x1, y1, u, v, u, v, color);
+} // PerformanceHud::addSolid(float, float, float, float, const glm::vec4&)
+
+//--------------------------------------------------------------------------
+/**
+ Adds a line of text. Lower case letters are drawn as upper
+ case, and characters without a glyph are left blank.
+ 
+ @param text The text.
+ @param x Left edge of the text in pixels.
+ @param y Top edge of the text in pixels.
+ @param color Colour of the text.
+ */
+void PerformanceHud::addText(const std::string& text, float x, float y, const glm::vec4& color)
+{
+    const float WIDTH = GLYPH_WIDTH * GLYPH_SCALE;
+    const float HEIGHT = GLYPH_HEIGHT * GLYPH_SCALE;
+    for(unsigned int i = 0; i < text.size(); i++)
+    {
+        int character = toupper((unsigned char)text[i]);
+        int cell = (character < 128) ? m_glyphCells[character] : -1;
+        if(cell > 0 && character != ' ')
+        {
+            float u0 = (float)(cell * CELL_WIDTH) / m_atlasWidth;
+            float u1 = (float)(cell * CELL_WIDTH + GLYPH_WIDTH) / m_atlasWidth;
+            addQuad(x, y, x + WIDTH, y + HEIGHT, u0, 0.0f, u1, 1.0f, color);
+        } // if
+        x += CELL_WIDTH * GLYPH_SCALE;
+    } // for
+} // PerformanceHud::addText(const std::string&, float, float, const glm::vec4&)
+
+//--------------------------------------------------------------------------
+/**
+ Adds a bar graph of a ring's latest values, scaled so the
+ largest value fills the height of a row of text.
+ 
+ @param ring The values to graph.
+ @param x Left edge of the graph in pixels.
+ @param y Top edge of the graph in pixels.
+ @param color Colour of the bars.
+ */
+void PerformanceHud::addGraph(MetricRing& ring, float x, float y, const glm::vec4& color)
+{
+    float values[GRAPH_VALUES];
+    unsigned int count = ring.read(values, GRAPH_VALUES);
+    float largest = 0.0f;
+    for(unsigned int i = 0; i < count; i++)
+    {
+        if(values[i] > largest)
+            largest = values[i];
+    } // for
+    if(largest <= 0.0f)
+        return;
+    
+    // Newest values on the right
+    const float HEIGHT = GLYPH_HEIGHT * GLYPH_SCALE;
+    float barX = x + (GRAPH_VALUES - count) * GRAPH_BAR_WIDTH;
+    for(unsigned int i = 0; i < count; i++)
+    {
+        float barHeight = HEIGHT * values[i] / largest;
+        addSolid(barX, y + HEIGHT - barHeight, barX + GRAPH_BAR_WIDTH, y + HEIGHT, color);
+        barX += GRAPH_BAR_WIDTH;
+    } // for
+} // PerformanceHud::addGraph(MetricRing&, float, float, const glm::vec4&)
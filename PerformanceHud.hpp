@@ -0,0 +1,116 @@
+/**
+ PerformanceHud.hpp
+ Virtual Keyboard
+ Class for an overlay which shows the frame time, GPU time,
+ draw calls, voices playing, audio callback load, memory in
+ use, and its own cost, each with a small graph of its recent
+ values. The render thread and the audio thread feed the
+ values into lock-free rings, and all of the text (from a glyph
+ atlas made once at startup) and graphs are drawn with one call.
+ While it is hidden, nothing is measured or drawn.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/23/2018
+ */
+
+#ifndef PerformanceHud_hpp
+#define PerformanceHud_hpp
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "Shader.hpp"
+#include "RenderState.hpp"
+#include "ProgramCache.hpp"
+#include "FrameTimer.hpp"
+#include "MetricRing.hpp"
+
+class PerformanceHud
+{
+public:
+    PerformanceHud(const std::string& shaderFileName, RenderState* renderState, ProgramCache* cache = NULL);
+    virtual ~PerformanceHud();
+    
+    void setVisible(bool visible);
+    void draw(FrameTimer* frameTimer);
+    static float getMemoryInUse();
+    
+    /**
+     Gets whether the overlay is shown.
+     */
+    inline bool isVisible() { return m_isVisible; }
+private:
+    // The rows of the overlay (each has its own ring of values)
+    enum
+    {
+        FRAME_R,
+        GPU_R,
+        DRAW_CALLS_R,
+        VOICES_R,
+        AUDIO_LOAD_R,
+        MEMORY_R,
+        HUD_R,
+        
+        NUM_ROWS
+    };
+    
+    // One corner of a quad in the vertex buffer
+    struct HudVertex
+    {
+        glm::vec2 position; // Normalized device coordinates
+        glm::vec2 texCoord;
+        glm::vec4 color;
+    }; // HudVertex
+    
+    void makeAtlas();
+    void addQuad(float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, const glm::vec4& color);
+    void addSolid(float x0, float y0, float x1, float y1, const glm::vec4& color);
+    void addText(const std::string& text, float x, float y, const glm::vec4& color);
+    void addGraph(MetricRing& ring, float x, float y, const glm::vec4& color);
+    
+    static void beginAudio(void* hud, Uint8* stream, int length);
+    static void endAudio(void* hud, Uint8* stream, int length);
+    
+    // Size of the glyphs in the atlas, and how big they are drawn
+    static const int GLYPH_WIDTH = 3;
+    static const int GLYPH_HEIGHT = 5;
+    static const int CELL_WIDTH = GLYPH_WIDTH + 1; // Space between glyphs in the atlas
+    static const int GLYPH_SCALE = 3; // Screen pixels per atlas pixel
+    static const int SOLID_GLYPH = 0; // Cell which is all white (for graphs and the panel)
+    
+    // Layout of the overlay in pixels
+    static const int MARGIN = 10;
+    static const int ROW_HEIGHT = (GLYPH_HEIGHT + 2) * GLYPH_SCALE;
+    static const int LABEL_COLUMNS = 17; // Characters before the graphs
+    static const int GRAPH_VALUES = 64;
+    static const int GRAPH_BAR_WIDTH = 2;
+    static const int MEMORY_FRAMES = 30; // Frames between checks of the memory in use
+    
+    Shader* m_shader;
+    RenderState* m_renderState;
+    GLuint m_vertexArrayObject;
+    GLuint m_vertexBuffer;
+    GLuint m_atlas;
+    int m_atlasWidth;
+    int m_glyphCells[128]; // Atlas cell of each ASCII character (-1 if none)
+    
+    std::vector<HudVertex> m_vertices; // Rebuilt every frame
+    glm::vec2 m_pixelSize; // Size of one pixel in normalized device coordinates
+    
+    bool m_isVisible;
+    unsigned int m_numFrames;
+    float m_memoryMb;
+    
+    // Written by the render thread, except AUDIO_LOAD_R (the audio thread)
+    MetricRing m_rings[NUM_ROWS];
+    
+    // Only used on the audio thread
+    std::chrono::steady_clock::time_point m_audioStart;
+}; // PerformanceHud
+
+#endif /* PerformanceHud_hpp */
@@ -0,0 +1,198 @@
+/**
+ ProgramCache.cpp
+ Virtual Keyboard
+ Implementation of ProgramCache.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/18/2018
+ */
+
+#include "ProgramCache.hpp"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <stdio.h>
+#include <sys/stat.h>
+
+//--------------------------------------------------------------------------
+/**
+ Creates a cache which saves programs in a folder (which is
+ made if it does not exist). An OpenGL context must already
+ exist, since the driver is part of every key.
+ 
+ @param folder The path of the folder WITHOUT a final slash.
+ */
+ProgramCache::ProgramCache(const std::string& folder)
+{
+    m_folder = folder;
+    m_numHits = 0;
+    m_numMisses = 0;
+    m_msSaved = 0.0f;
+    
+    // Program binaries need OpenGL 4.1 (or the ARB extension)
+    // and at least one binary format from the driver
+    GLint numFormats = 0;
+    if(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    m_isEnabled = (numFormats > 0);
+    if(m_isEnabled)
+        mkdir(m_folder.c_str(), 0755); // Fails harmlessly if it is already there
+    
+    // A program saved by one driver is useless to another
+    const GLubyte* strings[3] = { glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION) };
+    for(unsigned int i = 0; i < 3; i++)
+    {
+        if(strings[i])
+            m_driver.append((const char*)strings[i]);
+        m_driver.push_back('\n');
+    } // for
+} // ProgramCache::ProgramCache(const std::string&)
+
+//--------------------------------------------------------------------------
+/**
+ Makes the key of a program by hashing (64-bit FNV-1a) the
+ text of its shaders and the driver it is compiled by.
+ 
+ @param vertexShaderText The full text of the vertex shader
+ (with its defines).
+ @param fragmentShaderText The full text of the fragment
+ shader (with its defines).
+ @return The key of the program.
+ */
+uint64_t ProgramCache::makeKey(const std::string& vertexShaderText, const std::string& fragmentShaderText)
+{
+    const std::string* parts[3] = { &vertexShaderText, &fragmentShaderText, &m_driver };
+    uint64_t hash = 14695981039346656037ull;
+    for(unsigned int i = 0; i < 3; i++)
+    {
+        for(std::string::size_type j = 0; j < parts[i]->size(); j++)
+            hash = (hash ^ (unsigned char)(*parts[i])[j]) * 1099511628211ull;
+        hash = (hash ^ 0xFF) * 1099511628211ull; // Separates the parts
+    } // for
+    return hash;
+} // ProgramCache::makeKey(const std::string&, const std::string&)
+
+//--------------------------------------------------------------------------
+/**
+ Tries to load a program from the cache. If the file is not
+ there, is damaged, or the driver rejects it, the program is
+ left to be compiled as usual.
+ 
+ @param program The OpenGL reference to an empty program.
+ @param key The key of the program from makeKey().
+ @return True if the program was loaded and linked.
+ */
+bool ProgramCache::load(GLuint program, uint64_t key)
+{
+    if(!m_isEnabled)
+        return false;
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    
+    std::ifstream file(getPath(key).c_str(), std::ios::binary);
+    Header header;
+    if(!file.is_open() || !file.read((char*)&header, sizeof(header)) ||
+       header.magic != MAGIC || header.version != VERSION || header.key != key)
+    {
+        m_numMisses++;
+        return false;
+    } // if
+    
+    // The length comes from the file, so check it against what is left
+    // of the file before allocating (a damaged one could ask for gigabytes)
+    std::streampos binaryStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff bytesLeft = file.tellg() - binaryStart;
+    file.seekg(binaryStart);
+    if(header.length == 0 || binaryStart < 0 || (std::streamoff)header.length > bytesLeft)
+    {
+        m_numMisses++;
+        return false;
+    } // if
+    
+    std::vector<char> binary(header.length);
+    if(!file.read(&binary[0], header.length))
+    {
+        m_numMisses++;
+        return false;
+    } // if
+    
+    glProgramBinary(program, header.format, &binary[0], (GLsizei)header.length);
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if(status != GL_TRUE)
+    {
+        m_numMisses++;
+        return false;
+    } // if
+    
+    float loadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if(header.compileMs > loadMs)
+        m_msSaved += header.compileMs - loadMs;
+    m_numHits++;
+    return true;
+} // ProgramCache::load(GLuint, uint64_t)
+
+//--------------------------------------------------------------------------
+/**
+ Saves a linked program to the cache. The program must have
+ been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+ 
+ @param program The OpenGL reference to the linked program.
+ @param key The key of the program from makeKey().
+ @param compileMs How long compiling and linking the program
+ took (to work out the time saved by loading it later).
+ */
+void ProgramCache::store(GLuint program, uint64_t key, float compileMs)
+{
+    if(!m_isEnabled)
+        return;
+    
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0)
+        return;
+    
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, &binary[0]);
+    
+    Header header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.key = key;
+    header.format = format;
+    header.length = (uint32_t)length;
+    header.compileMs = compileMs;
+    
+    // Write to a temporary file first so that a half-written
+    // file is never loaded
+    std::string path = getPath(key);
+    std::string tempPath = path + ".tmp";
+    std::ofstream file(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+    if(!file.is_open())
+    {
+        std::cerr << "Unable to save shader program to: " << tempPath << std::endl;
+        return;
+    } // if
+    file.write((const char*)&header, sizeof(header));
+    file.write(&binary[0], length);
+    file.close();
+    if(file.fail() || rename(tempPath.c_str(), path.c_str()) != 0)
+        remove(tempPath.c_str());
+} // ProgramCache::store(GLuint, uint64_t, float)
+
+//--------------------------------------------------------------------------
+/**
+ Gets the path of the file that a program is saved in.
+ 
+ @param key The key of the program.
+ @return The full path of the file.
+ */
+std::string ProgramCache::getPath(uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)key);
+    return m_folder + name;
+} // ProgramCache::getPath(uint64_t)
@@ -0,0 +1,77 @@
+/**
+ ProgramCache.hpp
+ Virtual Keyboard
+ Class which saves linked shader programs to disk (with
+ glGetProgramBinary) and loads them back on the next launch,
+ so that shaders do not have to be compiled and linked every
+ time the program starts. Each program is keyed by a hash of
+ its source text (including the defines) and the driver, so a
+ changed shader or a new driver just misses the cache.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/18/2018
+ */
+
+#ifndef ProgramCache_hpp
+#define ProgramCache_hpp
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <string>
+#include <stdint.h>
+
+class ProgramCache
+{
+public:
+    ProgramCache(const std::string& folder);
+    
+    uint64_t makeKey(const std::string& vertexShaderText, const std::string& fragmentShaderText);
+    bool load(GLuint program, uint64_t key);
+    void store(GLuint program, uint64_t key, float compileMs);
+    
+    /**
+     Gets whether the driver can save and load programs (if not,
+     every shader is compiled as usual).
+     */
+    inline bool isEnabled() { return m_isEnabled; }
+    /**
+     Gets how many programs were loaded from the cache.
+     */
+    inline unsigned int getNumHits() { return m_numHits; }
+    /**
+     Gets how many programs had to be compiled.
+     */
+    inline unsigned int getNumMisses() { return m_numMisses; }
+    /**
+     Gets roughly how many milliseconds loading from the cache
+     saved, compared to compiling the same programs.
+     */
+    inline float getMsSaved() { return m_msSaved; }
+private:
+    // What goes at the start of each file in the cache
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t format; // Binary format from the driver
+        uint32_t length; // Bytes of binary after the header
+        float compileMs; // How long compiling the program took
+    }; // Header
+    
+    std::string getPath(uint64_t key);
+    
+    static const uint32_t MAGIC = 0x564B5043; // "VKPC"
+    static const uint32_t VERSION = 1; // Changes when the header changes
+    
+    std::string m_folder; // Where the programs are saved
+    std::string m_driver; // Vendor, renderer, and version of OpenGL
+    bool m_isEnabled;
+    
+    unsigned int m_numHits;
+    unsigned int m_numMisses;
+    float m_msSaved;
+}; // ProgramCache
+
+#endif /* ProgramCache_hpp */
@@ -0,0 +1,117 @@
+/**
+ RenderQueue.cpp
+ Virtual Keyboard
+ Implementation of RenderQueue.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/16/2018
+ */
+
+#include "RenderQueue.hpp"
+
+//--------------------------------------------------------------------------
+/**
+ Creates an empty render queue.
+ 
+ @param renderState The state tracker the meshes' shaders
+ use, which counts the state changes that were avoided.
+ */
+RenderQueue::RenderQueue(RenderState* renderState)
+{
+    m_renderState = renderState;
+    m_numStateChanges = 0;
+    m_numStateChangesAvoided = 0;
+} // RenderQueue::RenderQueue(RenderState*)
+
+//--------------------------------------------------------------------------
+/**
+ Adds a mesh to be drawn in the next flush(). Its sort key is
+ made up of (from most to least significant) its program, its
+ vertex array, its material, and its depth, so that the most
+ expensive state changes happen the fewest times, and meshes
+ with the same state are drawn front to back.
+ 
+ @param mesh The mesh to draw.
+ @param depth How far the mesh is from the camera, from 0 (at
+ the camera) to 1 (at the far plane).
+ @param offset How far from its transform to draw the mesh (so
+ the same mesh can be submitted more than once).
+ */
+void RenderQueue::submit(Mesh* mesh, float depth, const glm::vec3& offset)
+{
+    if(depth < 0.0f)
+        depth = 0.0f;
+    if(depth > 1.0f)
+        depth = 1.0f;
+    
+    uint64_t program = mesh->getShader()->getShaderProgram() & ((1 << PROGRAM_BITS) - 1);
+    uint64_t vertexArray = mesh->getVertexArrayObject() & ((1 << VERTEX_ARRAY_BITS) - 1);
+    uint64_t material = mesh->getMaterialKey() & ((1 << MATERIAL_BITS) - 1);
+    uint64_t quantizedDepth = (uint64_t)(depth * (float)((1 << DEPTH_BITS) - 1));
+    
+    DrawPacket packet;
+    packet.sortKey = (program << (VERTEX_ARRAY_BITS + MATERIAL_BITS + DEPTH_BITS))
+                   | (vertexArray << (MATERIAL_BITS + DEPTH_BITS))
+                   | (material << DEPTH_BITS)
+                   | quantizedDepth;
+    packet.mesh = mesh;
+    packet.offset = offset;
+    m_packets.push_back(packet);
+} // RenderQueue::submit(Mesh*, float, const glm::vec3&)
+
+//--------------------------------------------------------------------------
+/**
+ Sorts and draws all the meshes submitted since the last
+ flush, and then empties the queue.
+ 
+ @param camera The camera to use when drawing the meshes.
+ */
+void RenderQueue::flush(Camera* camera)
+{
+    sort();
+    
+    m_renderState->resetCounters();
+    for(unsigned int i = 0; i < m_packets.size(); i++)
+        m_packets[i].mesh->draw(camera, m_packets[i].offset);
+    m_numStateChanges = m_renderState->getNumStateChanges();
+    m_numStateChangesAvoided = m_renderState->getNumStateChangesAvoided();
+    
+    m_packets.clear();
+} // RenderQueue::flush(Camera*)
+
+//--------------------------------------------------------------------------
+/**
+ Sorts the packets by their sort keys with a least significant
+ digit radix sort, 8 bits per pass. Passes where every packet
+ has the same digit are skipped (which is most of them, since
+ most draws share a program).
+ */
+void RenderQueue::sort()
+{
+    const int NUM_BUCKETS = 1 << RADIX_BITS;
+    m_sortBuffer.resize(m_packets.size());
+    
+    for(int shift = 0; shift < 64; shift += RADIX_BITS)
+    {
+        unsigned int counts[NUM_BUCKETS] = { 0 };
+        for(unsigned int i = 0; i < m_packets.size(); i++)
+            counts[(m_packets[i].sortKey >> shift) & (NUM_BUCKETS - 1)]++;
+        
+        // Skip the pass if everything is in one bucket
+        if(m_packets.empty() || counts[(m_packets[0].sortKey >> shift) & (NUM_BUCKETS - 1)] == m_packets.size())
+            continue;
+        
+        // Turn the counts into where each bucket starts
+        unsigned int start = 0;
+        for(int bucket = 0; bucket < NUM_BUCKETS; bucket++)
+        {
+            unsigned int count = counts[bucket];
+            counts[bucket] = start;
+            start += count;
+        } // for
+        
+        for(unsigned int i = 0; i < m_packets.size(); i++)
+            m_sortBuffer[counts[(m_packets[i].sortKey >> shift) & (NUM_BUCKETS - 1)]++] = m_packets[i];
+        m_packets.swap(m_sortBuffer);
+    } // for
+} // RenderQueue::sort()
@@ -0,0 +1,66 @@
+/**
+ RenderQueue.hpp
+ Virtual Keyboard
+ Class which collects the meshes to draw in a frame as draw
+ packets with 64-bit sort keys, sorts them (radix sort) so that
+ draws sharing a program, vertex array, and material end up next
+ to each other, and then draws them through the state tracker.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/16/2018
+ */
+
+#ifndef RenderQueue_hpp
+#define RenderQueue_hpp
+
+#include <vector>
+#include <stdint.h>
+#include "Mesh.hpp"
+#include "Camera.hpp"
+#include "RenderState.hpp"
+
+class RenderQueue
+{
+public:
+    RenderQueue(RenderState* renderState);
+    
+    void submit(Mesh* mesh, float depth, const glm::vec3& offset = glm::vec3(0.0f));
+    void flush(Camera* camera);
+    
+    /**
+     Gets how many state changes the state tracker skipped
+     while drawing the last flush().
+     */
+    inline unsigned int getNumStateChangesAvoided() { return m_numStateChangesAvoided; }
+    /**
+     Gets how many state changes were sent to OpenGL while
+     drawing the last flush().
+     */
+    inline unsigned int getNumStateChanges() { return m_numStateChanges; }
+private:
+    // One mesh to draw, with the key it is sorted by
+    struct DrawPacket
+    {
+        uint64_t sortKey;
+        Mesh* mesh;
+        glm::vec3 offset; // Where it is drawn from its transform
+    }; // DrawPacket
+    
+    void sort();
+    
+    // Bits of the sort key (from most to least significant)
+    static const int PROGRAM_BITS = 12;
+    static const int VERTEX_ARRAY_BITS = 16;
+    static const int MATERIAL_BITS = 12;
+    static const int DEPTH_BITS = 24;
+    static const int RADIX_BITS = 8; // Bits sorted per pass
+    
+    RenderState* m_renderState;
+    std::vector<DrawPacket> m_packets;
+    std::vector<DrawPacket> m_sortBuffer; // Scratch space for sorting
+    
+    unsigned int m_numStateChanges;
+    unsigned int m_numStateChangesAvoided;
+}; // RenderQueue
+
+#endif /* RenderQueue_hpp */
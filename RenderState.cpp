@@ -0,0 +1,216 @@
+/**
+ RenderState.cpp
+ Virtual Keyboard
+ Implementation of RenderState.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/16/2018
+ */
+
+#include "RenderState.hpp"
+#include <string.h>
+
+//--------------------------------------------------------------------------
+/**
+ Creates a state tracker which does not know anything about
+ the current OpenGL state (so the first change of each kind
+ is always sent to OpenGL).
+ */
+RenderState::RenderState()
+{
+    m_program = UNKNOWN;
+    m_vertexArray = UNKNOWN;
+    m_numDrawCalls = 0;
+    resetCounters();
+} // RenderState::RenderState()
+
+//--------------------------------------------------------------------------
+/**
+ Uses a shader program, unless it is already in use.
+ 
+ @param program The OpenGL reference to the program.
+ */
+void RenderState::useProgram(GLuint program)
+{
+    if(m_program == program)
+    {
+        m_numStateChangesAvoided++;
+        return;
+    } // if
+    glUseProgram(program);
+    m_program = program;
+    m_numStateChanges++;
+} // RenderState::useProgram(GLuint)
+
+//--------------------------------------------------------------------------
+/**
+ Binds a vertex array object, unless it is already bound.
+ 
+ @param vertexArray The OpenGL reference to the vertex array.
+ */
+void RenderState::bindVertexArray(GLuint vertexArray)
+{
+    if(m_vertexArray == vertexArray)
+    {
+        m_numStateChangesAvoided++;
+        return;
+    } // if
+    glBindVertexArray(vertexArray);
+    m_vertexArray = vertexArray;
+    m_numStateChanges++;
+} // RenderState::bindVertexArray(GLuint)
+
+//--------------------------------------------------------------------------
+/**
+ Sets an int (or sampler) uniform, unless it already has that
+ value. The program must be in use.
+ 
+ @param program The program the uniform belongs to.
+ @param location The location of the uniform in the program.
+ @param value The value to set.
+ */
+void RenderState::setUniform(GLuint program, GLint location, int value)
+{
+    // The bits of the int are remembered as if they were a float
+    float bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if(!uniformIsSet(program, location, &bits, 1))
+        glUniform1i(location, value);
+} // RenderState::setUniform(GLuint, GLint, int)
+
+//--------------------------------------------------------------------------
+/**
+ Sets a float uniform, unless it already has that value.
+ The program must be in use.
+ 
+ @param program The program the uniform belongs to.
+ @param location The location of the uniform in the program.
+ @param value The value to set.
+ */
+void RenderState::setUniform(GLuint program, GLint location, float value)
+{
+    if(!uniformIsSet(program, location, &value, 1))
+        glUniform1f(location, value);
+} // RenderState::setUniform(GLuint, GLint, float)
+
+//--------------------------------------------------------------------------
+/**
+ Sets a vec2 uniform, unless it already has that value.
+ The program must be in use.
+ 
+ @param program The program the uniform belongs to.
+ @param location The location of the uniform in the program.
+ @param value The value to set.
+ */
+void RenderState::setUniform(GLuint program, GLint location, const glm::vec2& value)
+{
+    if(!uniformIsSet(program, location, &value[0], 2))
+        glUniform2fv(location, 1, &value[0]);
+} // RenderState::setUniform(GLuint, GLint, const glm::vec2&)
+
+//--------------------------------------------------------------------------
+/**
+ Sets a vec3 uniform, unless it already has that value.
+ The program must be in use.
+ 
+ @param program The program the uniform belongs to.
+ @param location The location of the uniform in the program.
+ @param value The value to set.
+ */
+void RenderState::setUniform(GLuint program, GLint location, const glm::vec3& value)
+{
+    if(!uniformIsSet(program, location, &value[0], 3))
+        glUniform3fv(location, 1, &value[0]);
+} // RenderState::setUniform(GLuint, GLint, const glm::vec3&)
+
+//--------------------------------------------------------------------------
+/**
+ Sets a mat3 uniform, unless it already has that value.
+ The program must be in use.
+ 
+ @param program The program the uniform belongs to.
+ @param location The location of the uniform in the program.
+ @param value The value to set.
+ */
+void RenderState::setUniform(GLuint program, GLint location, const glm::mat3& value)
+{
+    if(!uniformIsSet(program, location, &value[0][0], 9))
+        glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
+} // RenderState::setUniform(GLuint, GLint, const glm::mat3&)
+
+//--------------------------------------------------------------------------
+/**
+ Sets a mat4 uniform, unless it already has that value.
+ The program must be in use.
+ 
+ @param program The program the uniform belongs to.
+ @param location The location of the uniform in the program.
+ @param value The value to set.
+ */
+void RenderState::setUniform(GLuint program, GLint location, const glm::mat4& value)
+{
+    if(!uniformIsSet(program, location, &value[0][0], 16))
+        glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+} // RenderState::setUniform(GLuint, GLint, const glm::mat4&)
+
+//--------------------------------------------------------------------------
+/**
+ Forgets everything about a program (used when it is deleted,
+ since OpenGL may reuse its name for a new program).
+ 
+ @param program The OpenGL reference to the program.
+ */
+void RenderState::forgetProgram(GLuint program)
+{
+    for(std::unordered_map<uint64_t, UniformValue>::iterator it = m_uniforms.begin(); it != m_uniforms.end();)
+    {
+        if((GLuint)(it->first >> 32) == program)
+            it = m_uniforms.erase(it);
+        else
+            ++it;
+    } // for
+    if(m_program == program)
+        m_program = UNKNOWN;
+} // RenderState::forgetProgram(GLuint)
+
+//--------------------------------------------------------------------------
+/**
+ Sets the counts of changes made and avoided back to zero.
+ */
+void RenderState::resetCounters()
+{
+    m_numStateChanges = 0;
+    m_numStateChangesAvoided = 0;
+} // RenderState::resetCounters()
+
+//--------------------------------------------------------------------------
+/**
+ Checks if a uniform already has the given value. If not, the
+ value is remembered (since the caller is about to set it).
+ Uniforms which are not in the program (location -1) are
+ always reported as set, since setting them does nothing.
+ 
+ @param program The program the uniform belongs to.
+ @param location The location of the uniform in the program.
+ @param values The floats of the value.
+ @param numFloats How many floats are in the value.
+ @return True if the uniform does not need to be set.
+ */
+bool RenderState::uniformIsSet(GLuint program, GLint location, const float* values, int numFloats)
+{
+    if(location < 0)
+        return true;
+    
+    uint64_t key = ((uint64_t)program << 32) | (uint32_t)location;
+    UniformValue& uniform = m_uniforms[key]; // Added (with 0 floats) if not there
+    if(uniform.numFloats == numFloats && memcmp(uniform.values, values, numFloats * sizeof(float)) == 0)
+    {
+        m_numStateChangesAvoided++;
+        return true;
+    } // if
+    
+    uniform.numFloats = numFloats;
+    memcpy(uniform.values, values, numFloats * sizeof(float));
+    m_numStateChanges++;
+    return false;
+} // RenderState::uniformIsSet(GLuint, GLint, const float*, int)
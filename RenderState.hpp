@@ -0,0 +1,88 @@
+/**
+ RenderState.hpp
+ Virtual Keyboard
+ Class which keeps track of the OpenGL state that has already
+ been set (the program, the vertex array, and uniform values)
+ so that setting the same state twice does not call OpenGL
+ again. It counts how many state changes it made and avoided,
+ and how many draw calls were made.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/16/2018
+ */
+
+#ifndef RenderState_hpp
+#define RenderState_hpp
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <stdint.h>
+
+class RenderState
+{
+public:
+    RenderState();
+    
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    void setUniform(GLuint program, GLint location, int value);
+    void setUniform(GLuint program, GLint location, float value);
+    void setUniform(GLuint program, GLint location, const glm::vec2& value);
+    void setUniform(GLuint program, GLint location, const glm::vec3& value);
+    void setUniform(GLuint program, GLint location, const glm::mat3& value);
+    void setUniform(GLuint program, GLint location, const glm::mat4& value);
+    void forgetProgram(GLuint program);
+    void resetCounters();
+    
+    /**
+     Counts one draw call.
+     */
+    inline void countDrawCall() { m_numDrawCalls++; }
+    /**
+     Gets how many draw calls were made since the count was last
+     reset (resetCounters() does not reset it).
+     */
+    inline unsigned int getNumDrawCalls() { return m_numDrawCalls; }
+    /**
+     Sets the count of draw calls back to zero.
+     */
+    inline void resetNumDrawCalls() { m_numDrawCalls = 0; }
+    
+    /**
+     Gets how many state changes were sent to OpenGL since
+     the counters were last reset.
+     */
+    inline unsigned int getNumStateChanges() { return m_numStateChanges; }
+    /**
+     Gets how many state changes were skipped because the
+     state was already set, since the counters were last reset.
+     */
+    inline unsigned int getNumStateChangesAvoided() { return m_numStateChangesAvoided; }
+private:
+    // The last value sent to one uniform (big enough for a mat4)
+    struct UniformValue
+    {
+        int numFloats;
+        float values[16];
+    }; // UniformValue
+    
+    bool uniformIsSet(GLuint program, GLint location, const float* values, int numFloats);
+    
+    static const GLuint UNKNOWN = 0xFFFFFFFF; // Nothing known about the binding yet
+    
+    GLuint m_program; // Program currently in use
+    GLuint m_vertexArray; // Vertex array currently bound
+    
+    // Uniform values, keyed by the program (high 32 bits) and
+    // the location of the uniform (low 32 bits)
+    std::unordered_map<uint64_t, UniformValue> m_uniforms;
+    
+    unsigned int m_numStateChanges;
+    unsigned int m_numStateChangesAvoided;
+    unsigned int m_numDrawCalls; // Counted separately, since a frame may reset the others
+}; // RenderState
+
+#endif /* RenderState_hpp */
@@ -0,0 +1,71 @@
+/**
+ RotationLatch.cpp
+ Virtual Keyboard
+ Implementation of RotationLatch.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/27/2018
+ */
+
+#include "RotationLatch.hpp"
+
+//--------------------------------------------------------------------------
+/**
+ Creates a latch holding no rotation, stamped with the start
+ of the steady clock.
+ */
+RotationLatch::RotationLatch()
+{
+    m_sequence.store(0, std::memory_order_relaxed);
+    m_xRot.store(0.0f, std::memory_order_relaxed);
+    m_yRot.store(0.0f, std::memory_order_relaxed);
+    m_inputTime.store(0, std::memory_order_relaxed);
+} // RotationLatch::RotationLatch()
+
+//--------------------------------------------------------------------------
+/**
+ Stores a new rotation. Only one thread (the main thread) may
+ store into a latch.
+ 
+ @param xRot The camera's rotation in the x direction.
+ @param yRot The camera's rotation in the y direction.
+ @param inputTime When the mouse motion which led to the
+ rotation was handled.
+ */
+void RotationLatch::store(float xRot, float yRot, std::chrono::steady_clock::time_point inputTime)
+{
+    unsigned int sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed); // Odd: a store is under way
+    std::atomic_thread_fence(std::memory_order_release);
+    m_xRot.store(xRot, std::memory_order_relaxed);
+    m_yRot.store(yRot, std::memory_order_relaxed);
+    m_inputTime.store(inputTime.time_since_epoch().count(), std::memory_order_relaxed);
+    m_sequence.store(sequence + 2, std::memory_order_release);
+} // RotationLatch::store(float, float, std::chrono::steady_clock::time_point)
+
+//--------------------------------------------------------------------------
+/**
+ Reads the newest rotation, reading again if it was being
+ stored at the same time.
+ 
+ @param xRot Set to the camera's rotation in the x direction.
+ @param yRot Set to the camera's rotation in the y direction.
+ @param inputTime Set to when the mouse motion which led to
+ the rotation was handled.
+ */
+void RotationLatch::load(float& xRot, float& yRot, std::chrono::steady_clock::time_point& inputTime)
+{
+    unsigned int before;
+    unsigned int after;
+    std::chrono::steady_clock::rep ticks;
+    do
+    {
+        before = m_sequence.load(std::memory_order_acquire);
+        xRot = m_xRot.load(std::memory_order_relaxed);
+        yRot = m_yRot.load(std::memory_order_relaxed);
+        ticks = m_inputTime.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = m_sequence.load(std::memory_order_relaxed);
+    } while((before & 1) || before != after);
+    inputTime = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(ticks));
+} // RotationLatch::load(float&, float&, std::chrono::steady_clock::time_point&)
@@ -0,0 +1,37 @@
+/**
+ RotationLatch.hpp
+ Virtual Keyboard
+ Class which holds the camera's newest rotation from the mouse,
+ stored by the main thread every time the mouse moves and read
+ by the render thread at the last moment before the camera is
+ used (late latching), so a frame shows the newest mouse motion
+ even if its snapshot was taken earlier. The rotation is guarded
+ by a sequence number instead of a lock: the main thread never
+ waits, and the render thread reads again in the rare case that
+ the rotation changed while it was reading.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/27/2018
+ */
+
+#ifndef RotationLatch_hpp
+#define RotationLatch_hpp
+
+#include <atomic>
+#include <chrono>
+
+class RotationLatch
+{
+public:
+    RotationLatch();
+    
+    void store(float xRot, float yRot, std::chrono::steady_clock::time_point inputTime);
+    void load(float& xRot, float& yRot, std::chrono::steady_clock::time_point& inputTime);
+private:
+    std::atomic<unsigned int> m_sequence; // Odd while the main thread is storing
+    std::atomic<float> m_xRot;
+    std::atomic<float> m_yRot;
+    std::atomic<std::chrono::steady_clock::rep> m_inputTime; // When the mouse motion was handled
+}; // RotationLatch
+
+#endif /* RotationLatch_hpp */
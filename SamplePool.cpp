@@ -0,0 +1,238 @@
+/**
+ SamplePool.cpp
+ Virtual Keyboard
+ Implementation of SamplePool.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 5/3/2018
+ */
+
+#include "SamplePool.hpp"
+#include "AiffLoader.hpp"
+#include <iomanip>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+std::map<std::string, SamplePool::Sample*> SamplePool::m_samplesByName;
+std::multimap<uint64_t, SamplePool::Sample*> SamplePool::m_samplesByHash;
+unsigned int SamplePool::m_numLoads = 0;
+unsigned int SamplePool::m_numDecoded = 0;
+unsigned int SamplePool::m_numParsed = 0;
+unsigned int SamplePool::m_numSameSamples = 0;
+unsigned long long SamplePool::m_numBytes = 0;
+unsigned long long SamplePool::m_numBytesLoaded = 0;
+
+//--------------------------------------------------------------------------
+/**
+ Gets a sound file's samples, loading them only if no other
+ handle already has the same file (or the same samples) in the
+ format the mixer is using now. SDL Mixer must be open.
+ 
+ @param path The path of the sound file.
+ @return A handle to the samples (with no chunk if the file
+ could not be loaded; Mix_GetError() says why).
+ */
+SampleHandle SamplePool::load(const std::string& path)
+{
+    m_numLoads++;
+    SampleHandle handle;
+    std::string name = getName(path);
+    std::map<std::string, Sample*>::iterator found = m_samplesByName.find(name);
+    if(found != m_samplesByName.end())
+        handle.m_sample = found->second;
+    else
+    {
+        // AIFF files in the mixer's format are converted straight from the file
+        Mix_Chunk* chunk = AiffLoader::load(path);
+        if(chunk)
+            m_numParsed++;
+        else
+            chunk = Mix_LoadWAV(path.c_str());
+        if(!chunk)
+            return handle;
+        m_numDecoded++;
+        
+        // Another file may hold exactly the same samples
+        uint64_t hash = hashSamples(chunk);
+        Sample* sample = findSameSamples(chunk, hash);
+        if(sample)
+        {
+            Mix_FreeChunk(chunk);
+            m_numSameSamples++;
+        } // if
+        else
+        {
+            sample = new Sample();
+            sample->chunk = chunk;
+            sample->numHandles = 0;
+            sample->hash = hash;
+            m_samplesByHash.insert(std::make_pair(hash, sample));
+            m_numBytes += chunk->alen;
+        } // else
+        sample->names.push_back(name);
+        m_samplesByName[name] = sample;
+        handle.m_sample = sample;
+    } // else
+    
+    handle.m_sample->numHandles++;
+    m_numBytesLoaded += handle.m_sample->chunk->alen;
+    return handle;
+} // SamplePool::load(const std::string&)
+
+//--------------------------------------------------------------------------
+/**
+ Prints how many sounds were asked for, how many were loaded,
+ and how much memory sharing them saves.
+ 
+ @param out The stream to print to.
+ */
+void SamplePool::report(std::ostream& out)
+{
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    const double BYTES_PER_MB = 1024.0 * 1024.0;
+    out << std::fixed << std::setprecision(1)
+        << "Samples: " << m_numLoads << " asked for by keys, " << m_numDecoded << " file(s) read ("
+        << m_numParsed << " by the AIFF loader, " << m_numSameSamples << " the same as another), " << m_samplesByHash.size() << " held in "
+        << m_numBytes / BYTES_PER_MB << " MB (" << m_numBytesLoaded / BYTES_PER_MB << " MB without sharing)" << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+} // SamplePool::report(std::ostream&)
+
+//--------------------------------------------------------------------------
+/**
+ Gets the name a sample is pooled under: the resolved path of
+ its file (so different paths to one file match) and the format
+ the mixer converts it to.
+ 
+ @param path The path of the sound file.
+ @return The name.
+ */
+std::string SamplePool::getName(const std::string& path)
+{
+    char resolved[PATH_MAX];
+    std::string name = realpath(path.c_str(), resolved) ? resolved : path;
+    
+    int frequency = 0;
+    Uint16 format = 0;
+    int numChannels = 0;
+    Mix_QuerySpec(&frequency, &format, &numChannels);
+    return name + "|" + std::to_string(frequency) + "|" + std::to_string(format) + "|" + std::to_string(numChannels);
+} // SamplePool::getName(const std::string&)
+
+//--------------------------------------------------------------------------
+/**
+ Hashes the samples of a chunk (64-bit FNV-1a).
+ 
+ @param chunk The chunk.
+ @return The hash.
+ */
+uint64_t SamplePool::hashSamples(const Mix_Chunk* chunk)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for(Uint32 i = 0; i < chunk->alen; i++)
+    {
+        hash ^= chunk->abuf[i];
+        hash *= 1099511628211ULL;
+    } // for
+    return hash;
+} // SamplePool::hashSamples(const Mix_Chunk*)
+
+//--------------------------------------------------------------------------
+/**
+ Finds a sample already loaded with exactly the same samples
+ as a chunk.
+ 
+ @param chunk The chunk.
+ @param hash The hash of the chunk's samples.
+ @return The sample, or NULL if there is none.
+ */
+SamplePool::Sample* SamplePool::findSameSamples(const Mix_Chunk* chunk, uint64_t hash)
+{
+    std::pair<std::multimap<uint64_t, Sample*>::iterator, std::multimap<uint64_t, Sample*>::iterator> range = m_samplesByHash.equal_range(hash);
+    for(std::multimap<uint64_t, Sample*>::iterator i = range.first; i != range.second; i++)
+    {
+        const Mix_Chunk* other = i->second->chunk;
+        if(other->alen == chunk->alen && other->volume == chunk->volume && memcmp(other->abuf, chunk->abuf, chunk->alen) == 0)
+            return i->second;
+    } // for
+    return NULL;
+} // SamplePool::findSameSamples(const Mix_Chunk*, uint64_t)
+
+//--------------------------------------------------------------------------
+/**
+ Takes away one use of a sample, and frees it if that was the
+ last one (so it is loaded again if it is needed again).
+ 
+ @param sample The sample.
+ */
+void SamplePool::release(Sample* sample)
+{
+    if(--sample->numHandles > 0)
+        return;
+    for(unsigned int i = 0; i < sample->names.size(); i++)
+        m_samplesByName.erase(sample->names[i]);
+    std::pair<std::multimap<uint64_t, Sample*>::iterator, std::multimap<uint64_t, Sample*>::iterator> range = m_samplesByHash.equal_range(sample->hash);
+    for(std::multimap<uint64_t, Sample*>::iterator i = range.first; i != range.second; i++)
+    {
+        if(i->second == sample)
+        {
+            m_samplesByHash.erase(i);
+            break;
+        } // if
+    } // for
+    m_numBytes -= sample->chunk->alen;
+    Mix_FreeChunk(sample->chunk);
+    delete sample;
+} // SamplePool::release(Sample*)
+
+//--------------------------------------------------------------------------
+/**
+ Creates a handle without a sample.
+ */
+SampleHandle::SampleHandle()
+{
+    m_sample = NULL;
+} // SampleHandle::SampleHandle()
+
+//--------------------------------------------------------------------------
+/**
+ Creates another use of the same sample as a handle.
+ 
+ @param other The handle to copy.
+ */
+SampleHandle::SampleHandle(const SampleHandle& other)
+{
+    m_sample = other.m_sample;
+    if(m_sample)
+        m_sample->numHandles++;
+} // SampleHandle::SampleHandle(const SampleHandle&)
+
+//--------------------------------------------------------------------------
+/**
+ Switches to the same sample as another handle, giving up the
+ sample this one had.
+ 
+ @param other The handle to copy.
+ @return This handle.
+ */
+SampleHandle& SampleHandle::operator=(const SampleHandle& other)
+{
+    if(other.m_sample)
+        other.m_sample->numHandles++; // First, in case it is the same sample
+    if(m_sample)
+        SamplePool::release(m_sample);
+    m_sample = other.m_sample;
+    return *this;
+} // SampleHandle::operator=(const SampleHandle&)
+
+//--------------------------------------------------------------------------
+/**
+ Gives up the handle's use of its sample.
+ */
+SampleHandle::~SampleHandle()
+{
+    if(m_sample)
+        SamplePool::release(m_sample);
+} // SampleHandle::~SampleHandle()
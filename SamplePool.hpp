@@ -0,0 +1,93 @@
+/**
+ SamplePool.hpp
+ Virtual Keyboard
+ Class which loads each sound once for the whole program, so
+ that any number of keys and keyboards can play the same
+ sample without holding their own copy. Samples are found by
+ the resolved path of their file and the format they were
+ converted to (the mixer's), and a file whose samples are the
+ same as ones already loaded shares them too. Keys hold
+ SampleHandles, which count how many use each sample; it is
+ freed when the last one goes. Samples are only loaded and
+ released on the main thread.
+ 
+ @author Graeme Zinck
+ @version 1.0 5/3/2018
+ */
+
+#ifndef SamplePool_hpp
+#define SamplePool_hpp
+
+#include <SDL2/SDL.h>
+#include <SDL2_mixer/SDL_mixer.h>
+#include <map>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class SampleHandle;
+
+class SamplePool
+{
+public:
+    static SampleHandle load(const std::string& path);
+    static void report(std::ostream& out);
+    
+    /**
+     Gets how many bytes of samples are held.
+     */
+    static inline unsigned long long getNumBytes() { return m_numBytes; }
+private:
+    friend class SampleHandle;
+    
+    // One loaded sound, shared by every name it was loaded as
+    struct Sample
+    {
+        Mix_Chunk* chunk;
+        unsigned int numHandles;
+        uint64_t hash; // Of the samples, to find files with the same ones
+        std::vector<std::string> names; // Keys of m_samplesByName
+    }; // Sample
+    
+    static std::string getName(const std::string& path);
+    static uint64_t hashSamples(const Mix_Chunk* chunk);
+    static Sample* findSameSamples(const Mix_Chunk* chunk, uint64_t hash);
+    static void release(Sample* sample);
+    
+    static std::map<std::string, Sample*> m_samplesByName;
+    static std::multimap<uint64_t, Sample*> m_samplesByHash;
+    
+    // Counts for the report
+    static unsigned int m_numLoads; // Times load() was called
+    static unsigned int m_numDecoded; // Files read and converted
+    static unsigned int m_numParsed; // Of those, files converted by AiffLoader
+    static unsigned int m_numSameSamples; // Files whose samples were already loaded
+    static unsigned long long m_numBytes; // Held now
+    static unsigned long long m_numBytesLoaded; // As if every load had its own copy
+}; // SamplePool
+
+//--------------------------------------------------------------------------
+/**
+ SampleHandle class holds one use of a sample in the pool
+ (copying it adds a use, and destroying it takes one away).
+ */
+class SampleHandle
+{
+public:
+    SampleHandle();
+    SampleHandle(const SampleHandle& other);
+    SampleHandle& operator=(const SampleHandle& other);
+    virtual ~SampleHandle();
+    
+    /**
+     Gets the chunk to play (NULL if the sample could not be loaded).
+     */
+    inline Mix_Chunk* getChunk() const { return m_sample ? m_sample->chunk : NULL; }
+private:
+    friend class SamplePool;
+    
+    SamplePool::Sample* m_sample; // NULL if there is no sample
+}; // SampleHandle
+
+#endif /* SamplePool_hpp */
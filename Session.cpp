@@ -0,0 +1,128 @@
+/**
+ Session.cpp
+ Virtual Keyboard
+ Implementation of Session.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/25/2018
+ */
+
+#include "Session.hpp"
+#include <fstream>
+#include <sstream>
+
+//--------------------------------------------------------------------------
+/**
+ Creates an empty session.
+ */
+Session::Session()
+{
+} // Session::Session()
+
+//--------------------------------------------------------------------------
+/**
+ Adds the current state as a sample, timed from the first
+ sample recorded. Called whenever a frame is drawn.
+ 
+ @param camera The camera the frame was drawn from.
+ @param keys The keys (for their sound setting).
+ */
+void Session::record(Camera* camera, KeyboardKeys* keys)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(m_samples.empty())
+        m_start = now;
+    
+    Sample sample;
+    sample.ms = std::chrono::duration<float, std::milli>(now - m_start).count();
+    sample.position = camera->getRenderPos();
+    sample.xRot = camera->getXRot();
+    sample.yRot = camera->getYRot();
+    sample.sound = keys->getSoundSetting();
+    m_samples.push_back(sample);
+} // Session::record(Camera*, KeyboardKeys*)
+
+//--------------------------------------------------------------------------
+/**
+ Saves the session as text, one sample per line.
+ 
+ @param path The path of the file.
+ @return True if the file was written.
+ */
+bool Session::save(const std::string& path)
+{
+    std::ofstream file(path.c_str(), std::ios::trunc);
+    if(!file.is_open())
+        return false;
+    file.precision(9); // Enough to get the same floats back
+    for(unsigned int i = 0; i < m_samples.size(); i++)
+    {
+        const Sample& sample = m_samples[i];
+        file << sample.ms << ' ' << sample.position.x << ' ' << sample.position.y << ' ' << sample.position.z
+             << ' ' << sample.xRot << ' ' << sample.yRot << ' ' << sample.sound << '\n';
+    } // for
+    return file.good();
+} // Session::save(const std::string&)
+
+//--------------------------------------------------------------------------
+/**
+ Loads a session saved by save(), replacing any samples. Blank
+ lines and lines starting with # are skipped.
+ 
+ @param path The path of the file.
+ @return True if the file was read and had at least one sample.
+ */
+bool Session::load(const std::string& path)
+{
+    std::ifstream file(path.c_str());
+    if(!file.is_open())
+        return false;
+    
+    m_samples.clear();
+    std::string line;
+    while(getline(file, line))
+    {
+        if(line.empty() || line[0] == '#')
+            continue;
+        std::istringstream fields(line);
+        Sample sample;
+        if(!(fields >> sample.ms >> sample.position.x >> sample.position.y >> sample.position.z
+                    >> sample.xRot >> sample.yRot >> sample.sound))
+            return false;
+        if(!m_samples.empty() && sample.ms < m_samples.back().ms)
+            return false; // Samples must be in order of time
+        m_samples.push_back(sample);
+    } // while
+    return !m_samples.empty();
+} // Session::load(const std::string&)
+
+//--------------------------------------------------------------------------
+/**
+ Puts the camera and the keys' sound setting in the state of
+ the last sample at or before a time. Nothing is interpolated,
+ since the state only ever changed when a frame was drawn.
+ 
+ @param ms The time in milliseconds since the first sample.
+ @param camera The camera to move.
+ @param keys The keys to set the sound of.
+ */
+void Session::apply(float ms, Camera* camera, KeyboardKeys* keys)
+{
+    if(m_samples.empty())
+        return;
+    
+    // Find the first sample after the time
+    unsigned int low = 0;
+    unsigned int high = (unsigned int)m_samples.size();
+    while(low < high)
+    {
+        unsigned int middle = (low + high) / 2;
+        if(m_samples[middle].ms <= ms)
+            low = middle + 1;
+        else
+            high = middle;
+    } // while
+    const Sample& sample = m_samples[low > 0 ? low - 1 : 0];
+    camera->setPose(sample.position, sample.xRot, sample.yRot);
+    keys->setSoundSetting(sample.sound);
+} // Session::apply(float, Camera*, KeyboardKeys*)
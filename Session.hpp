@@ -0,0 +1,58 @@
+/**
+ Session.hpp
+ Virtual Keyboard
+ Class for a recorded session: the pose of the camera and the
+ sound setting at each frame the user saw, with the time it
+ was drawn. The keys pressed follow from where the camera is,
+ so this is everything needed to play a performance back. A
+ session can be saved to and loaded from a text file with one
+ sample per line ("ms x y z xRot yRot sound").
+ 
+ @author Graeme Zinck
+ @version 1.0 4/25/2018
+ */
+
+#ifndef Session_hpp
+#define Session_hpp
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Camera.hpp"
+#include "KeyboardKeys.hpp"
+
+class Session
+{
+public:
+    Session();
+    
+    void record(Camera* camera, KeyboardKeys* keys);
+    bool save(const std::string& path);
+    bool load(const std::string& path);
+    void apply(float ms, Camera* camera, KeyboardKeys* keys);
+    
+    /**
+     Gets how many samples are in the session.
+     */
+    inline unsigned int getNumSamples() { return (unsigned int)m_samples.size(); }
+    /**
+     Gets the time of the last sample in milliseconds.
+     */
+    inline float getDurationMs() { return m_samples.empty() ? 0.0f : m_samples.back().ms; }
+private:
+    // The state at one frame
+    struct Sample
+    {
+        float ms; // Since the first sample
+        glm::vec3 position;
+        float xRot;
+        float yRot;
+        unsigned int sound;
+    }; // Sample
+    
+    std::vector<Sample> m_samples; // In order of time
+    std::chrono::steady_clock::time_point m_start; // When the first sample was recorded
+}; // Session
+
+#endif /* Session_hpp */
@@ -8,31 +8,64 @@
  */
 
 #include "Shader.hpp"
+#include "ShadowMap.hpp"
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <chrono>
 
 // Helper methods (these are at the end of the file)
 static void checkShaderError(GLuint shader, GLuint flag, bool isAProgram);
 static std::string loadShader(const std::string& fileName);
+static std::string insertDefines(const std::string& text, const std::string& defines);
 static GLuint createShader(const std::string& text, GLenum shaderType);
 
 //--------------------------------------------------------------------------
 /**
  Create a shader program from a shader file, composed
- of one vertex shader and one fragment shader. It compiles
- the program, and then it gets the uniforms which will be
- used to set parameters in the shaders.
+ of one vertex shader and one fragment shader. The shaders
+ are only submitted to the driver here: nothing waits for
+ them to compile or link until the program is first used,
+ so many programs can compile at once (on other threads if
+ the driver supports GL_KHR_parallel_shader_compile) while
+ the rest of the program starts up.
  
  @param fileName The full path of the shaders WITHOUT
  their extension (the extensions ".vs" and ".fs" will
  be added automatically).
+ @param renderState The state tracker which all uniform
+ and program changes go through.
+ @param defines Lines of "#define"s which are added to the
+ top of both shaders (after the "#version" line) to turn
+ on optional features in the shaders.
+ @param cache A cache of linked programs to load the program
+ from instead of compiling it (or NULL to always compile).
  */
-Shader::Shader(const std::string& fileName)
+Shader::Shader(const std::string& fileName, RenderState* renderState, const std::string& defines, ProgramCache* cache)
 {    
+    m_renderState = renderState;
     m_program = glCreateProgram(); // Returns the location of the program
+    m_shaders[0] = 0;
+    m_shaders[1] = 0;
+    m_isLinked = false;
+    m_cache = NULL;
+    m_cacheKey = 0;
+    m_compileMs = 0.0f;
+    m_pendingLights = NULL;
+    m_numPendingLights = 0;
+    m_lightClusters = NULL;
+    m_shadowMap = NULL;
     
-    std::string vertexShaderText = loadShader(fileName + ".vs");
-    std::string fragmentShaderText = loadShader(fileName + ".fs");
+    std::string vertexShaderText = insertDefines(loadShader(fileName + ".vs"), defines);
+    std::string fragmentShaderText = insertDefines(loadShader(fileName + ".fs"), defines);
+    
+    // Try the cache before compiling anything
+    if(cache)
+        m_cacheKey = cache->makeKey(vertexShaderText, fragmentShaderText);
+    if(cache && cache->load(m_program, m_cacheKey))
+        return;
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
     
     m_shaders[0] = createShader(vertexShaderText, GL_VERTEX_SHADER);
     m_shaders[1] = createShader(fragmentShaderText, GL_FRAGMENT_SHADER);
@@ -40,32 +73,104 @@ Shader::Shader(const std::string& fileName)
     for(unsigned int i = 0; i < NUM_SHADERS; i++)
         glAttachShader(m_program, m_shaders[i]);
     
+    // Put the attributes in the same place in every version of the shader
+    glBindAttribLocation(m_program, POSITION_A, "position");
+    glBindAttribLocation(m_program, NORMAL_A, "normal");
+    glBindAttribLocation(m_program, DRAW_DATA_A, "drawData");
+    glBindAttribLocation(m_program, BAKED_LIGHT_A, "bakedLight");
+    glBindAttribLocation(m_program, TEX_COORD_A, "texCoord");
+    glBindAttribLocation(m_program, COLOR_A, "color");
+    
+    // Save the program once it is linked
+    if(cache && cache->isEnabled())
+    {
+        glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        m_cache = cache;
+    } // if
     glLinkProgram(m_program);
+    
+    m_compileMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+} // Shader(const std::string&, RenderState*, const std::string&, ProgramCache*)
+
+//--------------------------------------------------------------------------
+/**
+ Waits for the program to link (if it has not already), then
+ reports any errors, saves it to the cache, gets the uniforms
+ which will be used to set parameters in the shaders, and
+ sets the lights which were bound before it was ready.
+ */
+void Shader::finishLinking()
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    m_isLinked = true;
+    
+    // The first of these waits for the driver if it is still working
+    for(unsigned int i = 0; i < NUM_SHADERS; i++)
+    {
+        if(m_shaders[i] != 0)
+            checkShaderError(m_shaders[i], GL_COMPILE_STATUS, false);
+    } // for
     checkShaderError(m_program, GL_LINK_STATUS, true);
     
     // Used for bugfixing
     // glValidateProgram(m_program);
     // checkShaderError(m_program, GL_VALIDATE_STATUS, true);
     
+    if(m_cache)
+    {
+        GLint status = GL_FALSE;
+        glGetProgramiv(m_program, GL_LINK_STATUS, &status);
+        
+        // Only count the time this thread spent compiling or waiting
+        m_compileMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if(status == GL_TRUE)
+            m_cache->store(m_program, m_cacheKey, m_compileMs);
+        m_cache = NULL;
+    } // if
+    
     // Specify the matrices and where the camera is
     m_uniforms[MODEL_MATRIX_U] = glGetUniformLocation(m_program, "modelMatrix"); // Get the uniform from the glsl shader program
+    m_uniforms[NORMAL_MATRIX_U] = glGetUniformLocation(m_program, "normalMatrix"); // Not there in translation-only shaders
     m_uniforms[VIEW_MATRIX_U] = glGetUniformLocation(m_program, "viewMatrix");
     m_uniforms[CAMERA_POS_U] = glGetUniformLocation(m_program, "cameraPosition");
     
-    // Specify characteristics of the light
-    m_uniforms[LIGHT_POS_U] = glGetUniformLocation(m_program, "light.position");
-    m_uniforms[LIGHT_INTENSITIES_U] = glGetUniformLocation(m_program, "light.intensities");
-    m_uniforms[LIGHT_AMBIENT_COEFFICIENT_U] = glGetUniformLocation(m_program, "light.ambientCoefficient");
-    m_uniforms[LIGHT_ATTENUATION_FACTOR_A_U] = glGetUniformLocation(m_program, "light.attenuationFactorA");
-    m_uniforms[LIGHT_ATTENUATION_FACTOR_B_U] = glGetUniformLocation(m_program, "light.attenuationFactorB");
-    m_uniforms[LIGHT_ATTENUATION_FACTOR_C_U] = glGetUniformLocation(m_program, "light.attenuationFactorC");
+    // Specify characteristics of the lights (the ones past the
+    // number of lights the shader was compiled for are at -1)
+    for(unsigned int i = 0; i < MAX_LIGHTS; i++)
+    {
+        std::string name = "lights[" + std::to_string(i) + "].";
+        m_lightUniforms[i][LIGHT_POS_U] = glGetUniformLocation(m_program, (name + "position").c_str());
+        m_lightUniforms[i][LIGHT_INTENSITIES_U] = glGetUniformLocation(m_program, (name + "intensities").c_str());
+        m_lightUniforms[i][LIGHT_AMBIENT_COEFFICIENT_U] = glGetUniformLocation(m_program, (name + "ambientCoefficient").c_str());
+        m_lightUniforms[i][LIGHT_ATTENUATION_FACTOR_A_U] = glGetUniformLocation(m_program, (name + "attenuationFactorA").c_str());
+        m_lightUniforms[i][LIGHT_ATTENUATION_FACTOR_B_U] = glGetUniformLocation(m_program, (name + "attenuationFactorB").c_str());
+        m_lightUniforms[i][LIGHT_ATTENUATION_FACTOR_C_U] = glGetUniformLocation(m_program, (name + "attenuationFactorC").c_str());
+    } // for
     
     // Specify characteristics of the material
     m_uniforms[MATERIAL_SPECULAR_EXPONENT_U] = glGetUniformLocation(m_program, "material.specularExponent");
     m_uniforms[MATERIAL_AMBIENT_U] = glGetUniformLocation(m_program, "material.ambient");
     m_uniforms[MATERIAL_DIFFUSE_U] = glGetUniformLocation(m_program, "material.diffuse");
     m_uniforms[MATERIAL_SPECULAR_U] = glGetUniformLocation(m_program, "material.specular");
-} // Shader()
+    
+    // Specify the lights sorted into clusters (only there in clustered shaders)
+    m_uniforms[AMBIENT_LIGHT_U] = glGetUniformLocation(m_program, "ambientLight");
+    m_uniforms[CLUSTER_TILE_SCALE_U] = glGetUniformLocation(m_program, "clusterTileScale");
+    m_uniforms[CLUSTER_DEPTH_U] = glGetUniformLocation(m_program, "clusterDepth");
+    m_uniforms[LIGHT_DATA_U] = glGetUniformLocation(m_program, "lightData");
+    m_uniforms[CLUSTER_GRID_U] = glGetUniformLocation(m_program, "clusterGrid");
+    m_uniforms[CLUSTER_LIGHTS_U] = glGetUniformLocation(m_program, "clusterLights");
+    
+    // Specify the shadow map (only there in shaders with shadows)
+    m_uniforms[STATIC_SHADOW_MAP_U] = glGetUniformLocation(m_program, "staticShadowMap");
+    m_uniforms[DYNAMIC_SHADOW_MAP_U] = glGetUniformLocation(m_program, "dynamicShadowMap");
+    m_uniforms[SHADOW_LIGHT_POS_U] = glGetUniformLocation(m_program, "shadowLightPosition");
+    m_uniforms[SHADOW_DEPTH_U] = glGetUniformLocation(m_program, "shadowDepth");
+    
+    // Set the lights that were bound while it was compiling
+    if(m_pendingLights)
+        bind(m_pendingLights, m_numPendingLights);
+} // finishLinking()
 
 //--------------------------------------------------------------------------
 /**
@@ -74,43 +179,104 @@ Shader::Shader(const std::string& fileName)
  */
 Shader::~Shader()
 {
+    // Programs loaded from the cache have no shaders
     for(unsigned int i = 0; i < NUM_SHADERS; i++)
     {
+        if(m_shaders[i] == 0)
+            continue;
         glDetachShader(m_program, m_shaders[i]);
         glDeleteShader(m_shaders[i]);
     } // for
     glDeleteProgram(m_program);
+    m_renderState->forgetProgram(m_program);
 } // ~Shader()
 
 //--------------------------------------------------------------------------
 /**
  Binds the program. It also sets up the initial
- lighting settings using a light pointer passed
- as an argument.
+ lighting settings using the lights passed as an
+ argument.
  
- @param light A light pointer which is used to set up
+ @param lights An array of lights which are used to set up
  the initial light properties sent to the shader.
+ @param numLights The number of lights in the array (lights
+ past the number the shader was compiled for are ignored).
+ If the program is still compiling, the lights are set when
+ it is first used instead (so the array must stay alive).
  */
-void Shader::bind(Light* light)
+void Shader::bind(Light* lights, unsigned int numLights)
 {
-    glUseProgram(m_program);
-    
-    // Set the initial light settings of the shader program
-    glUniform3fv(m_uniforms[LIGHT_POS_U], 1, &light->getPos()[0]);
-    glUniform3fv(m_uniforms[LIGHT_INTENSITIES_U], 1, &light->getIntensities()[0]);
-    glUniform1f(m_uniforms[LIGHT_AMBIENT_COEFFICIENT_U], light->getAmbientCoefficient());
+    if(!m_isLinked)
+    {
+        m_pendingLights = lights;
+        m_numPendingLights = numLights;
+        return;
+    } // if
+    use();
     
-    // Set the attenuation
-    glm::vec3 attenuationFactor = light->getAttenuationFactor();
-    glUniform1f(m_uniforms[LIGHT_ATTENUATION_FACTOR_A_U], attenuationFactor.x);
-    glUniform1f(m_uniforms[LIGHT_ATTENUATION_FACTOR_B_U], attenuationFactor.y);
-    glUniform1f(m_uniforms[LIGHT_ATTENUATION_FACTOR_C_U], attenuationFactor.z);
-} // bind()
+    for(unsigned int i = 0; i < numLights && i < MAX_LIGHTS; i++)
+    {
+        Light* light = &lights[i];
+        GLint* uniforms = m_lightUniforms[i];
+        
+        // Set the initial light settings of the shader program
+        m_renderState->setUniform(m_program, uniforms[LIGHT_POS_U], light->getPos());
+        m_renderState->setUniform(m_program, uniforms[LIGHT_INTENSITIES_U], light->getIntensities());
+        m_renderState->setUniform(m_program, uniforms[LIGHT_AMBIENT_COEFFICIENT_U], light->getAmbientCoefficient());
+        
+        // Set the attenuation
+        glm::vec3 attenuationFactor = light->getAttenuationFactor();
+        m_renderState->setUniform(m_program, uniforms[LIGHT_ATTENUATION_FACTOR_A_U], attenuationFactor.x);
+        m_renderState->setUniform(m_program, uniforms[LIGHT_ATTENUATION_FACTOR_B_U], attenuationFactor.y);
+        m_renderState->setUniform(m_program, uniforms[LIGHT_ATTENUATION_FACTOR_C_U], attenuationFactor.z);
+    } // for
+} // bind(Light*, unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Sets the clusters of lights that the shader reads its lights
+ from (the shader must have been compiled with
+ CLUSTERED_LIGHTS). They are sent to the shader in update().
+ 
+ @param lightClusters The lights sorted into clusters.
+ */
+void Shader::setLightClusters(LightClusters* lightClusters)
+{
+    m_lightClusters = lightClusters;
+} // setLightClusters(LightClusters*)
+
+//--------------------------------------------------------------------------
+/**
+ Sets the shadow map of the first light (the shader must have
+ been compiled with SHADOWS). It is sent to the shader in
+ update().
+ 
+ @param shadowMap The shadow map.
+ */
+void Shader::setShadowMap(ShadowMap* shadowMap)
+{
+    m_shadowMap = shadowMap;
+} // setShadowMap(ShadowMap*)
 
 //--------------------------------------------------------------------------
 /**
- Updates the model and view matrixes and the camera
- position.
+ Makes this the program used for drawing (without changing
+ any of the light settings). The first time, this waits for
+ the program to finish linking.
+ */
+void Shader::use()
+{
+    if(!m_isLinked)
+        finishLinking();
+    m_renderState->useProgram(m_program);
+} // use()
+
+//--------------------------------------------------------------------------
+/**
+ Updates the model, normal, and view matrixes and the
+ camera position. The model and normal matrices are
+ cached by the transform, so they are only recomputed
+ when it changes.
  
  @param transform The model matrix transformation object.
  @param camera The camera object used for positioning in the
@@ -118,13 +284,44 @@ void Shader::bind(Light* light)
  */
 void Shader::update(const Transform& transform, Camera* camera)
 {
-    glm::mat4 model = transform.getModel();
-    glm::mat4 view = camera->getViewProjection();
-    glUniformMatrix4fv(m_uniforms[MODEL_MATRIX_U], 1, GL_FALSE, &model[0][0]);
-    glUniformMatrix4fv(m_uniforms[VIEW_MATRIX_U], 1, GL_FALSE, &view[0][0]);
-    glUniform3fv(m_uniforms[CAMERA_POS_U], 1, &camera->getPos()[0]);
+    update(transform, camera->getViewProjection());
+    m_renderState->setUniform(m_program, m_uniforms[CAMERA_POS_U], camera->getRenderPos());
+    
+    // These only change once per frame at most, so they are almost always skipped
+    if(m_lightClusters)
+    {
+        m_renderState->setUniform(m_program, m_uniforms[AMBIENT_LIGHT_U], m_lightClusters->getAmbientLight());
+        m_renderState->setUniform(m_program, m_uniforms[CLUSTER_TILE_SCALE_U], m_lightClusters->getTileScale());
+        m_renderState->setUniform(m_program, m_uniforms[CLUSTER_DEPTH_U], m_lightClusters->getDepthParameters());
+        m_renderState->setUniform(m_program, m_uniforms[LIGHT_DATA_U], LightClusters::LIGHT_DATA_UNIT);
+        m_renderState->setUniform(m_program, m_uniforms[CLUSTER_GRID_U], LightClusters::CLUSTER_GRID_UNIT);
+        m_renderState->setUniform(m_program, m_uniforms[CLUSTER_LIGHTS_U], LightClusters::CLUSTER_LIGHTS_UNIT);
+    } // if
+    if(m_shadowMap)
+    {
+        m_renderState->setUniform(m_program, m_uniforms[STATIC_SHADOW_MAP_U], ShadowMap::STATIC_SHADOW_UNIT);
+        m_renderState->setUniform(m_program, m_uniforms[DYNAMIC_SHADOW_MAP_U], ShadowMap::DYNAMIC_SHADOW_UNIT);
+        m_renderState->setUniform(m_program, m_uniforms[SHADOW_LIGHT_POS_U], m_shadowMap->getLightPosition());
+        m_renderState->setUniform(m_program, m_uniforms[SHADOW_DEPTH_U], m_shadowMap->getDepthRange());
+    } // if
 } // update(const Transform&, const Camera&)
 
+//--------------------------------------------------------------------------
+/**
+ Updates only the model, normal, and view matrices (for
+ drawing from somewhere other than the camera, such as
+ from a light into a shadow map).
+ 
+ @param transform The model matrix transformation object.
+ @param viewProjection The view-projection matrix to draw with.
+ */
+void Shader::update(const Transform& transform, const glm::mat4& viewProjection)
+{
+    m_renderState->setUniform(m_program, m_uniforms[MODEL_MATRIX_U], transform.getModel());
+    m_renderState->setUniform(m_program, m_uniforms[NORMAL_MATRIX_U], transform.getNormalMatrix());
+    m_renderState->setUniform(m_program, m_uniforms[VIEW_MATRIX_U], viewProjection);
+} // update(const Transform&, const glm::mat4&)
+
 //--------------------------------------------------------------------------
 /**
  Sets the material properties of objects drawn using the
@@ -141,16 +338,43 @@ void Shader::update(const Transform& transform, Camera* camera)
 void Shader::setMaterial(glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float specularExponent)
 {
     // Specify characteristics of the material
-    glUniform3fv(m_uniforms[MATERIAL_AMBIENT_U], 1, &ambient[0]);
-    glUniform3fv(m_uniforms[MATERIAL_DIFFUSE_U], 1, &diffuse[0]);
-    glUniform3fv(m_uniforms[MATERIAL_SPECULAR_U], 1, &specular[0]);
-    glUniform1f(m_uniforms[MATERIAL_SPECULAR_EXPONENT_U], specularExponent);
+    m_renderState->setUniform(m_program, m_uniforms[MATERIAL_AMBIENT_U], ambient);
+    m_renderState->setUniform(m_program, m_uniforms[MATERIAL_DIFFUSE_U], diffuse);
+    m_renderState->setUniform(m_program, m_uniforms[MATERIAL_SPECULAR_U], specular);
+    m_renderState->setUniform(m_program, m_uniforms[MATERIAL_SPECULAR_EXPONENT_U], specularExponent);
 } // Shader::setMaterial(float)
 
+//--------------------------------------------------------------------------
+/**
+ Sets the material properties of one entry in the shader's
+ array of materials (only in shaders compiled for batches,
+ where each draw picks its material from the array).
+ The program must be in use.
+ 
+ @param index The index of the material in the array.
+ @param ambient The R, G, and B colour component
+ coefficients for how much ambient light to reflect.
+ @param diffuse The R, G, and B colour component
+ coefficients for how much diffuse light to reflect.
+ @param specular The R, G, and B colour component
+ coefficients for how much specular light to reflect.
+ @param specularExponent The shininess of the surface.
+ */
+void Shader::setMaterial(unsigned int index, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float specularExponent)
+{
+    // These are only set once, so look up the uniforms here
+    std::string name = "materials[" + std::to_string(index) + "].";
+    m_renderState->setUniform(m_program, glGetUniformLocation(m_program, (name + "ambient").c_str()), ambient);
+    m_renderState->setUniform(m_program, glGetUniformLocation(m_program, (name + "diffuse").c_str()), diffuse);
+    m_renderState->setUniform(m_program, glGetUniformLocation(m_program, (name + "specular").c_str()), specular);
+    m_renderState->setUniform(m_program, glGetUniformLocation(m_program, (name + "specularExponent").c_str()), specularExponent);
+} // Shader::setMaterial(unsigned int, glm::vec3, glm::vec3, glm::vec3, float)
+
 //--------------------------------------------------------------------------
 /**
  Creates a single shader from a text string (which was read
- from the original shader file). It also compiles the shader.
+ from the original shader file). It also starts compiling the
+ shader.
  
  @param text The shader program in string form.
  @shaderType The GLenum for the type of shader to create.
@@ -166,12 +390,10 @@ static GLuint createShader(const std::string& text, GLenum shaderType)
     const GLint length = (GLint)text.length();
     glShaderSource(newShader, 1, &textCStr, &length);
     
-    // Compile it
+    // Compile it (errors are checked once the program is needed,
+    // so that the driver does not have to finish compiling now)
     glCompileShader(newShader);
     
-    // Check if compiled
-    checkShaderError(newShader, GL_COMPILE_STATUS, false);
-    
     // Return the shader reference
     return newShader;
 } // createShader(const std::string&, GLenum);
@@ -189,24 +411,39 @@ static std::string loadShader(const std::string& fileName)
     std::ifstream file;
     file.open((fileName).c_str());
     
-    std::string output;
-    std::string line;
-    
+    // Read the whole file at once rather than line by line
+    std::ostringstream output;
     if(file.is_open())
     {
-        while(file.good())
-        {
-            getline(file, line);
-            output.append(line + "\n");
-        } // while
+        output << file.rdbuf();
     } // if
     else
     {
         std::cerr << "Unable to load shader: " << fileName << std::endl;
     } // else
-    return output;
+    return output.str();
 } // loadShader(const std::string&)
 
+//--------------------------------------------------------------------------
+/**
+ Adds lines of defines to the text of a shader. They have to
+ go after the "#version" line, which must be first.
+ 
+ @param text The full text of the shader file.
+ @param defines The lines to add (each ending in a newline).
+ @return The text of the shader with the defines added.
+ */
+static std::string insertDefines(const std::string& text, const std::string& defines)
+{
+    if(defines.empty())
+        return text;
+    
+    std::string::size_type endOfVersion = text.find('\n');
+    if(endOfVersion == std::string::npos)
+        return text + "\n" + defines;
+    return text.substr(0, endOfVersion + 1) + defines + text.substr(endOfVersion + 1);
+} // insertDefines(const std::string&, const std::string&)
+
 //--------------------------------------------------------------------------
 /**
  Bugfixing method to examine if there were issues compiling
@@ -18,43 +18,108 @@
 #include "Transform.hpp"
 #include "Camera.hpp"
 #include "Light.hpp"
+#include "RenderState.hpp"
+#include "ProgramCache.hpp"
+#include "LightClusters.hpp"
+
+class ShadowMap; // Includes this file, so it cannot be included here
 
 class Shader
 {
 public:
-    Shader(const std::string& fileName);
+    Shader(const std::string& fileName, RenderState* renderState, const std::string& defines = "", ProgramCache* cache = NULL);
     virtual ~Shader();
-    void bind(Light* light);
+    void bind(Light* lights, unsigned int numLights = 1);
+    void setLightClusters(LightClusters* lightClusters);
+    void setShadowMap(ShadowMap* shadowMap);
+    void use();
     void update(const Transform& transform, Camera* camera);
+    void update(const Transform& transform, const glm::mat4& viewProjection);
     void setMaterial(glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float specularExponent);
+    void setMaterial(unsigned int index, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float specularExponent);
     inline GLuint getShaderProgram() { return m_program; }
+    inline RenderState* getRenderState() { return m_renderState; }
+    
+    static const unsigned int MAX_LIGHTS = 8; // Most lights a shader can be compiled for
+    
+    // Attribute locations, fixed so that a vertex array works
+    // with every version of the shader
+    enum
+    {
+        POSITION_A,
+        NORMAL_A,
+        DRAW_DATA_A,
+        BAKED_LIGHT_A,
+        TEX_COORD_A,
+        COLOR_A
+    };
 private:
+    void finishLinking();
+    
     static const unsigned int NUM_SHADERS = 2; // Only 2 shaders: vertex and fragment shader
     
     // Enumerated type for all the uniforms sent to the GPU
     enum
     {
         MODEL_MATRIX_U,
+        NORMAL_MATRIX_U,
         VIEW_MATRIX_U,
         CAMERA_POS_U,
+        MATERIAL_SPECULAR_EXPONENT_U,
+        MATERIAL_AMBIENT_U,
+        MATERIAL_DIFFUSE_U,
+        MATERIAL_SPECULAR_U,
+        AMBIENT_LIGHT_U,
+        CLUSTER_TILE_SCALE_U,
+        CLUSTER_DEPTH_U,
+        LIGHT_DATA_U,
+        CLUSTER_GRID_U,
+        CLUSTER_LIGHTS_U,
+        STATIC_SHADOW_MAP_U,
+        DYNAMIC_SHADOW_MAP_U,
+        SHADOW_LIGHT_POS_U,
+        SHADOW_DEPTH_U,
+        
+        NUM_UNIFORMS
+    };
+    
+    // Enumerated type for the uniforms of each light
+    enum
+    {
         LIGHT_POS_U,
         LIGHT_INTENSITIES_U,
         LIGHT_AMBIENT_COEFFICIENT_U,
         LIGHT_ATTENUATION_FACTOR_A_U,
         LIGHT_ATTENUATION_FACTOR_B_U,
         LIGHT_ATTENUATION_FACTOR_C_U,
-        MATERIAL_SPECULAR_EXPONENT_U,
-        MATERIAL_AMBIENT_U,
-        MATERIAL_DIFFUSE_U,
-        MATERIAL_SPECULAR_U,
         
-        NUM_UNIFORMS
+        NUM_LIGHT_UNIFORMS
     };
     
+    // Tracks the OpenGL state so that nothing is set twice
+    RenderState* m_renderState;
+    
     // Stores the program, shaders, and uniforms
     GLuint m_program;
     GLuint m_shaders[NUM_SHADERS];
-    GLuint m_uniforms[NUM_UNIFORMS];
+    GLint m_uniforms[NUM_UNIFORMS];
+    GLint m_lightUniforms[MAX_LIGHTS][NUM_LIGHT_UNIFORMS];
+    
+    // Linking finishes the first time the program is used
+    bool m_isLinked;
+    ProgramCache* m_cache; // Where to save the program once linked (NULL if not saved)
+    uint64_t m_cacheKey;
+    float m_compileMs; // Time this thread spent compiling so far
+    
+    // Lights sorted into clusters (NULL unless compiled for them)
+    LightClusters* m_lightClusters;
+    
+    // Shadows of the first light (NULL unless compiled for them)
+    ShadowMap* m_shadowMap;
+    
+    // Lights bound before the program was linked
+    Light* m_pendingLights;
+    unsigned int m_numPendingLights;
 }; // Shader
 
 #endif /* Shader_hpp */
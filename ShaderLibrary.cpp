@@ -0,0 +1,213 @@
+/**
+ ShaderLibrary.cpp
+ Virtual Keyboard
+ Implementation of ShaderLibrary.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/17/2018
+ */
+
+#include "ShaderLibrary.hpp"
+#include "KeyBatch.hpp"
+
+//--------------------------------------------------------------------------
+/**
+ Creates an empty library. Versions of the shader are only
+ compiled the first time they are asked for, and they finish
+ compiling in the background until they are first used.
+ 
+ @param fileName The full path of the shaders WITHOUT their
+ extension.
+ @param renderState The state tracker all the shaders use.
+ @param baseFeatures Features to turn on in every version
+ (for example, SRGB_FRAMEBUFFER_F if the display has an sRGB
+ framebuffer).
+ @param cache A cache of linked programs which versions are
+ loaded from and saved to (or NULL to always compile).
+ */
+ShaderLibrary::ShaderLibrary(const std::string& fileName, RenderState* renderState, unsigned int baseFeatures, ProgramCache* cache)
+{
+    m_fileName = fileName;
+    m_renderState = renderState;
+    m_baseFeatures = baseFeatures;
+    m_cache = cache;
+    m_lights = NULL;
+    m_numLights = 0;
+    m_lightClusters = NULL;
+    m_shadowMap = NULL;
+    
+    // Let the driver compile on as many threads as it likes
+    if(GLEW_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+} // ShaderLibrary::ShaderLibrary(const std::string&, RenderState*, unsigned int, ProgramCache*)
+
+//--------------------------------------------------------------------------
+/**
+ Destroys every version of the shader.
+ */
+ShaderLibrary::~ShaderLibrary()
+{
+    for(std::map<unsigned int, Shader*>::iterator it = m_shaders.begin(); it != m_shaders.end(); ++it)
+        delete it->second;
+} // ShaderLibrary::~ShaderLibrary()
+
+//--------------------------------------------------------------------------
+/**
+ Sets the lights that the shaders light the scene with. They
+ are bound to every version already compiled, and to every
+ version compiled later.
+ 
+ @param lights An array of lights.
+ @param numLights The number of lights in the array.
+ */
+void ShaderLibrary::setLights(Light* lights, unsigned int numLights)
+{
+    m_lights = lights;
+    m_numLights = numLights < Shader::MAX_LIGHTS ? numLights : Shader::MAX_LIGHTS;
+    for(std::map<unsigned int, Shader*>::iterator it = m_shaders.begin(); it != m_shaders.end(); ++it)
+        it->second->bind(m_lights, m_numLights);
+} // ShaderLibrary::setLights(Light*, unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Makes every version of the shader (including the ones
+ compiled later) read its lights from clusters, so that each
+ fragment is only lit by the lights near it. This is meant
+ for scenes with many lights (more than Shader::MAX_LIGHTS).
+ 
+ @param lightClusters The lights sorted into clusters.
+ */
+void ShaderLibrary::setLightClusters(LightClusters* lightClusters)
+{
+    m_lightClusters = lightClusters;
+    m_baseFeatures |= CLUSTERED_LIGHTS_F;
+} // ShaderLibrary::setLightClusters(LightClusters*)
+
+//--------------------------------------------------------------------------
+/**
+ Makes every version of the shader compiled from now on
+ darken the first light where the shadow map says it is
+ blocked. Shaders which are already compiled (such as the
+ depth-only shader the shadow map is drawn with) are left
+ as they are.
+ 
+ @param shadowMap The shadow map of the first light.
+ */
+void ShaderLibrary::setShadowMap(ShadowMap* shadowMap)
+{
+    m_shadowMap = shadowMap;
+    m_baseFeatures |= SHADOWS_F;
+} // ShaderLibrary::setShadowMap(ShadowMap*)
+
+//--------------------------------------------------------------------------
+/**
+ Gets the version of the shader with the given features
+ (plus the base features), compiling it if this is the first
+ time it is needed.
+ 
+ @param features The features to turn on (bit flags).
+ @return The shader.
+ */
+Shader* ShaderLibrary::getShader(unsigned int features)
+{
+    features |= m_baseFeatures;
+    unsigned int key = features | (m_numLights << NUM_LIGHTS_SHIFT);
+    
+    std::map<unsigned int, Shader*>::iterator it = m_shaders.find(key);
+    if(it != m_shaders.end())
+        return it->second;
+    
+    Shader* shader = new Shader(m_fileName, m_renderState, getDefines(features), m_cache);
+    if(m_lights)
+        shader->bind(m_lights, m_numLights);
+    if(features & CLUSTERED_LIGHTS_F)
+        shader->setLightClusters(m_lightClusters);
+    if((features & SHADOWS_F) && !(features & DEPTH_ONLY_F))
+        shader->setShadowMap(m_shadowMap);
+    m_shaders[key] = shader;
+    return shader;
+} // ShaderLibrary::getShader(unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Gets the cheapest version of the shader which can draw a
+ material correctly (only how it reflects diffuse and
+ specular light matters).
+ 
+ @param diffuse Amount the material reflects diffuse R, G, and B light.
+ @param specular Amount the material reflects specular R, G, and B light.
+ @param extraFeatures Other features the mesh needs (such as
+ TRANSLATION_ONLY_F).
+ @return The shader.
+ */
+Shader* ShaderLibrary::getShaderForMaterial(glm::vec3 diffuse, glm::vec3 specular, unsigned int extraFeatures)
+{
+    return getShader(getFeaturesForMaterial(diffuse, specular) | extraFeatures);
+} // ShaderLibrary::getShaderForMaterial(glm::vec3, glm::vec3, unsigned int)
+
+//--------------------------------------------------------------------------
+/**
+ Works out which lighting features a material needs:
+ specular highlights only if it reflects specular light, and
+ attenuation only if it reflects diffuse or specular light
+ (ambient light is never attenuated) and some light actually
+ fades with distance. (Clustered lights are always attenuated.)
+ The ambient light and the specular exponent are uniforms, so
+ they need no features of their own.
+ 
+ @param diffuse Amount the material reflects diffuse R, G, and B light.
+ @param specular Amount the material reflects specular R, G, and B light.
+ @return The features (bit flags).
+ */
+unsigned int ShaderLibrary::getFeaturesForMaterial(glm::vec3 diffuse, glm::vec3 specular)
+{
+    const glm::vec3 black(0.0f, 0.0f, 0.0f);
+    unsigned int features = 0;
+    
+    bool hasSpecular = (specular != black);
+    if(hasSpecular)
+        features |= SPECULAR_F;
+    
+    if(hasSpecular || diffuse != black)
+    {
+        // Attenuation of (0, 0, 1) is always 1, so it can be skipped
+        for(unsigned int i = 0; i < m_numLights; i++)
+        {
+            if(m_lights[i].getAttenuationFactor() != glm::vec3(0.0f, 0.0f, 1.0f))
+                features |= ATTENUATION_F;
+        } // for
+    } // if
+    return features;
+} // ShaderLibrary::getFeaturesForMaterial(glm::vec3, glm::vec3)
+
+//--------------------------------------------------------------------------
+/**
+ Makes the lines of defines which turn on the features in
+ the shader.
+ 
+ @param features The features to turn on (bit flags).
+ @return The defines, one per line.
+ */
+std::string ShaderLibrary::getDefines(unsigned int features)
+{
+    std::string defines = "#define NUM_LIGHTS " + std::to_string(m_numLights > 0 ? m_numLights : 1) + "\n";
+    if(features & ATTENUATION_F)
+        defines += "#define ATTENUATION\n";
+    if(features & SPECULAR_F)
+        defines += "#define SPECULAR\n";
+    if(features & SRGB_FRAMEBUFFER_F)
+        defines += "#define SRGB_FRAMEBUFFER\n";
+    if(features & TRANSLATION_ONLY_F)
+        defines += "#define TRANSLATION_ONLY\n";
+    if(features & KEY_BATCH_F)
+        defines += "#define KEY_BATCH\n#define NUM_BATCH_MATERIALS " + std::to_string(KeyBatch::MAX_MATERIALS) + "\n";
+    if(features & CLUSTERED_LIGHTS_F)
+        defines += "#define CLUSTERED_LIGHTS\n" + LightClusters::getShaderDefines();
+    if(features & DEPTH_ONLY_F)
+        defines += "#define DEPTH_ONLY\n";
+    else if(features & SHADOWS_F)
+        defines += "#define SHADOWS\n";
+    if(features & BAKED_LIGHTING_F)
+        defines += "#define BAKED_LIGHTING\n";
+    return defines;
+} // ShaderLibrary::getDefines(unsigned int)
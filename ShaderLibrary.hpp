@@ -0,0 +1,86 @@
+/**
+ ShaderLibrary.hpp
+ Virtual Keyboard
+ Class which compiles versions ("permutations") of a shader with
+ different sets of features turned on through defines, and caches
+ each version by its features. It picks the cheapest version that
+ can still draw a given material correctly.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/17/2018
+ */
+
+#ifndef ShaderLibrary_hpp
+#define ShaderLibrary_hpp
+
+#include <glm/glm.hpp>
+#include <map>
+#include <string>
+#include "Shader.hpp"
+#include "Light.hpp"
+#include "RenderState.hpp"
+#include "ProgramCache.hpp"
+#include "LightClusters.hpp"
+#include "ShadowMap.hpp"
+
+class ShaderLibrary
+{
+public:
+    ShaderLibrary(const std::string& fileName, RenderState* renderState, unsigned int baseFeatures, ProgramCache* cache = NULL);
+    virtual ~ShaderLibrary();
+    
+    void setLights(Light* lights, unsigned int numLights);
+    void setLightClusters(LightClusters* lightClusters);
+    void setShadowMap(ShadowMap* shadowMap);
+    Shader* getShader(unsigned int features);
+    Shader* getShaderForMaterial(glm::vec3 diffuse, glm::vec3 specular, unsigned int extraFeatures = 0);
+    unsigned int getFeaturesForMaterial(glm::vec3 diffuse, glm::vec3 specular);
+    
+    /**
+     Gets the state tracker that all the shaders use.
+     */
+    inline RenderState* getRenderState() { return m_renderState; }
+    /**
+     Gets how many versions of the shader have been compiled.
+     */
+    inline unsigned int getNumShaders() { return (unsigned int)m_shaders.size(); }
+    
+    // Features which can be turned on in a shader (bit flags)
+    enum
+    {
+        ATTENUATION_F = 1 << 0, // Light fades with distance
+        SPECULAR_F = 1 << 1, // Shiny highlights
+        SRGB_FRAMEBUFFER_F = 1 << 2, // Framebuffer does gamma correction
+        TRANSLATION_ONLY_F = 1 << 3, // Meshes are only moved, never rotated or scaled
+        KEY_BATCH_F = 1 << 4, // Drawn by a KeyBatch
+        CLUSTERED_LIGHTS_F = 1 << 5, // Lights come from a LightClusters
+        DEPTH_ONLY_F = 1 << 6, // Only writes depth (for shadow maps)
+        SHADOWS_F = 1 << 7, // The first light casts shadows from a ShadowMap
+        BAKED_LIGHTING_F = 1 << 8 // Ambient and diffuse light come from a LightBaker
+    };
+private:
+    std::string getDefines(unsigned int features);
+    
+    // Where in the cache key the number of lights goes
+    static const int NUM_LIGHTS_SHIFT = 16;
+    
+    std::string m_fileName; // Path of the shaders without their extensions
+    RenderState* m_renderState;
+    unsigned int m_baseFeatures; // Features every version has (such as an sRGB framebuffer)
+    ProgramCache* m_cache; // Where compiled versions are saved (may be NULL)
+    
+    // The lights every version is bound to
+    Light* m_lights;
+    unsigned int m_numLights;
+    
+    // Many lights sorted into clusters (NULL to use the lights above)
+    LightClusters* m_lightClusters;
+    
+    // Shadows of the first light (NULL if there are none)
+    ShadowMap* m_shadowMap;
+    
+    // Every version compiled so far, keyed by its features and number of lights
+    std::map<unsigned int, Shader*> m_shaders;
+}; // ShaderLibrary
+
+#endif /* ShaderLibrary_hpp */
@@ -0,0 +1,189 @@
+/**
+ ShadowMap.cpp
+ Virtual Keyboard
+ Implementation of ShadowMap.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/20/2018
+ */
+
+#include "ShadowMap.hpp"
+#include <glm/gtx/transform.hpp>
+
+//--------------------------------------------------------------------------
+/**
+ Creates the two depth cube maps and the framebuffer that they
+ are drawn into. Nothing is drawn until update() is called.
+ 
+ @param depthShader A shader which only writes depth (from a
+ ShaderLibrary with the DEPTH_ONLY_F feature).
+ @param lightPosition Where the light casting the shadows is.
+ @param zNear Closest distance to the light that casts shadows.
+ @param zFar Furthest distance from the light that gets shadows.
+ @param size Width and height of each face of the cube.
+ */
+ShadowMap::ShadowMap(Shader* depthShader, const glm::vec3& lightPosition, float zNear, float zFar, int size)
+{
+    m_depthShader = depthShader;
+    m_lightPosition = lightPosition;
+    m_depthRange = glm::vec2(zNear, zFar);
+    m_size = size;
+    m_isStaticDrawn = false;
+    m_numFacesDrawn = 0;
+    
+    // A 90 degree projection, so six faces cover every direction
+    glm::mat4 projection(0.0f);
+    projection[0][0] = 1.0f;
+    projection[1][1] = 1.0f;
+    projection[2][2] = -(zFar + zNear) / (zFar - zNear);
+    projection[2][3] = -1.0f;
+    projection[3][2] = -2.0f * zFar * zNear / (zFar - zNear);
+    
+    // Directions and up vectors of the faces, in the order OpenGL numbers them
+    const glm::vec3 directions[NUM_FACES] = { glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0),
+                                              glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) };
+    const glm::vec3 ups[NUM_FACES] = { glm::vec3(0, -1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1),
+                                       glm::vec3(0, 0, -1), glm::vec3(0, -1, 0), glm::vec3(0, -1, 0) };
+    for(int face = 0; face < NUM_FACES; face++)
+    {
+        m_faceViewProjections[face] = projection * glm::lookAt(lightPosition, lightPosition + directions[face], ups[face]);
+        m_faceFrustums[face].update(m_faceViewProjections[face]);
+        for(int layer = 0; layer < NUM_LAYERS; layer++)
+            m_faceHasCasters[layer][face] = true; // Cleared on the first update
+    } // for
+    
+    // Depth cube maps which compare depths when sampled (and
+    // blend the results of the four nearest texels)
+    glGenTextures(NUM_LAYERS, m_textures);
+    for(int layer = 0; layer < NUM_LAYERS; layer++)
+    {
+        glBindTexture(GL_TEXTURE_CUBE_MAP, m_textures[layer]);
+        for(int face = 0; face < NUM_FACES; face++)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT24, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    } // for
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS); // Filter across the edges of faces
+    
+    // The framebuffer only has depth
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+} // ShadowMap::ShadowMap(Shader*, const glm::vec3&, float, float, int)
+
+//--------------------------------------------------------------------------
+/**
+ Destroys the cube maps and the framebuffer.
+ */
+ShadowMap::~ShadowMap()
+{
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteTextures(NUM_LAYERS, m_textures);
+} // ShadowMap::~ShadowMap()
+
+//--------------------------------------------------------------------------
+/**
+ Redraws whichever layers are out of date. The static layer
+ is only redrawn when the set of resting casters changes, and
+ the dynamic layer only when a moving caster moved (or the set
+ of moving casters changed).
+ 
+ @param restingCasters Meshes which are not moving (in the
+ same order every frame).
+ @param movingCasters Meshes which may move.
+ */
+void ShadowMap::update(const std::vector<Mesh*>& restingCasters, const std::vector<Mesh*>& movingCasters)
+{
+    m_numFacesDrawn = 0;
+    
+    bool staticChanged = !m_isStaticDrawn || restingCasters != m_lastResting;
+    bool dynamicChanged = movingCasters != m_lastMoving;
+    for(unsigned int i = 0; i < movingCasters.size() && !dynamicChanged; i++)
+        dynamicChanged = (movingCasters[i]->getTransform()->getPos() != m_lastMovingPositions[i]);
+    if(!staticChanged && !dynamicChanged)
+        return;
+    
+    // Remember the viewport and framebuffer being drawn to (the
+    // window's, or an offscreen one) to put them back afterwards
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLint framebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glViewport(0, 0, m_size, m_size);
+    
+    if(staticChanged)
+    {
+        drawLayer(STATIC_LAYER, restingCasters);
+        m_lastResting = restingCasters;
+        m_isStaticDrawn = true;
+    } // if
+    if(dynamicChanged)
+    {
+        drawLayer(DYNAMIC_LAYER, movingCasters);
+        m_lastMoving = movingCasters;
+        m_lastMovingPositions.resize(movingCasters.size());
+        for(unsigned int i = 0; i < movingCasters.size(); i++)
+            m_lastMovingPositions[i] = movingCasters[i]->getTransform()->getPos();
+    } // if
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+} // ShadowMap::update(const std::vector<Mesh*>&, const std::vector<Mesh*>&)
+
+//--------------------------------------------------------------------------
+/**
+ Binds the two layers to their texture units, where the
+ shaders read them from.
+ */
+void ShadowMap::bindTextures()
+{
+    glActiveTexture(GL_TEXTURE0 + STATIC_SHADOW_UNIT);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_textures[STATIC_LAYER]);
+    glActiveTexture(GL_TEXTURE0 + DYNAMIC_SHADOW_UNIT);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_textures[DYNAMIC_LAYER]);
+    glActiveTexture(GL_TEXTURE0);
+} // ShadowMap::bindTextures()
+
+//--------------------------------------------------------------------------
+/**
+ Draws the depth of some casters into the faces of one layer.
+ Faces that none of the casters are on are skipped, unless
+ they still have old casters in them that must be cleared.
+ The shadow map's framebuffer must be bound.
+ 
+ @param layer The layer to draw (STATIC_LAYER or DYNAMIC_LAYER).
+ @param casters The meshes to draw.
+ */
+void ShadowMap::drawLayer(int layer, const std::vector<Mesh*>& casters)
+{
+    for(int face = 0; face < NUM_FACES; face++)
+    {
+        m_visible.clear();
+        for(unsigned int i = 0; i < casters.size(); i++)
+        {
+            glm::vec3 boundsMin;
+            glm::vec3 boundsMax;
+            casters[i]->getWorldBounds(boundsMin, boundsMax);
+            if(m_faceFrustums[face].boxIsVisible(boundsMin, boundsMax))
+                m_visible.push_back(casters[i]);
+        } // for
+        if(m_visible.empty() && !m_faceHasCasters[layer][face])
+            continue;
+        
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, m_textures[layer], 0);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        for(unsigned int i = 0; i < m_visible.size(); i++)
+            m_visible[i]->drawDepth(m_depthShader, m_faceViewProjections[face]);
+        m_faceHasCasters[layer][face] = !m_visible.empty();
+        m_numFacesDrawn++;
+    } // for
+} // ShadowMap::drawLayer(int, const std::vector<Mesh*>&)
@@ -0,0 +1,90 @@
+/**
+ ShadowMap.hpp
+ Virtual Keyboard
+ Class for a cube shadow map around a point light, kept in two
+ layers: a static layer with the keys at rest, which is only
+ redrawn when a key leaves or returns to rest, and a dynamic
+ layer with just the keys that are pressed, which is redrawn
+ only when one of them moves (and only on the cube faces they
+ are on). The shader is in shadow where either layer says so,
+ so shadows cost almost nothing while the keyboard is idle.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/20/2018
+ */
+
+#ifndef ShadowMap_hpp
+#define ShadowMap_hpp
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "Mesh.hpp"
+#include "Shader.hpp"
+#include "Frustum.hpp"
+
+class ShadowMap
+{
+public:
+    ShadowMap(Shader* depthShader, const glm::vec3& lightPosition, float zNear, float zFar, int size);
+    virtual ~ShadowMap();
+    
+    void update(const std::vector<Mesh*>& restingCasters, const std::vector<Mesh*>& movingCasters);
+    void bindTextures();
+    
+    /**
+     Gets the position of the light casting the shadows.
+     */
+    inline const glm::vec3& getLightPosition() { return m_lightPosition; }
+    /**
+     Gets the near and far planes of the cube faces.
+     */
+    inline const glm::vec2& getDepthRange() { return m_depthRange; }
+    /**
+     Gets how many cube faces were drawn in the last update
+     (zero while nothing moves).
+     */
+    inline unsigned int getNumFacesDrawn() { return m_numFacesDrawn; }
+    
+    // Texture units the layers are bound to
+    static const int STATIC_SHADOW_UNIT = 4;
+    static const int DYNAMIC_SHADOW_UNIT = 5;
+private:
+    // The layers of the shadow map
+    enum {
+        STATIC_LAYER,
+        DYNAMIC_LAYER,
+        
+        NUM_LAYERS
+    }; // enum
+    
+    static const int NUM_FACES = 6;
+    
+    void drawLayer(int layer, const std::vector<Mesh*>& casters);
+    
+    Shader* m_depthShader; // Shader which only writes depth
+    GLuint m_framebuffer;
+    GLuint m_textures[NUM_LAYERS]; // Depth cube maps
+    int m_size; // Width and height of each face
+    
+    glm::vec3 m_lightPosition;
+    glm::vec2 m_depthRange;
+    
+    // Where each face of the cube is drawn from
+    glm::mat4 m_faceViewProjections[NUM_FACES];
+    Frustum m_faceFrustums[NUM_FACES];
+    bool m_faceHasCasters[NUM_LAYERS][NUM_FACES]; // Face must be cleared if it stops having casters
+    
+    // What each layer was last drawn with (to tell if it must be redrawn)
+    std::vector<Mesh*> m_lastResting;
+    std::vector<Mesh*> m_lastMoving;
+    std::vector<glm::vec3> m_lastMovingPositions;
+    bool m_isStaticDrawn;
+    
+    std::vector<Mesh*> m_visible; // Casters visible from one face (reused)
+    unsigned int m_numFacesDrawn;
+}; // ShadowMap
+
+#endif /* ShadowMap_hpp */
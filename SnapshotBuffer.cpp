@@ -0,0 +1,50 @@
+/**
+ SnapshotBuffer.cpp
+ Virtual Keyboard
+ Implementation of SnapshotBuffer.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/26/2018
+ */
+
+#include "SnapshotBuffer.hpp"
+
+//--------------------------------------------------------------------------
+/**
+ Creates the buffer with nothing published yet.
+ */
+SnapshotBuffer::SnapshotBuffer()
+{
+    m_back = 0;
+    m_front = 1;
+    m_middle.store(2, std::memory_order_relaxed);
+} // SnapshotBuffer::SnapshotBuffer()
+
+//--------------------------------------------------------------------------
+/**
+ Publishes the back snapshot, replacing any snapshot published
+ before that the render thread has not taken yet, and starts a
+ new back snapshot. Only the main thread may call this.
+ */
+void SnapshotBuffer::publish()
+{
+    unsigned int old = m_middle.exchange(m_back | IS_NEW, std::memory_order_acq_rel);
+    m_back = old & ~IS_NEW;
+} // SnapshotBuffer::publish()
+
+//--------------------------------------------------------------------------
+/**
+ Takes the latest published snapshot as the front snapshot, if
+ one was published since the last call. Only the render thread
+ may call this.
+ 
+ @return True if there is a new front snapshot.
+ */
+bool SnapshotBuffer::acquire()
+{
+    if(!(m_middle.load(std::memory_order_relaxed) & IS_NEW))
+        return false;
+    unsigned int old = m_middle.exchange(m_front, std::memory_order_acq_rel);
+    m_front = old & ~IS_NEW;
+    return true;
+} // SnapshotBuffer::acquire()
@@ -0,0 +1,67 @@
+/**
+ SnapshotBuffer.hpp
+ Virtual Keyboard
+ Class which hands snapshots of the simulation (where the
+ camera is, how far down each key is) from the main thread to
+ the render thread without any locks. The main thread fills
+ the back snapshot and publishes it; the render thread takes
+ the latest published one as its front snapshot and draws it.
+ A third, middle slot is swapped between the two with one
+ atomic exchange, so neither thread ever waits for the other
+ and a snapshot is never changed while it is being drawn.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/26/2018
+ */
+
+#ifndef SnapshotBuffer_hpp
+#define SnapshotBuffer_hpp
+
+#include <atomic>
+#include <chrono>
+#include <glm/glm.hpp>
+#include "KeyboardKeys.hpp"
+
+// Everything the render thread needs to draw one frame
+struct FrameSnapshot
+{
+    glm::vec3 cameraPos; // Where the camera is drawn from
+    float cameraXRot;
+    float cameraYRot;
+    std::chrono::steady_clock::time_point inputTime; // When the mouse motion of the rotation was handled
+    float aspect;
+    int width; // Size of the window's drawable area
+    int height;
+    signed char keyLevels[KeyboardLayout::MAX_KEYS]; // From the lowest note up
+    bool isHudVisible;
+    bool isRecording;
+    unsigned int numScreenshots; // Screenshots asked for so far
+}; // FrameSnapshot
+
+class SnapshotBuffer
+{
+public:
+    SnapshotBuffer();
+    
+    void publish();
+    bool acquire();
+    
+    /**
+     Gets the snapshot the main thread fills before publish().
+     */
+    inline FrameSnapshot& getBack() { return m_slots[m_back]; }
+    /**
+     Gets the snapshot the render thread took with acquire().
+     */
+    inline const FrameSnapshot& getFront() { return m_slots[m_front]; }
+private:
+    static const unsigned int NUM_SLOTS = 3;
+    static const unsigned int IS_NEW = 4; // Set in m_middle when it holds a snapshot not yet acquired
+    
+    FrameSnapshot m_slots[NUM_SLOTS];
+    unsigned int m_back; // Only used by the main thread
+    unsigned int m_front; // Only used by the render thread
+    std::atomic<unsigned int> m_middle; // Index of the slot between them (and IS_NEW)
+}; // SnapshotBuffer
+
+#endif /* SnapshotBuffer_hpp */
@@ -0,0 +1,123 @@
+/**
+ StressTest.cpp
+ Virtual Keyboard
+ Implementation of StressTest.hpp.
+ 
+ @author Graeme Zinck
+ @version 1.0 5/2/2018
+ */
+
+#include "StressTest.hpp"
+#include "PerformanceHud.hpp"
+#include <iomanip>
+#include <math.h>
+
+//--------------------------------------------------------------------------
+/**
+ Creates a stress test of a display's keys.
+ 
+ @param display The display which draws the frames.
+ @param camera The camera which flies over the keyboards.
+ @param keys The keys, which are copied onto a grid.
+ @param renderState The state tracker which counts the draw calls.
+ */
+StressTest::StressTest(Display* display, Camera* camera, KeyboardKeys* keys, RenderState* renderState)
+{
+    m_display = display;
+    m_camera = camera;
+    m_keys = keys;
+    m_renderState = renderState;
+} // StressTest::StressTest(Display*, Camera*, KeyboardKeys*, RenderState*)
+
+//--------------------------------------------------------------------------
+/**
+ Draws FRAMES_PER_STEP frames for each number of keyboards in
+ 1, 2, 5, 10, 20, 50, ... up to the maximum (and the maximum
+ itself), printing one line for each. The keyboard is left as
+ one keyboard afterwards.
+ 
+ @param maxKeyboards The most keyboards to draw.
+ @param out The stream to print to.
+ */
+void StressTest::run(unsigned int maxKeyboards, std::ostream& out)
+{
+    out << "Stress test (" << FRAMES_PER_STEP << " frames each, medians per frame):" << std::endl;
+    out << "keyboards,keys,cpu_ms,cpu_p95_ms,gpu_ms,draw_calls,keys_drawn,keys_culled,groups_culled,keyboards_culled,memory_mb" << std::endl;
+    
+    const unsigned int STEPS[3] = { 1, 2, 5 };
+    unsigned int numKeyboards = 1;
+    for(unsigned int scale = 1; numKeyboards < maxKeyboards; scale *= 10)
+    {
+        for(unsigned int i = 0; i < 3 && STEPS[i] * scale < maxKeyboards; i++)
+        {
+            numKeyboards = STEPS[i] * scale;
+            runStep(numKeyboards, out);
+        } // for
+        numKeyboards = 10 * scale;
+    } // for
+    runStep(maxKeyboards, out);
+    
+    m_keys->setNumKeyboards(1);
+} // StressTest::run(unsigned int, std::ostream&)
+
+//--------------------------------------------------------------------------
+/**
+ Draws one grid of keyboards while the camera moves from the
+ left end of the first row to the right end, turning around
+ once (so at times most of the grid is behind it), and prints
+ the results. Each frame is finished before the next one is
+ started (instead of swapping the buffers, so the frame rate
+ is not held to the display's), and the same path is flown
+ every time, so the results can be compared between runs.
+ 
+ @param numKeyboards How many keyboards to draw.
+ @param out The stream to print to.
+ */
+void StressTest::runStep(unsigned int numKeyboards, std::ostream& out)
+{
+    m_keys->setNumKeyboards(numKeyboards);
+    float width = m_keys->getGridWidth();
+    
+    FrameTimer* frameTimer = m_display->getFrameTimer();
+    FrameSnapshot snapshot;
+    unsigned long long numDrawCalls = 0;
+    unsigned long long numKeysDrawn = 0;
+    unsigned long long numKeysCulled = 0;
+    unsigned long long numGroupsCulled = 0;
+    unsigned long long numKeyboardsCulled = 0;
+    for(unsigned int frame = 0; frame < FRAMES_PER_STEP; frame++)
+    {
+        float t = (float)frame / FRAMES_PER_STEP;
+        m_camera->setPose(glm::vec3(width * t, CAMERA_HEIGHT, CAMERA_Z), (float)(2.0 * M_PI) * t, CAMERA_PITCH);
+        
+        m_renderState->resetNumDrawCalls();
+        frameTimer->beginFrame();
+        m_display->takeSnapshot(snapshot);
+        m_display->drawScene(snapshot);
+        frameTimer->beginSwap();
+        glFinish();
+        frameTimer->endFrame();
+        
+        numDrawCalls += m_renderState->getNumDrawCalls();
+        numKeysDrawn += m_keys->getNumKeysDrawn();
+        numKeysCulled += m_keys->getNumKeysCulled();
+        numGroupsCulled += m_keys->getNumGroupsCulled();
+        numKeyboardsCulled += m_keys->getNumKeyboardsCulled();
+    } // for
+    
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2)
+        << numKeyboards << "," << numKeyboards * m_keys->getNumKeys() << ","
+        << frameTimer->getPercentile(FrameTimer::CPU_FRAME_M, 50.0f) << ","
+        << frameTimer->getPercentile(FrameTimer::CPU_FRAME_M, 95.0f) << ","
+        << frameTimer->getPercentile(FrameTimer::GPU_FRAME_M, 50.0f) << ","
+        << (float)numDrawCalls / FRAMES_PER_STEP << ","
+        << (float)numKeysDrawn / FRAMES_PER_STEP << ","
+        << (float)numKeysCulled / FRAMES_PER_STEP << ","
+        << (float)numGroupsCulled / FRAMES_PER_STEP << ","
+        << (float)numKeyboardsCulled / FRAMES_PER_STEP << ","
+        << PerformanceHud::getMemoryInUse() << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+} // StressTest::runStep(unsigned int, std::ostream&)
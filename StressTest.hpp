@@ -0,0 +1,49 @@
+/**
+ StressTest.hpp
+ Virtual Keyboard
+ Class which measures how drawing scales with the size of the
+ scene. It draws grids of more and more copies of the keyboard
+ (1, 2, 5, 10, 20, 50, ... keyboards) with the camera flying
+ the same path over each one, and reports the frame times, the
+ draw calls, how much was culled, and the memory in use for
+ each number of keyboards, so that runs can be compared.
+ 
+ @author Graeme Zinck
+ @version 1.0 5/2/2018
+ */
+
+#ifndef StressTest_hpp
+#define StressTest_hpp
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <ostream>
+#include "Display.hpp"
+#include "Camera.hpp"
+#include "KeyboardKeys.hpp"
+#include "RenderState.hpp"
+
+class StressTest
+{
+public:
+    StressTest(Display* display, Camera* camera, KeyboardKeys* keys, RenderState* renderState);
+    
+    void run(unsigned int maxKeyboards, std::ostream& out);
+    
+    static const unsigned int FRAMES_PER_STEP = 240; // As many as the frame timer keeps times for
+private:
+    void runStep(unsigned int numKeyboards, std::ostream& out);
+    
+    // The path the camera flies over each grid
+    const float CAMERA_HEIGHT = 20.0f;
+    const float CAMERA_Z = 20.0f; // In front of the first row
+    const float CAMERA_PITCH = -0.5f; // Looking down at the keys
+    
+    Display* m_display;
+    Camera* m_camera;
+    KeyboardKeys* m_keys;
+    RenderState* m_renderState;
+}; // StressTest
+
+#endif /* StressTest_hpp */
@@ -19,6 +19,7 @@ Transform::Transform()
     m_pos = glm::vec3();
     m_rot = glm::vec3();
     m_scale = glm::vec3(1.0f, 1.0f, 1.0f);
+    m_isDirty = true;
 } // Transform::Transform()
 
 //--------------------------------------------------------------------------
@@ -34,6 +35,7 @@ Transform::Transform(const glm::vec3& pos, const glm::vec3& rot, const glm::vec3
     m_pos = pos;
     m_rot = rot;
     m_scale = scale;
+    m_isDirty = true;
 } // Transform::Transform(const glm::vec3&, const glm::vec3&, const glm::vec3&)
 
 //--------------------------------------------------------------------------
@@ -43,10 +45,58 @@ Transform::Transform(const glm::vec3& pos, const glm::vec3& rot, const glm::vec3
  
  @return The model matrix for the transform.
  */
-glm::mat4 Transform::getModel() const
+const glm::mat4& Transform::getModel() const
+{
+    if(m_isDirty)
+        updateMatrices();
+    return m_model;
+} // Transform::getModel()
+
+//--------------------------------------------------------------------------
+/**
+ Gets the matrix which transforms normals into world
+ coordinates (the inverse transpose of the rotation and
+ scaling part of the model matrix).
+ 
+ @return The normal matrix for the transform.
+ */
+const glm::mat3& Transform::getNormalMatrix() const
+{
+    if(m_isDirty)
+        updateMatrices();
+    return m_normalMatrix;
+} // Transform::getNormalMatrix()
+
+//--------------------------------------------------------------------------
+/**
+ Checks if the transform only moves things (no rotation
+ and no scaling), in which case normals don't change.
+ 
+ @return True if the transform is only a translation.
+ */
+bool Transform::isTranslationOnly() const
+{
+    return m_rot == glm::vec3(0.0f, 0.0f, 0.0f) && m_scale == glm::vec3(1.0f, 1.0f, 1.0f);
+} // Transform::isTranslationOnly()
+
+//--------------------------------------------------------------------------
+/**
+ Recomputes the model and normal matrices after the
+ transform has changed.
+ */
+void Transform::updateMatrices() const
 {
     glm::mat4 posMatrix = glm::translate(m_pos);
     
+    if(isTranslationOnly())
+    {
+        // No need for any rotating, scaling, or inverting
+        m_model = posMatrix;
+        m_normalMatrix = glm::mat3(1.0f);
+        m_isDirty = false;
+        return;
+    } // if
+    
     // Rotation
     glm::mat4 rotXMatrix = glm::rotate(m_rot.x, glm::vec3(1,0,0));
     glm::mat4 rotYMatrix = glm::rotate(m_rot.y, glm::vec3(0,1,0));
@@ -55,5 +105,7 @@ glm::mat4 Transform::getModel() const
     
     glm::mat4 scaleMatrix = glm::scale(m_scale);
     
-    return posMatrix * rotMatrix * scaleMatrix;
-} // Transform::getModel()
+    m_model = posMatrix * rotMatrix * scaleMatrix;
+    m_normalMatrix = glm::transpose(glm::inverse(glm::mat3(m_model))); // To remove the scaling and translation
+    m_isDirty = false;
+} // Transform::updateMatrices()
@@ -19,68 +19,77 @@ class Transform
 public:
     Transform();
     Transform(const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scale);
-    glm::mat4 getModel() const;
+    const glm::mat4& getModel() const;
+    const glm::mat3& getNormalMatrix() const;
+    bool isTranslationOnly() const;
     
     /**
      Gets the position of the transformation.
      */
-    inline glm::vec3& getPos() { return m_pos; }
+    inline const glm::vec3& getPos() const { return m_pos; }
     /**
      Gets the rotation of the transformation.
      */
-    inline glm::vec3& getRot() { return m_rot; }
+    inline const glm::vec3& getRot() const { return m_rot; }
     /**
      Gets the scale of the transformation.
      */
-    inline glm::vec3& getScale() { return m_scale; }
+    inline const glm::vec3& getScale() const { return m_scale; }
     
     /**
      Sets the position.
      
      @param pos The position to set it to.
      */
-    inline void setPos(const glm::vec3& pos) { m_pos = pos; }
+    inline void setPos(const glm::vec3& pos) { m_pos = pos; m_isDirty = true; }
     /**
      Sets the rotation.
      
      @param rot The rotation to set it to.
      */
-    inline void setRot(const glm::vec3& rot) { m_rot = rot; }
+    inline void setRot(const glm::vec3& rot) { m_rot = rot; m_isDirty = true; }
     /*
      Sets the scale.
      
      @param scale The scale to set it to.
      */
-    inline void setScale(const glm::vec3& scale) { m_scale = scale; }
+    inline void setScale(const glm::vec3& scale) { m_scale = scale; m_isDirty = true; }
     
     /**
      Moves the transform right.
      
      @param offset Distance to move.
      */
-    inline void moveRight(double offset) { m_pos.x = m_pos.x + offset; };
+    inline void moveRight(double offset) { m_pos.x = m_pos.x + offset; m_isDirty = true; };
     /**
      Moves the transform left.
      
      @param offset Distance to move.
      */
-    inline void moveLeft(double offset) { m_pos.x = m_pos.x - offset; };
+    inline void moveLeft(double offset) { m_pos.x = m_pos.x - offset; m_isDirty = true; };
     /**
      Moves the transform up.
      
      @param offset Distance to move.
      */
-    inline void moveUp(double offset) { m_pos.y = m_pos.y + offset; };
+    inline void moveUp(double offset) { m_pos.y = m_pos.y + offset; m_isDirty = true; };
     /**
      Moves the transform down.
      
      @param offset Distance to move.
      */
-    inline void moveDown(double offset) { m_pos.y = m_pos.y - offset; };
+    inline void moveDown(double offset) { m_pos.y = m_pos.y - offset; m_isDirty = true; };
 private:
+    void updateMatrices() const;
+    
     glm::vec3 m_pos;
     glm::vec3 m_rot;
     glm::vec3 m_scale;
+    
+    // Matrices are only recomputed when the transform changes
+    mutable bool m_isDirty;
+    mutable glm::mat4 m_model;
+    mutable glm::mat3 m_normalMatrix;
 }; // Transform
 
 #endif /* Transform_hpp */
@@ -23,6 +23,25 @@
 #include "Camera.hpp"
 #include "Light.hpp"
 #include "KeyboardKeys.hpp"
+#include "KeyboardLayout.hpp"
+#include "KeyBatch.hpp"
+#include "PackedVertices.hpp"
+#include "RenderState.hpp"
+#include "ShaderLibrary.hpp"
+#include "ProgramCache.hpp"
+#include "LightClusters.hpp"
+#include "ShadowMap.hpp"
+#include "PerformanceHud.hpp"
+#include "FrameCapture.hpp"
+#include "Session.hpp"
+#include "OfflineRenderer.hpp"
+#include "StressTest.hpp"
+#include "SamplePool.hpp"
+#include "AiffLoader.hpp"
+#include "Envelope.hpp"
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
 #include <SDL2_mixer/SDL_mixer.h>
 
 #define WIDTH 800
@@ -31,9 +50,34 @@
 #define Z_NEAR 0.01f
 #define Z_FAR 1000.0f
 #define SHADER_NAME "/basicShader"
+#define SHADER_CACHE_FOLDER "/shader_cache"
+#define HUD_SHADER_NAME "/hudShader"
+#define CAPTURE_FOLDER "capture"
+#define SESSION_WAV_NAME "/session.wav"
+#define SHADOW_Z_NEAR 0.1f
+#define SHADOW_Z_FAR 200.0f
+#define SHADOW_MAP_SIZE 1024
 
 /**
  Begins the application.
+ Run with "--stage-lights N" to light the keyboard with N
+ coloured stage lights as well (using clustered lights), with
+ "--hud" to show the performance overlay, with "--record" to
+ start recording right away, and with "--raw" to record raw
+ video instead of PNG files. Run with "--record-session FILE"
+ to save what the camera did to a file, and with
+ "--render-session FILE" to render such a file offline at 60
+ frames per second (with its sound) instead of opening the
+ window. Run with "--half-positions" to store the keys' vertex
+ positions as half floats, and with "--keys RANGE" to play a
+ keyboard with 25, 49, 61, 76 or 88 keys (e.g. "--keys 61") or
+ from one MIDI note to another (e.g. "--keys 36-96"). Run with
+ "--stress N" to measure how drawing scales with up to N copies
+ of the keyboard on a grid, instead of playing, and with
+ "--benchmark-aiff" to time loading the key sounds with SDL
+ Mixer and with AiffLoader at startup. Run with
+ "--organ-envelope A,D,S,R" or "--piano-envelope A,D,S,R" to
+ change the volume envelope of the notes of that sound.
  
  @return Zero if the program quit successfully.
 */
@@ -48,30 +92,204 @@ int main(int argc, char * argv[]) {
     std::cout << "Use the mouse to move around." << std::endl;
     std::cout << "Press F to switch to full-screen mode." << std::endl;
     std::cout << "Press K to switch the sounds from organ to piano and back." << std::endl;
+    std::cout << "Press H to show or hide the performance overlay (with --hud)." << std::endl;
+    std::cout << "Press P to save a screenshot, and R to start or stop recording." << std::endl;
     std::cout << "Press ESC to exit." << std::endl;
     
+    // Read the command-line options
+    unsigned int numStageLights = 0;
+    bool showHud = false;
+    bool startRecording = false;
+    int captureFormat = FrameCapture::PNG_SEQUENCE;
+    std::string recordSessionPath;
+    std::string renderSessionPath;
+    unsigned int lowestNote = KeyboardLayout::LOWEST_PIANO_NOTE;
+    unsigned int highestNote = KeyboardLayout::HIGHEST_PIANO_NOTE;
+    unsigned int maxStressKeyboards = 0;
+    bool benchmarkAiff = false;
+    std::string envelopes[OneKeyboardKey::NUM_SOUNDS]; // Empty for the default envelope
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--stage-lights") == 0 && i + 1 < argc)
+            numStageLights = (unsigned int)atoi(argv[i + 1]);
+        else if(strcmp(argv[i], "--hud") == 0)
+            showHud = true;
+        else if(strcmp(argv[i], "--record") == 0)
+            startRecording = true;
+        else if(strcmp(argv[i], "--raw") == 0)
+            captureFormat = FrameCapture::RAW_VIDEO;
+        else if(strcmp(argv[i], "--record-session") == 0 && i + 1 < argc)
+            recordSessionPath = argv[i + 1];
+        else if(strcmp(argv[i], "--render-session") == 0 && i + 1 < argc)
+            renderSessionPath = argv[i + 1];
+        else if(strcmp(argv[i], "--half-positions") == 0)
+            PackedVertices::useHalfPositions(true);
+        else if(strcmp(argv[i], "--keys") == 0 && i + 1 < argc)
+        {
+            if(!KeyboardLayout::parseRange(argv[i + 1], lowestNote, highestNote))
+                std::cerr << "Unknown key range " << argv[i + 1] << ", using 88 keys." << std::endl;
+        } // else if
+        else if(strcmp(argv[i], "--stress") == 0 && i + 1 < argc)
+            maxStressKeyboards = (unsigned int)atoi(argv[i + 1]);
+        else if(strcmp(argv[i], "--benchmark-aiff") == 0)
+            benchmarkAiff = true;
+        else if(strcmp(argv[i], "--organ-envelope") == 0 && i + 1 < argc)
+            envelopes[OneKeyboardKey::ORGAN_SOUND] = argv[i + 1];
+        else if(strcmp(argv[i], "--piano-envelope") == 0 && i + 1 < argc)
+            envelopes[OneKeyboardKey::PIANO_SOUND] = argv[i + 1];
+    } // for
+    
+    // Where every key goes, worked out once for the range asked for
+    KeyboardLayout layout(lowestNote, highestNote);
+    
+    // An offline render is drawn offscreen, and its sound is mixed
+    // by hand, so neither the window nor the speakers are needed
+    bool isOffline = !renderSessionPath.empty();
+    if(isOffline)
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    
     // Creeate the display
-    Display display(WIDTH, HEIGHT, "Virtual Keyboard");
+    Display display(WIDTH, HEIGHT, "Virtual Keyboard", isOffline);
     
     // Create a light object and a camera object
     Light light(glm::vec3(10,3,10), glm::vec3(1, 1, 1), 0.2, glm::vec3(0.0001, 0.001, 1));
+    
+    // Add coloured stage lights in a row above the keys if asked
+    std::vector<Light> lights(1, light);
+    const glm::vec3 STAGE_COLOURS[6] = { glm::vec3(1, 0.2, 0.2), glm::vec3(1, 0.6, 0.1), glm::vec3(1, 1, 0.2),
+                                         glm::vec3(0.2, 1, 0.3), glm::vec3(0.2, 0.4, 1), glm::vec3(0.8, 0.2, 1) };
+    for(unsigned int i = 0; i < numStageLights; i++)
+    {
+        float x = layout.getLength() * (i + 0.5f) / numStageLights;
+        lights.push_back(Light(glm::vec3(x, 4, -7), STAGE_COLOURS[i % 6], 0.0, glm::vec3(0.5, 0.2, 1)));
+    } // for
+    
     Camera camera(glm::vec3(0,5,10), FIELD_OF_VIEW, display.getAspectRatio(), Z_NEAR, Z_FAR);
 
-    // Create the shader using the given path.
-    Shader shader(resPath + SHADER_NAME);
-    shader.bind(&light);
+    // Keeps track of the OpenGL state so that nothing is set twice
+    RenderState renderState;
+    
+    // Compiles a version of the shader for each set of features
+    // that is needed (gamma correction is left to the framebuffer
+    // when it can do it). Linked versions are saved to disk so
+    // later launches can skip compiling them.
+    ProgramCache programCache(resPath + SHADER_CACHE_FOLDER);
+    unsigned int baseFeatures = display.hasSrgbFramebuffer() ? ShaderLibrary::SRGB_FRAMEBUFFER_F : 0;
+    ShaderLibrary shaders(resPath + SHADER_NAME, &renderState, baseFeatures, &programCache);
+    shaders.setLights(&light, 1);
     
-    // Create the keyboard keys
-    KeyboardKeys keys(&shader, resPath);
+    // With many lights, each fragment only uses the lights near it
+    LightClusters* lightClusters = NULL;
+    if(numStageLights > 0)
+    {
+        lightClusters = new LightClusters();
+        lightClusters->setLights(&lights[0], (unsigned int)lights.size());
+        shaders.setLightClusters(lightClusters);
+        display.setLightClusters(lightClusters);
+    } // if
+    
+    // The main light casts shadows, which are only redrawn where
+    // keys have moved
+    ShadowMap shadowMap(shaders.getShader(ShaderLibrary::DEPTH_ONLY_F), light.getPos(), SHADOW_Z_NEAR, SHADOW_Z_FAR, SHADOW_MAP_SIZE);
+    shaders.setShadowMap(&shadowMap);
+    
+    // Create the keyboard keys, and draw them all in one batch
+    // if the graphics card supports it
+    KeyboardKeys keys(&shaders, resPath, layout);
+    for(unsigned int sound = 0; sound < OneKeyboardKey::NUM_SOUNDS; sound++)
+    {
+        EnvelopeShape shape;
+        if(envelopes[sound].empty())
+            continue;
+        if(Envelope::parseShape(envelopes[sound], shape))
+            keys.setEnvelope(sound, shape);
+        else
+            std::cerr << "Unknown envelope " << envelopes[sound] << ", using the default." << std::endl;
+    } // for
+    if(KeyBatch::isSupported())
+        keys.useBatchRendering();
+    
+    // None of the lights move, so the lighting of keys at rest
+    // only has to be worked out once (but only where the keys are,
+    // so not for the copies of the stress test)
+    if(maxStressKeyboards == 0)
+        keys.bakeLighting(&lights[0], (unsigned int)lights.size());
+    keys.reportGeometry(std::cout);
+    SamplePool::report(std::cout);
+    if(benchmarkAiff)
+    {
+        std::vector<std::string> soundPaths;
+        keys.getSoundPaths(soundPaths);
+        AiffLoader::benchmark(soundPaths, std::cout);
+    } // if
+    std::cout << "Built " << shaders.getNumShaders() << " shader version(s)." << std::endl;
+    if(programCache.isEnabled())
+        std::cout << "Shader cache: " << programCache.getNumHits() << " hit(s), " << programCache.getNumMisses() << " miss(es), " << programCache.getMsSaved() << " ms saved." << std::endl;
     
     // Link the display to the camera and the keys
     display.setCamera(&camera);
     display.setKeyboardKeys(&keys);
+    display.setShadowMap(&shadowMap);
+    display.setRenderState(&renderState);
+    
+    // Show the performance overlay if asked (H shows and hides it),
+    // but not in the stress test, which counts the draw calls itself
+    PerformanceHud* hud = NULL;
+    if(showHud && maxStressKeyboards == 0)
+    {
+        hud = new PerformanceHud(resPath + HUD_SHADER_NAME, &renderState, &programCache);
+        hud->setVisible(true);
+        display.setPerformanceHud(hud);
+    } // if
+    
+    // Screenshots and recordings are read back without stalling
+    // and saved on another thread
+    FrameCapture frameCapture(CAPTURE_FOLDER, captureFormat);
+    display.setFrameCapture(&frameCapture);
+    if(startRecording)
+        frameCapture.startRecording();
+    
+    // Render a recorded session offline if asked, or else run
+    // interactively (recording the session if asked)
+    Session session;
+    if(maxStressKeyboards > 0)
+    {
+        StressTest stressTest(&display, &camera, &keys, &renderState);
+        stressTest.run(maxStressKeyboards, std::cout);
+    } // if
+    else if(isOffline)
+    {
+        if(session.load(renderSessionPath))
+        {
+            OfflineRenderer renderer(&display, &camera, &keys, WIDTH, HEIGHT);
+            renderer.render(&session, &frameCapture, std::string(CAPTURE_FOLDER) + SESSION_WAV_NAME);
+        } // if
+        else
+            std::cout << "Could not load the session " << renderSessionPath << std::endl;
+    } // else if
+    else
+    {
+        if(!recordSessionPath.empty())
+            display.setSession(&session);
+        
+        // Update the display continually (this will not actually refresh
+        // the screen unless some action has been performed). The frames
+        // are drawn on the render thread, which has the OpenGL context
+        // until it is stopped.
+        display.startRenderThread();
+        while(!display.isClosed())
+            display.update();
+        display.stopRenderThread();
+        
+        if(!recordSessionPath.empty() && !session.save(recordSessionPath))
+            std::cout << "Could not save the session to " << recordSessionPath << std::endl;
+    } // else
     
-    // Update the display continually (this will not actually refresh
-    // the screen unless some action has been performed).
-    while(!display.isClosed())
-        display.update();
+    // Save whatever is still being captured
+    frameCapture.finish();
+    frameCapture.report(std::cout);
     
+    delete hud;
+    delete lightClusters;
     return 0;
 }
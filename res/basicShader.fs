@@ -5,6 +5,17 @@
  Virtual Keyboard
  This is a fragment shader for modern OpenGL which implements
  the Phong Shading Model.
+ Optional features are turned on with defines:
+ NUM_LIGHTS (how many lights, 1 by default), ATTENUATION
+ (light fades with distance), SPECULAR (shiny highlights),
+ SRGB_FRAMEBUFFER (the framebuffer does the gamma
+ correction, so it is not done here), CLUSTERED_LIGHTS
+ (lights are read from texture buffers, and each fragment
+ only uses the lights in its cluster of the view), SHADOWS
+ (the first light is blocked where its shadow map says so),
+ DEPTH_ONLY (nothing is shaded, for drawing shadow maps), and
+ BAKED_LIGHTING (ambient and diffuse light come from the
+ vertices, so only the specular light is worked out here).
  
  @author Graeme Zinck
  @version 1.0 3/28/2018
@@ -13,8 +24,22 @@
 // Variable from CPU
 uniform vec3 cameraPosition;
 
+#ifdef CLUSTERED_LIGHTS
+// Three texels per light: position, intensities, and attenuation factors
+uniform samplerBuffer lightData;
+// Per cluster: where its lights start in clusterLights, and how many there are
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterLights;
+uniform vec3 ambientLight; // Ambient light of every light added together
+uniform vec2 clusterTileScale; // Clusters per pixel across and down the screen
+uniform vec3 clusterDepth; // Near plane, far plane, and depth slice scale
+#else
+#ifndef NUM_LIGHTS
+#define NUM_LIGHTS 1
+#endif
+
 // Structure which stores the properties of the light
-uniform struct Light
+struct Light
 {
     vec3 position;
     vec3 intensities; // color of light
@@ -22,58 +47,190 @@ uniform struct Light
     float attenuationFactorA;
     float attenuationFactorB;
     float attenuationFactorC;
-} light;
+};
+uniform Light lights[NUM_LIGHTS];
+#endif
 
 // Structure which stores the properties of the material
-uniform struct Material
+struct Material
 {
     vec3 ambient;
     vec3 diffuse;
     vec3 specular;
     float specularExponent;
-} material;
+};
+
+#ifdef KEY_BATCH
+// Each draw in a batch picks its material from the array
+uniform Material materials[NUM_BATCH_MATERIALS];
+flat in int fragMaterial;
+#define material materials[fragMaterial]
+#else
+uniform Material material;
+#endif
+
+#ifdef BAKED_LIGHTING
+in vec4 fragBakedLight; // Ambient and diffuse light, and the first light's diffuse coefficient
+#ifdef KEY_BATCH
+flat in int fragIsBaked; // Keys that have moved are lit here instead
+#endif
+#endif
 
 in vec3 fragPosition;
 in vec3 fragNormal;
 
 out vec4 outColor;
 
-void main()
+#ifdef SHADOWS
+// Depth cube maps around the first light: one with the keys at rest,
+// one with the keys being pressed
+uniform samplerCubeShadow staticShadowMap;
+uniform samplerCubeShadow dynamicShadowMap;
+uniform vec3 shadowLightPosition;
+uniform vec2 shadowDepth; // Near and far planes of the cube faces
+
+// How far to move the surface towards its normal before looking up
+// the shadow map, so that surfaces do not shadow themselves
+const float SHADOW_NORMAL_OFFSET = 0.05;
+
+// Gets how much of the first light reaches this fragment (0 to 1)
+float getShadow()
 {
-    // Create the vector for gamma correction, which is constant for CRT screens
-    // which modern monitors mimic.
-    vec3 gamma = vec3(1.0/2.2);
+    vec3 lightToSurface = fragPosition + fragNormal * SHADOW_NORMAL_OFFSET - shadowLightPosition;
     
-    // Calculates the vector from the fragment to the light source
-    vec3 surfaceToLight = normalize(light.position - fragPosition);
+    // The cube face's depth is the distance along its axis, projected
+    vec3 absolute = abs(lightToSurface);
+    float axisDistance = max(absolute.x, max(absolute.y, absolute.z));
+    float zNear = shadowDepth.x;
+    float zFar = shadowDepth.y;
+    float depth = (zFar + zNear) / (zFar - zNear) - 2.0 * zFar * zNear / ((zFar - zNear) * axisDistance);
+    depth = depth * 0.5 + 0.5;
     
-    // AMBIENT COMPONENT:
-    vec3 ambient = light.ambientCoefficient * light.intensities * material.ambient;
+    // In shadow if either layer blocks the light
+    return min(texture(staticShadowMap, vec4(lightToSurface, depth)), texture(dynamicShadowMap, vec4(lightToSurface, depth)));
+} // getShadow
+#endif
+
+// Gets the diffuse and specular light from one light (only the
+// specular light if the diffuse light is baked)
+vec3 shadeLight(vec3 lightPosition, vec3 intensities, vec3 attenuationFactor, vec3 surfaceToCamera, bool isBaked)
+{
+    // Calculates the vector from the fragment to the light source
+    vec3 surfaceToLight = normalize(lightPosition - fragPosition);
     
     // DIFFUSE COMPONENT:
     // Determines how bright it should be (i.e. cos theta, which is in [-1, 1]).
     // Clamps it to [0, 1] to avoid negative brightness of colours.
     float diffuseCoefficient = clamp( dot(fragNormal, surfaceToLight), 0.0, 1.0);
-    vec3 diffuse = diffuseCoefficient * light.intensities * material.diffuse;
+    vec3 diffuse = isBaked ? vec3(0.0) : diffuseCoefficient * intensities * material.diffuse;
     
     // SPECULAR COMPONENT:
+    vec3 specular = vec3(0.0);
+#ifdef SPECULAR
     // To avoid having shininess on the backside:
-    float specularCoefficient = 0.0;
     if(diffuseCoefficient > 0.0)
     {
         vec3 incidenceVector = -surfaceToLight;
         vec3 reflectionVector = reflect(incidenceVector, fragNormal);
-        // To get the camera's coordinates...
-        vec3 surfaceToCamera = normalize(cameraPosition - fragPosition);
         float cosAngle = max(0.0, dot(reflectionVector, surfaceToCamera));
-        specularCoefficient = pow(cosAngle, material.specularExponent);
+        float specularCoefficient = pow(cosAngle, material.specularExponent);
+        specular = specularCoefficient * intensities * material.specular;
     } // if
-    vec3 specular = specularCoefficient * light.intensities * material.specular;
+#endif
     
     // Getting attenuation
-    float distanceToLight = distance(light.position, fragPosition);
-    float attenuation = 1.0 / (light.attenuationFactorA * pow(distanceToLight, 2) + light.attenuationFactorB * distanceToLight + light.attenuationFactorC);
+#if defined(ATTENUATION) || defined(CLUSTERED_LIGHTS)
+    float distanceToLight = distance(lightPosition, fragPosition);
+    float attenuation = 1.0 / (attenuationFactor.x * distanceToLight * distanceToLight + attenuationFactor.y * distanceToLight + attenuationFactor.z);
+#else
+    float attenuation = 1.0;
+#endif
     
-    vec3 linearColor = ambient + attenuation * (diffuse + specular);
+    return attenuation * (diffuse + specular);
+} // shadeLight
+
+void main()
+{
+#ifdef DEPTH_ONLY
+    // Only the depth is needed
+    outColor = vec4(1.0);
+#else
+    // To get the camera's coordinates...
+    vec3 surfaceToCamera = normalize(cameraPosition - fragPosition);
+    
+#ifdef SHADOWS
+    float shadow = getShadow();
+#else
+    float shadow = 1.0;
+#endif
+    
+    // Whether the ambient and diffuse light were worked out on the CPU
+#if defined(BAKED_LIGHTING) && defined(KEY_BATCH)
+    bool isBaked = (fragIsBaked != 0);
+#elif defined(BAKED_LIGHTING)
+    bool isBaked = true;
+#else
+    bool isBaked = false;
+#endif
+    
+#ifdef CLUSTERED_LIGHTS
+    // AMBIENT COMPONENT (the same from every light, wherever it is):
+    vec3 linearColor = ambientLight * material.ambient;
+#ifdef BAKED_LIGHTING
+    if(isBaked)
+        linearColor = fragBakedLight.xyz + shadow * fragBakedLight.w * texelFetch(lightData, 1).xyz * material.diffuse;
+#endif
+    
+    // Find this fragment's cluster: its tile on the screen, and its
+    // depth slice (from the distance to the camera, undoing the
+    // projection of gl_FragCoord.z)
+    float zNear = clusterDepth.x;
+    float zFar = clusterDepth.y;
+    float ndcDepth = gl_FragCoord.z * 2.0 - 1.0;
+    float viewDepth = 2.0 * zNear * zFar / (zFar + zNear - ndcDepth * (zFar - zNear));
+    ivec3 cluster = ivec3(gl_FragCoord.xy * clusterTileScale, log(viewDepth / zNear) * clusterDepth.z);
+    cluster = clamp(cluster, ivec3(0), ivec3(CLUSTERS_X - 1, CLUSTERS_Y - 1, CLUSTERS_Z - 1));
+    uvec2 lightList = texelFetch(clusterGrid, (cluster.z * CLUSTERS_Y + cluster.y) * CLUSTERS_X + cluster.x).xy;
+    
+    // Only the lights which reach this cluster
+    for(uint i = 0u; i < lightList.y; i++)
+    {
+        int light = int(texelFetch(clusterLights, int(lightList.x + i)).x);
+        vec3 lightPosition = texelFetch(lightData, light * 3).xyz;
+        vec3 intensities = texelFetch(lightData, light * 3 + 1).xyz;
+        vec3 attenuationFactor = texelFetch(lightData, light * 3 + 2).xyz;
+        
+        // Only the first light casts shadows
+        float reaches = (light == 0) ? shadow : 1.0;
+        linearColor += reaches * shadeLight(lightPosition, intensities, attenuationFactor, surfaceToCamera, isBaked);
+    } // for
+#else
+    vec3 linearColor = vec3(0.0);
+#ifdef BAKED_LIGHTING
+    if(isBaked)
+        linearColor = fragBakedLight.xyz + shadow * fragBakedLight.w * lights[0].intensities * material.diffuse;
+#endif
+    for(int i = 0; i < NUM_LIGHTS; i++)
+    {
+        // AMBIENT COMPONENT:
+        vec3 ambient = isBaked ? vec3(0.0) : lights[i].ambientCoefficient * lights[i].intensities * material.ambient;
+        
+        vec3 attenuationFactor = vec3(lights[i].attenuationFactorA, lights[i].attenuationFactorB, lights[i].attenuationFactorC);
+        
+        // Only the first light casts shadows
+        float reaches = (i == 0) ? shadow : 1.0;
+        linearColor += ambient + reaches * shadeLight(lights[i].position, lights[i].intensities, attenuationFactor, surfaceToCamera, isBaked);
+    } // for
+#endif
+    
+#ifdef SRGB_FRAMEBUFFER
+    // The framebuffer converts to sRGB when the colour is written
+    outColor = vec4(linearColor, 1.0);
+#else
+    // Create the vector for gamma correction, which is constant for CRT screens
+    // which modern monitors mimic.
+    vec3 gamma = vec3(1.0/2.2);
     outColor = vec4(pow(linearColor, gamma), 1.0);
+#endif
+#endif
 } // main
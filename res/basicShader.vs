@@ -5,29 +5,73 @@
  Virtual Keyboard
  This is a vertex shader for modern OpenGL which uses model and
  view matrices to determine the vertex coordinates and normals.
+ With BAKED_LIGHTING, it also passes on the lighting that was
+ worked out on the CPU for keys at rest.
  
  @author Graeme Zinck
  @version 1.0 3/28/2018
  */
 
+// Draws in a batch only ever translate
+#if defined(KEY_BATCH) && !defined(TRANSLATION_ONLY)
+#define TRANSLATION_ONLY
+#endif
+
 // Variable set by CPU
-uniform mat4 modelMatrix;
 uniform mat4 viewMatrix;
 
 in vec3 position;
 in vec3 normal;
 
+#ifdef KEY_BATCH
+// Set per draw: xyz is the key's translation, w is its material
+// (plus NUM_BATCH_MATERIALS if the key is where it was baked)
+in vec4 drawData;
+flat out int fragMaterial;
+flat out int fragIsBaked;
+#else
+uniform mat4 modelMatrix;
+#endif
+
+#ifndef TRANSLATION_ONLY
+uniform mat3 normalMatrix; // Computed on the CPU only when the transform changes
+#endif
+
+#ifdef BAKED_LIGHTING
+// Ambient and diffuse light in xyz, and how much of the first
+// light's diffuse light reaches the vertex in w
+in vec4 bakedLight;
+out vec4 fragBakedLight;
+#endif
+
 out vec3 fragNormal;
 out vec3 fragPosition;
 
 void main()
 {
+#ifdef KEY_BATCH
+    // Keys only ever translate, so the model matrix is just the translation
+    mat4 modelMatrix = mat4(1.0);
+    modelMatrix[3] = vec4(drawData.xyz, 1.0);
+    int drawMaterial = int(drawData.w);
+    fragMaterial = drawMaterial % NUM_BATCH_MATERIALS;
+    fragIsBaked = (drawMaterial >= NUM_BATCH_MATERIALS) ? 1 : 0;
+#endif
+    
+#ifdef BAKED_LIGHTING
+    fragBakedLight = bakedLight;
+#endif
+    
     // Position of the fragment in world coordinates
     fragPosition = vec3(modelMatrix * vec4(position, 1.0));
     
-    // Calculate the normal in world coordinates and pass it to the vertex shader
-    mat3 normalMatrix = transpose(inverse(mat3(modelMatrix))); // To remove the scaling and translation
+    // Calculate the normal in world coordinates and pass it to the fragment shader
+    // (the normals are already normalized when the mesh is made)
+#ifdef TRANSLATION_ONLY
+    fragNormal = normal; // Translating doesn't change which way a normal points
+#else
     fragNormal = normalize(normalMatrix * normal);
+#endif
     
     // Get the position of the vertex by first multiplying by the model,
     // then the view matrix (reverse order)
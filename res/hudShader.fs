@@ -0,0 +1,24 @@
+#version 150
+
+/**
+ hudShader.fs
+ Virtual Keyboard
+ This is a fragment shader for the performance overlay. The
+ glyph atlas only says how much of each pixel is covered, so
+ it scales the opacity of the colour.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/23/2018
+*/
+
+uniform sampler2D glyphAtlas; // Texture unit 0
+
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+out vec4 outColor;
+
+void main()
+{
+    outColor = vec4(fragColor.rgb, fragColor.a * texture(glyphAtlas, fragTexCoord).r);
+} // main
@@ -0,0 +1,25 @@
+#version 150
+
+/**
+ hudShader.vs
+ Virtual Keyboard
+ This is a vertex shader for the performance overlay. The
+ vertices are already in normalized device coordinates.
+ 
+ @author Graeme Zinck
+ @version 1.0 4/23/2018
+ */
+
+in vec2 position;
+in vec2 texCoord;
+in vec4 color;
+
+out vec2 fragTexCoord;
+out vec4 fragColor;
+
+void main()
+{
+    fragTexCoord = texCoord;
+    fragColor = color;
+    gl_Position = vec4(position, 0.0, 1.0);
+} // main